@@ -0,0 +1,250 @@
+#!/usr/bin/env python
+
+"""
+liblvq binding micro-benchmarks
+
+Sweeps dimension, clusters count, batch size and thread count over
+the binding hot paths and prints results as JSON (one record per
+benchmark and configuration) to standard output.
+
+Latencies are measured per call (p50/p99 in microseconds); throughput
+is in samples (or training loops) per second.
+Conversion overhead is the share of time the binding spends converting
+Python sequences to native rows, compared to classifying the already
+converted rows (both on one thread).
+Training loop counts are the loops actually run (mini-batch training
+reports them); ml::lvq sequential training doesn't report its loop
+count, so only its time is given.
+"""
+
+from liblvq import lvq, rng_seed, set_num_threads, get_num_threads
+from liblvq import TrainingSet
+
+import argparse
+import json
+import platform
+import random
+import sys
+from array import array
+from time import perf_counter
+
+
+def matrix(rows, typecode = 'd'):
+    """2-D C-contiguous buffer of rows"""
+    flat = array(typecode, [x for row in rows for x in row])
+    return memoryview(flat).cast('B').cast(typecode, (len(rows), len(rows[0])))
+
+
+def percentile(sorted_values, p):
+    """Percentile of sorted values"""
+    if not sorted_values:
+        return 0.0
+
+    return sorted_values[min(len(sorted_values) - 1, int(p * len(sorted_values)))]
+
+
+def latencies(fn, args_seq):
+    """Per call latencies [us] and total time [s]"""
+    lat = []
+    start = perf_counter()
+
+    for args in args_seq:
+        t = perf_counter()
+        fn(*args)
+        lat.append((perf_counter() - t) * 1e6)
+
+    total = perf_counter() - start
+    lat.sort()
+
+    return lat, total
+
+
+def timed(fn, repeat = 3):
+    """Best time [s] of repeated calls"""
+    best = None
+
+    for _ in range(repeat):
+        t = perf_counter()
+        fn()
+        t = perf_counter() - t
+        best = t if best is None else min(best, t)
+
+    return best
+
+
+def data(dim, ccnt, size):
+    """Labelled samples (clusters around random centres)"""
+    centres = [[random.random() for _ in range(dim)] for _ in range(ccnt)]
+    samples = []
+
+    for i in range(size):
+        c = i % ccnt
+        samples.append((tuple(x + random.gauss(0.0, 0.05) for x in centres[c]), c))
+
+    return samples
+
+
+def model(dim, ccnt, samples, dtype):
+    """Model initialised by samples of each cluster"""
+    m = lvq(dim, ccnt) if dtype is None else lvq(dim, ccnt, dtype = dtype)
+
+    for vec, c in samples[:ccnt]:
+        m.set(vec, c)
+
+    return m
+
+
+def bench_calls(results, config, m, samples, calls):
+    """Per-sample call benchmarks"""
+    queries = [(vec,) for vec, _ in samples[:calls]]
+
+    for name, fn, args in (
+        ("classify",        m.classify,        queries),
+        ("classify_weight", m.classify_weight, queries),
+        ("classify_best",   m.classify_best,   [(vec, 3) for vec, in queries])):
+        lat, total = latencies(fn, args)
+
+        results.append(dict(config, bench = name, samples = len(args),
+            ops_per_s = len(args) / total,
+            p50_us = percentile(lat, 0.5), p99_us = percentile(lat, 0.99)))
+
+
+def bench_batch(results, config, m, samples, batch_sizes):
+    """Batch classification and conversion overhead"""
+    vecs = [vec for vec, _ in samples]
+
+    for batch in batch_sizes:
+        batch = min(batch, len(vecs))
+        mats  = [matrix(vecs[b:b + batch]) for b in range(0, len(vecs) - batch + 1, batch)]
+
+        lat, total = latencies(m.classify_batch, [(mat,) for mat in mats])
+        rows = batch * len(mats)
+
+        results.append(dict(config, bench = "classify_batch", batch = batch,
+            samples = rows, ops_per_s = rows / total,
+            p50_us = percentile(lat, 0.5), p99_us = percentile(lat, 0.99)))
+
+    # Conversion overhead: binding conversion of Python sequences
+    # vs. classification of the converted rows (one thread)
+    mat      = matrix(vecs)
+    seq_time = timed(lambda: [m.classify(vec) for vec in vecs])
+    mat_time = timed(lambda: m.classify_batch(mat))
+
+    threads = get_num_threads()
+    set_num_threads(1)
+    cnv_time = timed(lambda: TrainingSet(vecs))
+    one_time = timed(lambda: m.classify_batch(mat))
+    set_num_threads(threads)
+
+    results.append(dict(config, bench = "classify_conversion",
+        samples = len(vecs),
+        sequence_ops_per_s  = len(vecs) / seq_time,
+        matrix_ops_per_s    = len(vecs) / mat_time,
+        conversion_overhead = cnv_time / (cnv_time + one_time)))
+
+
+def bench_train_test(results, config, samples, dtype, loops):
+    """Training and testing benchmarks"""
+    dim, ccnt = config["dim"], config["clusters"]
+    vecs      = [vec for vec, _ in samples]
+    labels    = array('q', [c for _, c in samples])
+    mat       = matrix(vecs)
+
+    for name, mode, superv in (
+        ("train_supervised",   None,        True),
+        ("train_supervised",   "minibatch", True),
+        ("train_unsupervised", None,        False),
+        ("train_unsupervised", "minibatch", False)):
+        m    = model(dim, ccnt, samples, dtype)
+        tset = samples if superv else vecs
+        kwds = dict(conv_win = loops, max_div_cnt = loops, max_tlc = loops)
+
+        record = dict(config, bench = name, mode = mode or "sequential",
+            samples = len(tset), max_loops = loops)
+
+        if mode is None:
+            fn = m.train_supervised if superv else m.train_unsupervised
+            record.update(seconds = timed(lambda: fn(tset, **kwds), 1))
+        else:
+            # The job reports the loops run (training may converge early)
+            t   = perf_counter()
+            job = m.train_async(tset, supervised = superv, batch_size = 256,
+                **kwds)
+            job.wait()
+            t   = perf_counter() - t
+            log = job.progress()
+            run = log[-1][0] if log else 0
+
+            record.update(seconds = t, loops = run,
+                loops_per_s = run / t, ops_per_s = run * len(tset) / t)
+
+        results.append(record)
+
+    m = model(dim, ccnt, samples, dtype)
+
+    for name, seq_fn, mat_fn in (
+        ("test_classifier",
+            lambda: m.test_classifier(samples),
+            lambda: m.test_classifier(mat, labels)),
+        ("test_clustering",
+            lambda: m.test_clustering(vecs),
+            lambda: m.test_clustering(mat))):
+        seq_time = timed(seq_fn)
+        mat_time = timed(mat_fn)
+
+        results.append(dict(config, bench = name, samples = len(samples),
+            ops_per_s = len(samples) / mat_time,
+            sequence_ops_per_s = len(samples) / seq_time,
+            conversion_overhead = max(0.0, 1.0 - mat_time / seq_time)))
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description = __doc__.strip().split("\n")[0])
+    parser.add_argument("--dims",     type = int, nargs = "+", default = [8, 64])
+    parser.add_argument("--clusters", type = int, nargs = "+", default = [8, 64])
+    parser.add_argument("--batches",  type = int, nargs = "+", default = [1, 64, 1024])
+    parser.add_argument("--threads",  type = int, nargs = "+", default = [1, 4])
+    parser.add_argument("--dtypes",   nargs = "+", default = ["none", "float32"])
+    parser.add_argument("--samples",  type = int, default = 4096)
+    parser.add_argument("--calls",    type = int, default = 1000)
+    parser.add_argument("--loops",    type = int, default = 5)
+    parser.add_argument("--seed",     type = int, default = 1)
+    args = parser.parse_args(argv)
+
+    random.seed(args.seed)
+    rng_seed(args.seed)
+
+    default_threads = get_num_threads()
+    results = []
+
+    for dim in args.dims:
+        for ccnt in args.clusters:
+            samples = data(dim, ccnt, args.samples)
+
+            for threads in args.threads:
+                set_num_threads(threads)
+
+                for dtype in args.dtypes:
+                    dtype  = None if "none" == dtype else dtype
+                    config = dict(dim = dim, clusters = ccnt,
+                        threads = threads, dtype = dtype or "none")
+
+                    m = model(dim, ccnt, samples, dtype)
+
+                    bench_calls(results, config, m, samples, args.calls)
+                    bench_batch(results, config, m, samples, args.batches)
+                    bench_train_test(results, config, samples, dtype, args.loops)
+
+    set_num_threads(default_threads)
+
+    json.dump({
+        "version": 1,
+        "python":  platform.python_version(),
+        "machine": platform.machine(),
+        "results": results,
+    }, sys.stdout, indent = 1)
+    sys.stdout.write("\n")
+
+
+if __name__ == "__main__":
+    main(sys.argv[1:])
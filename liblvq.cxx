@@ -46,6 +46,34 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <deque>
+#include <exception>
+#include <new>
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <string>
+#include <cstdio>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
 
 
 /** Base numeric type */
@@ -63,1229 +91,11586 @@ typedef lvq_t::tset_classifier tset_classifier_t;
 /** Clustering training/test set */
 typedef lvq_t::tset_clustering tset_clustering_t;
 
-/** LVQ classifier statistics */
-typedef lvq_t::classifier_statistics lvq_classifier_stats_t;
+/**
+ *  \brief  Statistics image header
+ *
+ *  Statistics are serialised (in native byte order) as the header followed
+ *  by the counters: confusion matrix (C x C, uint64) of classifier
+ *  statistics or error sums (C, float64) and sample counts (C, uint64)
+ *  of clustering statistics.
+ */
+struct stats_header {
+    /** Statistics kinds */
+    enum {
+        CLASSIFIER = 1,  /**< Classifier statistics */
+        CLUSTERING = 2,  /**< Clustering statistics */
+    };
+
+    /** Constants */
+    enum {
+        VERSION         = 1,           /**< Format version  */
+        BYTE_ORDER_MARK = 0x01020304,  /**< Byte order mark */
+    };
+
+    char     magic[8];     /**< \c "LVQSTAT\0" */
+    uint32_t version;      /**< Format version   */
+    uint32_t byte_order;   /**< Byte order mark  */
+    uint32_t kind;         /**< Statistics kind  */
+    uint32_t reserved;     /**< Reserved (zero)  */
+    uint64_t ccnt;         /**< Clusters count   */
+
+    /** Magic */
+    static const char * magic_str() { return "LVQSTAT"; }
+
+    /** Constructor */
+    stats_header(uint32_t kind_, size_t ccnt_):
+        version(VERSION),
+        byte_order(BYTE_ORDER_MARK),
+        kind(kind_),
+        reserved(0),
+        ccnt(ccnt_)
+    {
+        ::memcpy(magic, magic_str(), 8);
+    }
 
-/** LVQ clustering statistics */
-typedef lvq_t::clustering_statistics lvq_clustering_stats_t;
+    /**
+     *  \brief  Read and check image header
+     *
+     *  \param  image  Image
+     *  \param  size   Image size
+     *  \param  kind_  Expected statistics kind
+     *
+     *  \return Header
+     */
+    static stats_header read(const char * image, size_t size, uint32_t kind_) {
+        stats_header header(0, 0);
+
+        if (size < sizeof(header))
+            throw std::logic_error("Invalid statistics image (truncated)");
+
+        ::memcpy(&header, image, sizeof(header));
+
+        if (0 != ::memcmp(header.magic, magic_str(), 8))
+            throw std::logic_error("Invalid statistics image (bad magic)");
+
+        if (BYTE_ORDER_MARK != header.byte_order)
+            throw std::logic_error("Invalid statistics image (byte order mismatch)");
+
+        if (VERSION != header.version)
+            throw std::logic_error("Invalid statistics image (unsupported version)");
+
+        if (kind_ != header.kind)
+            throw std::logic_error("Invalid statistics image (kind mismatch)");
+
+        // Counters must fit in the address space
+        if (header.ccnt > (uint64_t)(SIZE_MAX / 4 / sizeof(uint64_t)) ||
+            (CLASSIFIER == kind_ && 0 < header.ccnt &&
+             header.ccnt > (SIZE_MAX / 4 / sizeof(uint64_t)) / header.ccnt))
+        {
+            throw std::logic_error("Invalid statistics image (bad size)");
+        }
 
+        return header;
+    }
 
-/** LVQ Python object */
-typedef struct {
-    PyObject_HEAD
-    lvq_t * lvq;
-} lvqObject_t;
+};  // end of struct stats_header
 
-/** LVQ object access */
-#define python2lvq(self) \
-    ((reinterpret_cast<lvqObject_t *>(self))->lvq)
+static_assert(32 == sizeof(stats_header), "Unexpected stats_header size");
 
 
-/** LVQ classifier statistics Python object */
-typedef struct {
-    PyObject_HEAD
-    lvq_classifier_stats_t * lvq_stats;
-} lvqClassifierStatisticsObject_t;
+/**
+ *  \brief  Classifier statistics
+ *
+ *  Confusion matrix of (ground truth, classification) counts and measures
+ *  derived from it, just like \c ml::lvq::classifier_statistics.
+ *  Unlike the library statistics, instances may be merged, so that
+ *  test set shards may be evaluated in parallel.
+ */
+class classifier_stats {
+    private:
 
-/** LVQ classifier statistics object access */
-#define python2lvq_classifier_stats(self) \
-    ((reinterpret_cast<lvqClassifierStatisticsObject_t *>(self))->lvq_stats)
+    size_t                m_ccnt;     /**< Clusters count                 */
+    std::vector<uint64_t> m_cmatrix;  /**< Confusion matrix (row-major)   */
 
+    /** Check class */
+    void check_class(size_t c) const {
+        if (!(c < m_ccnt)) throw std::range_error("Invalid class");
+    }
 
-/** LVQ clustering statistics Python object */
-typedef struct {
-    PyObject_HEAD
-    lvq_clustering_stats_t * lvq_stats;
-} lvqClusteringStatisticsObject_t;
+    /** Column (classified as \c c) sum */
+    uint64_t col_sum(size_t c) const {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < m_ccnt; ++i) sum += m_cmatrix[i * m_ccnt + c];
+        return sum;
+    }
 
-/** LVQ clustering statistics object access */
-#define python2lvq_clustering_stats(self) \
-    ((reinterpret_cast<lvqClusteringStatisticsObject_t *>(self))->lvq_stats)
+    /** Row (ground truth \c c) sum */
+    uint64_t row_sum(size_t c) const {
+        uint64_t sum = 0;
+        for (size_t j = 0; j < m_ccnt; ++j) sum += m_cmatrix[c * m_ccnt + j];
+        return sum;
+    }
 
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  ccnt  Clusters count
+     */
+    classifier_stats(size_t ccnt): m_ccnt(ccnt), m_cmatrix(ccnt * ccnt, 0) {}
+
+    /** Clusters count */
+    size_t clusters() const { return m_ccnt; }
+
+    /** Confusion matrix (C x C, rows are ground truth classes) */
+    const uint64_t * cmatrix() const { return m_cmatrix.data(); }
+
+    /**
+     *  \brief  Add classification result
+     *
+     *  \param  truth   Ground truth class
+     *  \param  result  Classification result
+     */
+    void add(size_t truth, size_t result) {
+        if (!(truth < m_ccnt))
+            throw std::logic_error("Invalid cluster (out of range)");
+
+        check_class(result);
+        ++m_cmatrix[truth * m_ccnt + result];
+    }
 
-/**
- *  \brief  Exception-safe wrapper for bindings
- *
- *  \tparam R_t  Function return type
- *  \tparam F_t  Function
- *  \tparam A_t  Argument types
- *
- *  \param  xres  Return value in case of exception
- *  \param  fn    Function
- *  \param  args  Function arguments
- *
- *  \return \c fn(args) or \c eres in case of an exception
- */
-template <typename R_t, typename F_t, typename... A_t>
-R_t wrap_X(R_t xres, F_t fn, A_t... args) {
-    R_t res = xres;
+    /**
+     *  \brief  Merge statistics
+     *
+     *  \param  stats  Statistics of the same clusters count
+     */
+    void merge(const classifier_stats & stats) {
+        if (stats.m_ccnt != m_ccnt)
+            throw std::logic_error("Statistics clusters count mismatch");
+
+        for (size_t i = 0; i < m_cmatrix.size(); ++i)
+            m_cmatrix[i] += stats.m_cmatrix[i];
+    }
 
-    try {
-        res = fn(args...);
+    /** Accuracy (correct classifications share) */
+    double accuracy() const {
+        uint64_t total = 0, correct = 0;
+
+        for (size_t c = 0; c < m_ccnt; ++c) {
+            total   += row_sum(c);
+            correct += m_cmatrix[c * m_ccnt + c];
+        }
+
+        return total ? (double)correct / total : 0.0;
     }
-    catch (std::exception & x) {
-        PyErr_SetString(PyExc_RuntimeError, x.what());
+
+    /** Precision of class \c c */
+    double precision(size_t c) const {
+        check_class(c);
+        const uint64_t sum = col_sum(c);
+        return sum ? (double)m_cmatrix[c * m_ccnt + c] / sum : 0.0;
     }
-    catch (...) {
-        PyErr_SetString(PyExc_RuntimeError, "Unknown exception");
+
+    /** Recall of class \c c */
+    double recall(size_t c) const {
+        check_class(c);
+        const uint64_t sum = row_sum(c);
+        return sum ? (double)m_cmatrix[c * m_ccnt + c] / sum : 0.0;
     }
 
-    return res;
-}
+    /** F_beta score of class \c c */
+    double F(double beta, size_t c) const {
+        const double p  = precision(c);
+        const double r  = recall(c);
+        const double b2 = beta * beta;
 
-/**
- *  \brief  Exception-safe binding wrapper instance identifier
- *
- *  \param  binding  Binding function identifier
- */
-#define BINDING_IDENT(binding) binding ## __wrap_X
+        return 0.0 < p + r ? (1.0 + b2) * p * r / (b2 * p + r) : 0.0;
+    }
 
-/** Exception-safe binding wrapper instance */
-#define BINDING_INST(binding) \
-static PyObject * BINDING_IDENT(binding)(PyObject * self, PyObject * args) { \
-    return wrap_X((PyObject *)NULL, binding, self, args); \
-}
+    /** F_beta score (class average) */
+    double F(double beta) const {
+        double sum = 0.0;
+        for (size_t c = 0; c < m_ccnt; ++c) sum += F(beta, c);
+        return m_ccnt ? sum / m_ccnt : 0.0;
+    }
 
+    /** F_1 score of class \c c */
+    double F(size_t c) const { return F(1.0, c); }
+
+    /** F_1 score (class average) */
+    double F() const { return F(1.0); }
+
+    /**
+     *  \brief  Precisions, recalls and F_beta scores of all classes
+     *
+     *  Computed in a single pass over the confusion matrix.
+     *
+     *  \param  precision  Precisions  (output, C items or \c NULL)
+     *  \param  recall     Recalls     (output, C items or \c NULL)
+     *  \param  F          F_beta scores (output, C items or \c NULL)
+     *  \param  beta       F score beta
+     */
+    void measures(
+        double * precision,
+        double * recall,
+        double * F,
+        double   beta = 1.0) const
+    {
+        std::vector<uint64_t> col_sums(m_ccnt, 0), row_sums(m_ccnt, 0);
+
+        for (size_t i = 0; i < m_ccnt; ++i)
+            for (size_t j = 0; j < m_ccnt; ++j) {
+                const uint64_t n = m_cmatrix[i * m_ccnt + j];
+                row_sums[i] += n;
+                col_sums[j] += n;
+            }
+
+        const double b2 = beta * beta;
+
+        for (size_t c = 0; c < m_ccnt; ++c) {
+            const double tp = (double)m_cmatrix[c * m_ccnt + c];
+            const double p  = col_sums[c] ? tp / col_sums[c] : 0.0;
+            const double r  = row_sums[c] ? tp / row_sums[c] : 0.0;
+
+            if (NULL != precision) precision[c] = p;
+            if (NULL != recall)    recall[c]    = r;
+            if (NULL != F)
+                F[c] = 0.0 < p + r ? (1.0 + b2) * p * r / (b2 * p + r) : 0.0;
+        }
+    }
 
-/**
- *  \brief  Parse bindings arguments
- *
- *  \tparam A_t  Arguments type
- *
- *  \param  py_args  Python arguments
- *  \param  fstr     Argument types format string
- *  \param  args     Parsed arguments
- */
-template <typename... A_t>
-static void parse_args(PyObject * py_args, const char * fstr, A_t... args) {
-    PyArg_ParseTuple(py_args, fstr, args...);
+    /** Image size */
+    size_t image_size() const {
+        return sizeof(stats_header) + m_cmatrix.size() * sizeof(uint64_t);
+    }
 
-    if (NULL != PyErr_Occurred())
-        throw std::logic_error("Invalid arguments");
-}
+    /** Write image (of \c image_size) */
+    void image_write(char * image) const {
+        const stats_header header(stats_header::CLASSIFIER, m_ccnt);
+        ::memcpy(image, &header, sizeof(header));
+        ::memcpy(image + sizeof(header), m_cmatrix.data(),
+            m_cmatrix.size() * sizeof(uint64_t));
+    }
+
+    /**
+     *  \brief  Load image
+     *
+     *  \param  image  Image
+     *  \param  size   Image size
+     *
+     *  \return Statistics
+     */
+    static classifier_stats image_load(const char * image, size_t size) {
+        const stats_header header =
+            stats_header::read(image, size, stats_header::CLASSIFIER);
+
+        classifier_stats stats(header.ccnt);
+        if (stats.image_size() != size)
+            throw std::logic_error("Invalid statistics image (bad size)");
+
+        ::memcpy(stats.m_cmatrix.data(), image + sizeof(header),
+            stats.m_cmatrix.size() * sizeof(uint64_t));
+
+        return stats;
+    }
+
+};  // end of class classifier_stats
 
 
 /**
- *  \brief  Transform Python weight sequence to \c std::vector
- *
- *  \param  py_weight  Python weight sequence
+ *  \brief  Clustering statistics
  *
- *  \return Weight vector
+ *  Squared distances of samples to their best matching units,
+ *  per cluster, just like \c ml::lvq::clustering_statistics.
+ *  Instances may be merged.
  */
-static std::vector<double> python2weight(PyObject * py_weight) {
-    Py_ssize_t weight_size = PyObject_Size(py_weight);
-    if (-1 == weight_size)
-        throw std::logic_error("Invalid weights (can't get size)");
+class clustering_stats {
+    private:
+
+    std::vector<double>   m_error;  /**< Squared distance sums per cluster */
+    std::vector<uint64_t> m_count;  /**< Sample counts per cluster         */
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  ccnt  Clusters count
+     */
+    clustering_stats(size_t ccnt): m_error(ccnt, 0.0), m_count(ccnt, 0) {}
+
+    /** Clusters count */
+    size_t clusters() const { return m_error.size(); }
+
+    /** Squared distance sums per cluster */
+    const double * errors() const { return m_error.data(); }
+
+    /** Sample counts per cluster */
+    const uint64_t * counts() const { return m_count.data(); }
+
+    /**
+     *  \brief  Add clustering result
+     *
+     *  \param  c   Cluster (BMU)
+     *  \param  d2  Squared distance of the sample to the BMU
+     */
+    void add(size_t c, double d2) {
+        m_error.at(c) += d2;
+        ++m_count[c];
+    }
 
-    PyObject * py_iter = PyObject_GetIter(py_weight);
-    if (NULL == py_iter)
-        throw std::logic_error("Invalid weights (should be iterable)");
+    /**
+     *  \brief  Merge statistics
+     *
+     *  \param  stats  Statistics of the same clusters count
+     */
+    void merge(const clustering_stats & stats) {
+        if (stats.clusters() != clusters())
+            throw std::logic_error("Statistics clusters count mismatch");
+
+        for (size_t c = 0; c < m_error.size(); ++c) {
+            m_error[c] += stats.m_error[c];
+            m_count[c] += stats.m_count[c];
+        }
+    }
 
-    std::vector<double> weight;
-    weight.reserve(weight_size);
+    /** Average error */
+    double avg_error() const {
+        double   sum   = 0.0;
+        uint64_t count = 0;
 
-    PyObject * py_w;
-    while (NULL != (py_w = PyIter_Next(py_iter))) {
-        weight.push_back(PyFloat_AsDouble(py_w));
+        for (size_t c = 0; c < m_error.size(); ++c) {
+            sum   += m_error[c];
+            count += m_count[c];
+        }
 
-        if (NULL != PyErr_Occurred())
-            throw std::logic_error("Invalid weight (should be double)");
+        return count ? sum / count : 0.0;
+    }
 
-        Py_DECREF(py_w);
+    /** Average error of cluster \c c */
+    double avg_error(size_t c) const {
+        if (!(c < m_error.size())) throw std::range_error("Invalid cluster");
+        return m_count[c] ? m_error[c] / m_count[c] : 0.0;
     }
 
-    Py_DECREF(py_iter);
+    /** Average errors of all clusters (C items) */
+    void avg_errors(double * avg_error) const {
+        for (size_t c = 0; c < m_error.size(); ++c)
+            avg_error[c] = m_count[c] ? m_error[c] / m_count[c] : 0.0;
+    }
 
-    return weight;
-}
+    /** Image size */
+    size_t image_size() const {
+        return sizeof(stats_header) +
+            m_error.size() * (sizeof(double) + sizeof(uint64_t));
+    }
 
+    /** Write image (of \c image_size) */
+    void image_write(char * image) const {
+        const stats_header header(stats_header::CLUSTERING, clusters());
+        ::memcpy(image, &header, sizeof(header));
+        image += sizeof(header);
 
-/**
- *  \brief  Transform weight std::vector to Python tuple
- *
- *  \param  weight  Weight vector
- *
- *  \return Python weight tuple
- */
-static PyObject * weight2python(const std::vector<double> & weight) {
-    size_t     weight_size = weight.size();
-    PyObject * py_weight   = PyTuple_New(weight_size);
+        ::memcpy(image, m_error.data(), m_error.size() * sizeof(double));
+        image += m_error.size() * sizeof(double);
 
-    for (size_t i = 0; i < weight_size; ++i) {
-        PyTuple_SetItem(py_weight, i, Py_BuildValue("d", weight[i]));
+        ::memcpy(image, m_count.data(), m_count.size() * sizeof(uint64_t));
     }
 
-    return py_weight;
-}
+    /**
+     *  \brief  Load image
+     *
+     *  \param  image  Image
+     *  \param  size   Image size
+     *
+     *  \return Statistics
+     */
+    static clustering_stats image_load(const char * image, size_t size) {
+        const stats_header header =
+            stats_header::read(image, size, stats_header::CLUSTERING);
+
+        clustering_stats stats(header.ccnt);
+        if (stats.image_size() != size)
+            throw std::logic_error("Invalid statistics image (bad size)");
+
+        image += sizeof(header);
+
+        ::memcpy(stats.m_error.data(), image, header.ccnt * sizeof(double));
+        image += header.ccnt * sizeof(double);
+
+        ::memcpy(stats.m_count.data(), image, header.ccnt * sizeof(uint64_t));
+
+        return stats;
+    }
+
+};  // end of class clustering_stats
+
+/** LVQ classifier statistics */
+typedef classifier_stats lvq_classifier_stats_t;
+
+/** LVQ clustering statistics */
+typedef clustering_stats lvq_clustering_stats_t;
 
 
 /**
- *  \brief  Transform Python tuple of numbers to \c lvq_t::input_t
- *
- *  \param  py_input  Python tuple of numbers
+ *  \brief  Reader/writer lock
  *
- *  \return \c lvq_t::input_t
+ *  Any number of readers or a single writer may hold the lock.
+ *  Writers are preferred (pending writer blocks new readers)
+ *  so that training isn't starved by a steady classification load.
  */
-static lvq_t::input_t python2input(PyObject * py_input) {
-    Py_ssize_t input_size = PyObject_Size(py_input);
-    if (-1 == input_size)
-        throw std::logic_error("Invalid input (can't get size)");
+class rwlock {
+    private:
 
-    PyObject * py_iter = PyObject_GetIter(py_input);
-    if (NULL == py_iter)
-        throw std::logic_error("Invalid input (should be iterable)");
+    std::mutex              m_mutex;    /**< Lock state mutex        */
+    std::condition_variable m_cond;     /**< Lock state change       */
+    unsigned                m_readers;  /**< Active readers          */
+    unsigned                m_wpend;    /**< Pending writers         */
+    bool                    m_writer;   /**< Writer holds the lock   */
 
-    lvq_t::input_t input(input_size);
+    public:
 
-    PyObject * py_x;
-    for (size_t i = 0; NULL != (py_x = PyIter_Next(py_iter)); ++i) {
-        input[i] = Py_None == py_x
-                 ? lvq_t::base_t::undef
-                 : lvq_t::base_t(PyFloat_AsDouble(py_x));
+    /** Constructor */
+    rwlock(): m_readers(0), m_wpend(0), m_writer(false) {}
 
-        if (NULL != PyErr_Occurred())
-            throw std::logic_error("Invalid input value");
+    /** Acquire shared (read) access */
+    void lock_shared() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, [this]() { return !m_writer && 0 == m_wpend; });
+        ++m_readers;
+    }
 
-        Py_DECREF(py_x);
+    /** Release shared (read) access */
+    void unlock_shared() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (0 == --m_readers) m_cond.notify_all();
     }
 
-    Py_DECREF(py_iter);
+    /** Acquire exclusive (write) access */
+    void lock() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        ++m_wpend;
+        m_cond.wait(lock, [this]() { return !m_writer && 0 == m_readers; });
+        --m_wpend;
+        m_writer = true;
+    }
 
-    return input;
-}
+    /** Release exclusive (write) access */
+    void unlock() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_writer = false;
+        m_cond.notify_all();
+    }
+
+};  // end of class rwlock
 
 
 /**
- *  \brief  Transform \c lvq_t::input_t to Python tuple of numbers
- *
- *  \param  input  \c lvq_t::input_t instance
+ *  \brief  GIL release guard
  *
- *  \return Python tuple
+ *  Releases the GIL for the guard lifetime.
+ *  No Python API may be used while the guard exists.
  */
-static PyObject * input2python(const lvq_t::input_t & input) {
-    size_t     input_rank = input.rank();
-    PyObject * py_input   = PyTuple_New(input_rank);
+class gil_release {
+    private:
 
-    for (size_t i = 0; i < input_rank; ++i) {
-        PyObject * x;
+    PyThreadState * m_state;  /**< Saved thread state */
 
-        if (input[i].is_defined())
-            x = Py_BuildValue("d", input[i]);
-        else {
-            Py_INCREF(Py_None);
-            x = Py_None;
-        }
+    public:
 
-        PyTuple_SetItem(py_input, i, x);
-    }
+    /** Constructor (releases GIL) */
+    gil_release(): m_state(PyEval_SaveThread()) {}
 
-    return py_input;
-}
+    /** Destructor (re-acquires GIL) */
+    ~gil_release() { PyEval_RestoreThread(m_state); }
 
+    private:
 
-/**
- *  \brief  Transform [cluster, weight] pairs vector to Python representation
- *
- *  \param  cw_vec  [cluster, weight] pairs vector
- *
- *  \return Python list of [cluster, weight] tuples
- */
-static PyObject * cw_vec2python(const std::vector<lvq_t::cw_t> & cw_vec) {
-    size_t     cw_vec_size = cw_vec.size();
-    PyObject * py_cw_tuple = PyTuple_New(cw_vec_size);
+    gil_release(const gil_release &);
+    gil_release & operator = (const gil_release &);
 
-    for (size_t i = 0; i < cw_vec_size; ++i) {
-        PyTuple_SetItem(py_cw_tuple, i,
-            Py_BuildValue("(nd)", cw_vec[i].first, cw_vec[i].second));
-    }
+};  // end of class gil_release
 
-    return py_cw_tuple;
-}
+
+/** \cond */
+class dense_codebook;
+class classify_batcher;
+class tset_arena;
+class lvq_snapshot;
+/** \endcond */
 
 
 /**
- *  \brief  Transform Python training/test set to \c lvq_t::tset_classifier_t set
- *
- *  The Python training set is an iterable containing (input, cluster) tuples.
- *
- *  \param  py_set  Python iterable of number tuples
+ *  \brief  Deferred snapshot publisher
  *
- *  \return Training set
+ *  Thread publishing snapshot of the last coalesced modification
+ *  once due (see \ref snapshot_cell), so that it doesn't stay stale
+ *  until the next modification.
+ *  The thread doesn't exist in forked child processes; publishers
+ *  inherited from the parent are abandoned (like \ref classify_batcher).
  */
-static tset_classifier_t python2tset_classifier(PyObject * py_set) {
-    Py_ssize_t set_size = PyObject_Size(py_set);
-    if (-1 == set_size)
-        throw std::logic_error("Invalid training set (can't get size)");
+class snapshot_publisher {
+    public:
 
-    PyObject * py_iter = PyObject_GetIter(py_set);
-    if (NULL == py_iter)
-        throw std::logic_error("Invalid training set (should be iterable)");
+    /** Publication function (called without the GIL) */
+    typedef std::function<void()> fn_t;
 
-    tset_classifier_t set;
+    /** Time point */
+    typedef std::chrono::steady_clock::time_point time_point;
 
-    PyObject * py_ic;
-    while (NULL != (py_ic = PyIter_Next(py_iter))) {
-        if (!PyTuple_Check(py_ic))
-            throw std::logic_error(
-                "Invalid training set ((input, cluster) tuples expected");
+    private:
 
-        PyObject * py_input   = PyTuple_GetItem(py_ic, 0);
-        PyObject * py_cluster = PyTuple_GetItem(py_ic, 1);
+    const fn_t              m_publish;  /**< Publication             */
+    std::mutex              m_mutex;    /**< State mutex             */
+    std::condition_variable m_cond;     /**< State change            */
+    bool                    m_pending;  /**< Publication scheduled   */
+    time_point              m_due;      /**< Scheduled time          */
+    bool                    m_stop;     /**< Stop request            */
+    std::thread             m_thread;   /**< Publisher thread        */
+    const pid_t             m_pid;      /**< Creating process        */
 
-        const lvq_t::input_t input = python2input(py_input);
+    /** Publisher thread routine */
+    void run() {
+        std::unique_lock<std::mutex> lock(m_mutex);
 
-        if (!PyLong_Check(py_cluster))
-            throw std::logic_error("Invalid cluster (integer expected)");
+        while (!m_stop) {
+            if (!m_pending) {
+                m_cond.wait(lock);
+                continue;
+            }
 
-        Py_ssize_t cluster = PyLong_AsSsize_t(py_cluster);
+            if (std::cv_status::timeout != m_cond.wait_until(lock, m_due))
+                continue;  // stopped (or spurious wake-up)
 
-        if (0 > cluster)
-            throw std::logic_error("Invalid cluster (must be >= 0)");
+            m_pending = false;
+            lock.unlock();
 
-        set.emplace_back(input, cluster);
+            try { m_publish(); }
+            catch (...) {}  // the next modification publishes
 
-        Py_DECREF(py_ic);
+            lock.lock();
+        }
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  publish  Publication function
+     */
+    snapshot_publisher(const fn_t & publish):
+        m_publish(publish),
+        m_pending(false),
+        m_stop(false),
+        m_pid(::getpid())
+    {
+        m_thread = std::thread(&snapshot_publisher::run, this);
     }
 
-    Py_DECREF(py_iter);
+    /** Created by another (parent) process */
+    bool forked() const { return m_pid != ::getpid(); }
+
+    /**
+     *  \brief  Schedule publication
+     *
+     *  Publication already scheduled isn't postponed.
+     *
+     *  \param  due  Publication time
+     */
+    void schedule(const time_point & due) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_pending) return;
+
+            m_pending = true;
+            m_due     = due;
+        }
+        m_cond.notify_one();
+    }
+
+    /** Destructor (scheduled publication is dropped) */
+    ~snapshot_publisher() {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cond.notify_one();
+
+        m_thread.join();
+    }
+
+};  // end of class snapshot_publisher
+
+
+/**
+ *  \brief  Model snapshot publication
+ *
+ *  Holds the latest published \ref lvq_snapshot, the model version
+ *  (incremented by writers modifying prototypes, see \ref lvq_writer)
+ *  and the search tuning generation (incremented by writers changing
+ *  the index or pruning state only).
+ *  The snapshot pointer is loaded and stored atomically so that readers
+ *  don't lock; snapshots of older than the current version (or tuning
+ *  generation) are stale.
+ *  Snapshots are published by writers only (see \ref snapshot_update).
+ *  They are copies of the model; snapshots of models of up to
+ *  \c SYNC_SIZE prototype values are published by each writer, larger
+ *  ones at most once per \c INTERVAL (and at the end of bulk training),
+ *  so frequent small modifications don't cause a copy each.
+ *  The last of coalesced modifications is published by the deferred
+ *  publisher (see \ref snapshot_publisher).
+ */
+class snapshot_cell {
+    public:
+
+    /** Min. publication interval [ns] */
+    static const int64_t INTERVAL = 100000000;
+
+    /** Max. size of models published by each writer [values] */
+    static const size_t SYNC_SIZE = 131072;
+
+    private:
+
+    std::shared_ptr<const lvq_snapshot> m_snapshot;  /**< Latest (or empty)  */
+    std::atomic<uint64_t>               m_version;   /**< Model version      */
+    std::atomic<uint64_t>               m_tuning;    /**< Tuning generation  */
+    std::atomic<int64_t>                m_published; /**< Publication time   */
+    std::atomic<size_t>                 m_size;      /**< Published size     */
+    std::mutex                          m_mutex;     /**< Publication mutex  */
+    snapshot_publisher *                m_publisher; /**< Deferred (or NULL) */
+
+    /** Monotonic time [ns] */
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    public:
+
+    /** Constructor */
+    snapshot_cell():
+        m_version(1),
+        m_tuning(1),
+        m_published(now() - INTERVAL),
+        m_size(0),
+        m_publisher(NULL)
+    {}
+
+    /** Destructor (publisher of parent process is leaked) */
+    ~snapshot_cell() {
+        if (NULL != m_publisher && !m_publisher->forked())
+            delete m_publisher;
+    }
+
+    /** Model version */
+    uint64_t version() const { return m_version.load(); }
+
+    /** Model modified (published snapshot is stale) */
+    void modified() { ++m_version; }
+
+    /** Search tuning generation */
+    uint64_t tuning() const { return m_tuning.load(); }
+
+    /** Index or pruning state changed (published snapshot is stale) */
+    void tuned() { ++m_tuning; }
+
+    /** Latest published snapshot */
+    std::shared_ptr<const lvq_snapshot> load() const {
+        return std::atomic_load(&m_snapshot);
+    }
+
+    /**
+     *  \brief  Publish snapshot (with the publication mutex locked)
+     *
+     *  \param  snapshot  Snapshot
+     *  \param  size      Snapshot size (prototype values copied)
+     */
+    void store(
+        const std::shared_ptr<const lvq_snapshot> & snapshot,
+        size_t                                      size)
+    {
+        std::atomic_store(&m_snapshot, snapshot);
+        m_published = now();
+        m_size      = size;
+    }
+
+    /**
+     *  \brief  Publication is due
+     *
+     *  It is if the published snapshot is small (see \c SYNC_SIZE)
+     *  or at least \c INTERVAL old.
+     */
+    bool due() const {
+        return m_size <= SYNC_SIZE || now() - m_published >= INTERVAL;
+    }
+
+    /**
+     *  \brief  Defer publication until due
+     *
+     *  Must be called with the object locked for writing.
+     *
+     *  \param  publish  Publication function (used by the first call)
+     */
+    void defer(const snapshot_publisher::fn_t & publish) {
+        if (NULL == m_publisher || m_publisher->forked())
+            m_publisher = new snapshot_publisher(publish);  // inherited is leaked
+
+        m_publisher->schedule(snapshot_publisher::time_point(
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::nanoseconds(m_published + INTERVAL))));
+    }
+
+    /** Publication mutex */
+    std::mutex & mutex() { return m_mutex; }
+
+};  // end of class snapshot_cell
+
+/**
+ *  \brief  LVQ Python object
+ *
+ *  Models created with \c dtype also keep a dense copy of prototypes
+ *  (see \ref dense_codebook) used for classification.
+ *  Models loaded by \c load_mmap only have the dense prototypes;
+ *  the \c ml::lvq instance is built once needed (see \ref python2lvq).
+ */
+typedef struct {
+    PyObject_HEAD
+    lvq_t            * lvq;          /**< Model (built lazily, see below)  */
+    rwlock           * lock;
+    dense_codebook   * dense;        /**< Dense prototypes (or NULL)       */
+    bool               allow_undef;  /**< Undefined input values allowed   */
+    classify_batcher * batcher;      /**< Async. classification (or NULL)  */
+    Py_ssize_t         exports;      /**< Prototype buffer exports         */
+    snapshot_cell    * snapshots;    /**< Published snapshots              */
+} lvqObject_t;
+
+/** \cond */
+static lvq_t * python2lvq(PyObject * self);
+static std::shared_ptr<const lvq_snapshot> snapshot_publish(PyObject * self);
+static void snapshot_update(PyObject * self);
+/** \endcond */
+
+/** LVQ object lock access */
+#define python2lvq_lock(self) \
+    (*(reinterpret_cast<lvqObject_t *>(self))->lock)
+
+/** LVQ object snapshots access */
+#define python2lvq_snapshots(self) \
+    (*(reinterpret_cast<lvqObject_t *>(self))->snapshots)
+
+
+/**
+ *  \brief  Shared access to LVQ object
+ *
+ *  Releases the GIL and holds the object lock for reading.
+ *  Any number of readers run concurrently.
+ *  Classification and testing don't lock, they use model snapshots
+ *  (see \ref snapshot_acquire).
+ */
+class lvq_reader {
+    private:
+
+    gil_release m_nogil;  /**< GIL released  */
+    rwlock &    m_lock;   /**< Object lock   */
+
+    public:
+
+    /** Constructor */
+    lvq_reader(PyObject * self): m_lock(python2lvq_lock(self)) {
+        m_lock.lock_shared();
+    }
+
+    /** Destructor */
+    ~lvq_reader() { m_lock.unlock_shared(); }
+
+};  // end of class lvq_reader
+
+
+/**
+ *  \brief  Exclusive access to LVQ object
+ *
+ *  Releases the GIL and holds the object lock for writing.
+ *  Modifications (\c set, training) are serialised.
+ *  The published snapshot becomes stale (see \ref snapshot_cell);
+ *  the model version is only incremented if prototypes are modified,
+ *  so that e.g. index tuning doesn't fail the store of concurrent
+ *  asynchronous training.
+ *  The modified model is published once the writer is done
+ *  (see \ref snapshot_update).
+ */
+class lvq_writer {
+    private:
+
+    gil_release m_nogil;  /**< GIL released  */
+    PyObject *  m_self;   /**< Python LVQ    */
+    rwlock &    m_lock;   /**< Object lock   */
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  self    Python LVQ object
+     *  \param  tuning  Only the index or pruning state is changed
+     */
+    lvq_writer(PyObject * self, bool tuning = false):
+        m_self(self),
+        m_lock(python2lvq_lock(self))
+    {
+        m_lock.lock();
+
+        snapshot_cell & snapshots = python2lvq_snapshots(self);
+
+        if (tuning)
+            snapshots.tuned();
+        else
+            snapshots.modified();
+    }
+
+    /** Destructor (publishes the model) */
+    ~lvq_writer() {
+        snapshot_update(m_self);
+        m_lock.unlock();
+    }
+
+};  // end of class lvq_writer
+
+
+/**
+ *  \brief  Worker thread pool
+ *
+ *  \c parallel_for splits an index range to chunks; each participant
+ *  (the calling thread and the pool workers that join the job) owns
+ *  a contiguous share of the chunks and, having finished it, steals
+ *  chunks from the other participants' shares.
+ *  Multiple jobs (from multiple threads) may run at the same time.
+ *
+ *  Jobs run without the GIL; they must not use Python API.
+ */
+class thread_pool {
+    public:
+
+    /** Job function (processes index range [begin, end)) */
+    typedef std::function<void(size_t, size_t)> fn_t;
+
+    private:
+
+    /** Participant chunks share */
+    struct share {
+        std::atomic<size_t> next;  /**< Next chunk  */
+        size_t              end;   /**< Share end   */
+    };  // end of struct share
+
+    /** Job */
+    struct job {
+        const fn_t &             fn;       /**< Job function          */
+        const size_t             size;     /**< Index range size      */
+        const size_t             chunk;    /**< Chunk size            */
+        std::vector<share>       shares;   /**< Participants' shares  */
+        std::atomic<size_t>      joined;   /**< Participants joined   */
+        size_t                   helpers;  /**< Helpers joined        */
+        size_t                   active;   /**< Active helpers        */
+        std::atomic<bool>        failed;   /**< Job failed            */
+        std::exception_ptr       error;    /**< First failure         */
+        std::mutex               emutex;   /**< Failure mutex         */
+
+        job(const fn_t & fn_, size_t size_, size_t chunk_, size_t pcnt):
+            fn(fn_), size(size_), chunk(chunk_), shares(pcnt),
+            joined(0), helpers(0), active(0), failed(false)
+        {
+            const size_t chunks = (size + chunk - 1) / chunk;
+
+            for (size_t p = 0; p < pcnt; ++p) {
+                shares[p].next = chunks *  p      / pcnt;
+                shares[p].end  = chunks * (p + 1) / pcnt;
+            }
+        }
+
+        /** Process chunks of a share */
+        void process(share & sh) {
+            for (;;) {
+                const size_t c = sh.next.fetch_add(1);
+                if (c >= sh.end || failed) return;
+
+                const size_t begin = c * chunk;
+                fn(begin, std::min(begin + chunk, size));
+            }
+        }
+
+        /** Participate (own share first, then steal) */
+        void run() {
+            const size_t pcnt = shares.size();
+            const size_t p    = joined.fetch_add(1) % pcnt;
+
+            try {
+                for (size_t i = 0; i < pcnt; ++i)
+                    process(shares[(p + i) % pcnt]);
+            }
+            catch (...) {
+                std::unique_lock<std::mutex> lock(emutex);
+                if (!failed) error = std::current_exception();
+                failed = true;
+            }
+        }
+    };  // end of struct job
+
+    std::vector<std::thread> m_workers;   /**< Worker threads      */
+    std::deque<job *>        m_jobs;      /**< Jobs open for help  */
+    std::mutex               m_mutex;     /**< Pool mutex          */
+    std::condition_variable  m_wakeup;    /**< Worker wake-up      */
+    std::condition_variable  m_done;      /**< Helper finished     */
+    bool                     m_shutdown;  /**< Shutdown flag       */
+
+    /** Worker thread routine */
+    void worker() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        for (;;) {
+            m_wakeup.wait(lock, [this]() {
+                return m_shutdown || !m_jobs.empty();
+            });
+
+            if (m_shutdown) return;
+
+            job * j = m_jobs.front();
+            ++j->active;
+
+            // All shares have their owner, stop advertising the job
+            if (++j->helpers + 1 >= j->shares.size())
+                m_jobs.pop_front();
+
+            lock.unlock();
+            j->run();
+            lock.lock();
+
+            --j->active;
+            m_done.notify_all();
+        }
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  threads  Concurrency (including the calling thread)
+     */
+    thread_pool(size_t threads): m_shutdown(false) {
+        for (size_t i = 1; i < threads; ++i)
+            m_workers.emplace_back(&thread_pool::worker, this);
+    }
+
+    /** Concurrency (including the calling thread) */
+    size_t concurrency() const { return m_workers.size() + 1; }
+
+    /**
+     *  \brief  Run job in parallel
+     *
+     *  Exception thrown by the job function is re-thrown
+     *  (remaining chunks are abandoned).
+     *
+     *  \param  size   Index range size
+     *  \param  chunk  Chunk size
+     *  \param  fn     Job function
+     */
+    void parallel_for(size_t size, size_t chunk, const fn_t & fn) {
+        if (0 == size) return;
+
+        if (0 == chunk) chunk = 1;
+
+        // Sequential fallback
+        if (m_workers.empty() || size <= chunk) {
+            fn(0, size);
+            return;
+        }
+
+        const size_t chunks = (size + chunk - 1) / chunk;
+        job j(fn, size, chunk, std::min(concurrency(), chunks));
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobs.push_back(&j);
+        }
+        m_wakeup.notify_all();
+
+        j.run();
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            auto pos = std::find(m_jobs.begin(), m_jobs.end(), &j);
+            if (m_jobs.end() != pos) m_jobs.erase(pos);
+
+            m_done.wait(lock, [&j]() { return 0 == j.active; });
+        }
+
+        if (j.error) std::rethrow_exception(j.error);
+    }
+
+    /**
+     *  \brief  Suggested chunk size
+     *
+     *  Aims at several chunks per participant (for load balancing)
+     *  while keeping chunks large enough to amortise scheduling.
+     *
+     *  \param  size  Index range size
+     *  \param  min   Minimal chunk size
+     */
+    size_t chunk(size_t size, size_t min = 16) const {
+        return std::max(min, size / (8 * concurrency()));
+    }
+
+    /** Destructor (joins workers) */
+    ~thread_pool() {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_shutdown = true;
+        }
+        m_wakeup.notify_all();
+
+        for (auto & worker: m_workers) worker.join();
+    }
+
+    private:
+
+    thread_pool(const thread_pool &);
+    thread_pool & operator = (const thread_pool &);
+
+};  // end of class thread_pool
+
+
+/** Module thread pool */
+static std::shared_ptr<thread_pool> pool_inst;
+
+/** Module thread pool creator PID (pool doesn't survive fork) */
+static pid_t pool_pid = 0;
+
+/** Module thread pool concurrency (0 means default) */
+static size_t pool_threads = 0;
+
+/** Module thread pool mutex */
+static std::mutex pool_mutex;
+
+
+/**
+ *  \brief  Default module thread pool concurrency
+ *
+ *  Taken from \c LIBLVQ_NUM_THREADS environment variable if set,
+ *  hardware concurrency otherwise.
+ */
+static size_t pool_default_threads() {
+    const char * env = ::getenv("LIBLVQ_NUM_THREADS");
+    if (NULL != env) {
+        long threads = ::strtol(env, NULL, 10);
+        if (0 < threads) return threads;
+    }
+
+    size_t threads = std::thread::hardware_concurrency();
+    return 0 < threads ? threads : 1;
+}
+
+
+/**
+ *  \brief  Abandon module thread pool inherited from parent process
+ *
+ *  Worker threads of the parent don't exist in a forked child;
+ *  the inherited instance is leaked as it can't be joined.
+ *  Must be called with \c pool_mutex locked.
+ */
+static void pool_check_fork() {
+    if (pool_pid == ::getpid()) return;
+
+    if (pool_inst) new std::shared_ptr<thread_pool>(pool_inst);
+
+    pool_inst.reset();
+    pool_pid = ::getpid();
+}
+
+
+/**
+ *  \brief  Module thread pool
+ *
+ *  Created on demand; re-created in forked child processes.
+ *  Callers keep the instance alive for the job duration,
+ *  so the pool may be re-sized concurrently.
+ */
+static std::shared_ptr<thread_pool> get_pool() {
+    std::unique_lock<std::mutex> lock(pool_mutex);
+
+    pool_check_fork();
+
+    if (!pool_inst) {
+        if (0 == pool_threads) pool_threads = pool_default_threads();
+        pool_inst = std::make_shared<thread_pool>(pool_threads);
+    }
+
+    return pool_inst;
+}
+
+
+/**
+ *  \brief  Set module thread pool concurrency
+ *
+ *  \param  threads  Concurrency (0 means default)
+ */
+static void set_pool_threads(size_t threads) {
+    std::shared_ptr<thread_pool> old;  // joined outside the lock
+
+    std::unique_lock<std::mutex> lock(pool_mutex);
+
+    pool_check_fork();
+
+    pool_threads = 0 < threads ? threads : pool_default_threads();
+
+    old.swap(pool_inst);
+    lock.unlock();
+}
+
+
+/** Module RNG (seeded by \c rng_seed) */
+static std::mt19937 rng_inst;
+
+/** Module RNG mutex */
+static std::mutex rng_mutex;
+
+
+/**
+ *  \brief  Draw local RNG seed
+ *
+ *  Native code uses local generators (not shared by threads) seeded
+ *  from the module RNG, so the results are reproducible by \c rng_seed.
+ *
+ *  \return Seed
+ */
+static unsigned rng_draw() {
+    std::unique_lock<std::mutex> lock(rng_mutex);
+    return rng_inst();
+}
+
+
+/** LVQ classifier statistics Python object */
+typedef struct {
+    PyObject_HEAD
+    lvq_classifier_stats_t * lvq_stats;
+    PyObject *               py_lvq;     /**< Bound LVQ object (or NULL) */
+    Py_ssize_t               exports;    /**< Counters buffer exports    */
+} lvqClassifierStatisticsObject_t;
+
+/** LVQ classifier statistics object access */
+#define python2lvq_classifier_stats(self) \
+    ((reinterpret_cast<lvqClassifierStatisticsObject_t *>(self))->lvq_stats)
+
+
+/** LVQ clustering statistics Python object */
+typedef struct {
+    PyObject_HEAD
+    lvq_clustering_stats_t * lvq_stats;
+    PyObject *               py_lvq;     /**< Bound LVQ object (or NULL) */
+    Py_ssize_t               exports;    /**< Counters buffer exports    */
+} lvqClusteringStatisticsObject_t;
+
+/** LVQ clustering statistics object access */
+#define python2lvq_clustering_stats(self) \
+    ((reinterpret_cast<lvqClusteringStatisticsObject_t *>(self))->lvq_stats)
+
+
+/** Training set Python object */
+typedef struct {
+    PyObject_HEAD
+    tset_arena * tset;
+    Py_ssize_t   exports;  /**< Buffer exports */
+} trainingSetObject_t;
+
+/** Training set object access */
+#define python2tset_arena(self) \
+    ((reinterpret_cast<trainingSetObject_t *>(self))->tset)
+
+
+/**
+ *  \brief  Python exception type of C++ exception
+ *
+ *  \param  x  Exception
+ *
+ *  \return \c MemoryError for \c std::bad_alloc, \c RuntimeError otherwise
+ */
+static PyObject * exception_type(const std::exception & x) {
+    return NULL != dynamic_cast<const std::bad_alloc *>(&x)
+        ? PyExc_MemoryError : PyExc_RuntimeError;
+}
+
+
+/**
+ *  \brief  Python exception of C++ exception
+ *
+ *  \param  error  Exception
+ *
+ *  \return New Python exception instance (or \c NULL on failure)
+ */
+static PyObject * exception2python(const std::exception_ptr & error) {
+    try {
+        std::rethrow_exception(error);
+    }
+    catch (std::exception & x) {
+        return PyObject_CallFunction(exception_type(x), "s", x.what());
+    }
+    catch (...) {
+        return PyObject_CallFunction(
+            PyExc_RuntimeError, "s", "Unknown exception");
+    }
+}
+
+
+/**
+ *  \brief  Exception-safe wrapper for bindings
+ *
+ *  \tparam R_t  Function return type
+ *  \tparam F_t  Function
+ *  \tparam A_t  Argument types
+ *
+ *  \param  xres  Return value in case of exception
+ *  \param  fn    Function
+ *  \param  args  Function arguments
+ *
+ *  \return \c fn(args) or \c eres in case of an exception
+ */
+template <typename R_t, typename F_t, typename... A_t>
+R_t wrap_X(R_t xres, F_t fn, A_t... args) {
+    R_t res = xres;
+
+    try {
+        res = fn(args...);
+    }
+    catch (std::exception & x) {
+        PyErr_SetString(exception_type(x), x.what());
+    }
+    catch (...) {
+        PyErr_SetString(PyExc_RuntimeError, "Unknown exception");
+    }
+
+    return res;
+}
+
+/**
+ *  \brief  Exception-safe binding wrapper instance identifier
+ *
+ *  \param  binding  Binding function identifier
+ */
+#define BINDING_IDENT(binding) binding ## __wrap_X
+
+/** Exception-safe binding wrapper instance */
+#define BINDING_INST(binding) \
+static PyObject * BINDING_IDENT(binding)(PyObject * self, PyObject * args) { \
+    return wrap_X((PyObject *)NULL, binding, self, args); \
+}
+
+
+/**
+ *  \brief  Parse bindings arguments
+ *
+ *  \tparam A_t  Arguments type
+ *
+ *  \param  py_args  Python arguments
+ *  \param  fstr     Argument types format string
+ *  \param  args     Parsed arguments
+ */
+template <typename... A_t>
+static void parse_args(PyObject * py_args, const char * fstr, A_t... args) {
+    PyArg_ParseTuple(py_args, fstr, args...);
+
+    if (NULL != PyErr_Occurred())
+        throw std::logic_error("Invalid arguments");
+}
+
+
+/**
+ *  \brief  Exception-safe binding wrapper instance (keyword arguments)
+ */
+#define BINDING_INST_KW(binding) \
+static PyObject * BINDING_IDENT(binding)( \
+    PyObject * self, PyObject * args, PyObject * kwds) \
+{ \
+    return wrap_X((PyObject *)NULL, binding, self, args, kwds); \
+}
+
+
+/**
+ *  \brief  Parse bindings arguments (keyword arguments allowed)
+ *
+ *  \tparam A_t  Arguments type
+ *
+ *  \param  py_args  Python arguments
+ *  \param  py_kwds  Python keyword arguments
+ *  \param  fstr     Argument types format string
+ *  \param  kwlist   Argument names (\c NULL terminated)
+ *  \param  args     Parsed arguments
+ */
+template <typename... A_t>
+static void parse_args_kw(
+    PyObject *    py_args,
+    PyObject *    py_kwds,
+    const char *  fstr,
+    const char ** kwlist,
+    A_t...        args)
+{
+    PyArg_ParseTupleAndKeywords(py_args, py_kwds, fstr,
+        const_cast<char **>(kwlist), args...);
+
+    if (NULL != PyErr_Occurred())
+        throw std::logic_error("Invalid arguments");
+}
+
+
+/**
+ *  \brief  Python object reference holder
+ *
+ *  Drops the reference on destruction unless released.
+ *  Keeps partially constructed results from leaking on exceptions.
+ */
+class py_ref {
+    private:
+
+    PyObject * m_obj;  /**< Referenced object */
+
+    public:
+
+    /** Constructor (steals the reference) */
+    explicit py_ref(PyObject * obj = NULL): m_obj(obj) {}
+
+    /** Referenced object */
+    PyObject * get() const { return m_obj; }
+
+    /** Release the reference (caller takes ownership) */
+    PyObject * release() {
+        PyObject * obj = m_obj;
+        m_obj = NULL;
+        return obj;
+    }
+
+    /** Destructor */
+    ~py_ref() { Py_XDECREF(m_obj); }
+
+    private:
+
+    py_ref(const py_ref &);
+    py_ref & operator = (const py_ref &);
+
+};  // end of class py_ref
+
+
+/**
+ *  \brief  Buffer protocol view of a row-major matrix or vector
+ *
+ *  Wraps \c PyObject_GetBuffer; the buffer must be C-contiguous.
+ *  Vectors (1-D buffers) are viewed as matrices of a single column.
+ */
+class buffer_view {
+    public:
+
+    /** Item type */
+    enum dtype_t {
+        FLOAT64,  /**< \c double          */
+        FLOAT32,  /**< \c float           */
+        INT64,    /**< 64-bit signed int  */
+        OTHER,    /**< Unsupported        */
+    };  // end of enum dtype_t
+
+    private:
+
+    Py_buffer m_view;   /**< Buffer view  */
+    dtype_t   m_dtype;  /**< Item type    */
+    size_t    m_rows;   /**< Row count    */
+    size_t    m_cols;   /**< Column count */
+
+    /** Resolve item type from struct format string */
+    static dtype_t format2dtype(const char * fmt, Py_ssize_t itemsize) {
+        if (NULL == fmt) fmt = "B";
+
+        // Skip native/little-endian byte order designators
+        if ('@' == *fmt || '=' == *fmt || '<' == *fmt) ++fmt;
+
+        if ('\0' != fmt[0] && '\0' != fmt[1]) return OTHER;
+
+        switch (fmt[0]) {
+            case 'd': return 8 == itemsize ? FLOAT64 : OTHER;
+            case 'f': return 4 == itemsize ? FLOAT32 : OTHER;
+
+            case 'q':
+            case 'l':
+            case 'n': return 8 == itemsize ? INT64 : OTHER;
+        }
+
+        return OTHER;
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  obj       Object exposing the buffer protocol
+     *  \param  writable  Writable buffer required
+     */
+    buffer_view(PyObject * obj, bool writable = false) {
+        int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT;
+        if (writable) flags |= PyBUF_WRITABLE;
+
+        if (0 != PyObject_GetBuffer(obj, &m_view, flags)) {
+            PyErr_Clear();
+            throw std::logic_error(writable
+                ? "Writable C-contiguous buffer expected"
+                : "C-contiguous buffer expected");
+        }
+
+        m_dtype = format2dtype(m_view.format, m_view.itemsize);
+
+        switch (m_view.ndim) {
+            case 1:
+                m_rows = m_view.shape[0];
+                m_cols = 1;
+                break;
+
+            case 2:
+                m_rows = m_view.shape[0];
+                m_cols = m_view.shape[1];
+                break;
+
+            default:
+                PyBuffer_Release(&m_view);
+                throw std::logic_error("1-D or 2-D buffer expected");
+        }
+    }
+
+    /** Item type */
+    dtype_t dtype() const { return m_dtype; }
+
+    /** Number of dimensions */
+    int ndim() const { return m_view.ndim; }
+
+    /** Row count */
+    size_t rows() const { return m_rows; }
+
+    /** Column count */
+    size_t cols() const { return m_cols; }
+
+    /** Item count */
+    size_t size() const { return m_rows * m_cols; }
+
+    /** Size in bytes */
+    size_t bytes() const { return m_view.len; }
+
+    /** Data */
+    template <typename T>
+    T * data() const { return reinterpret_cast<T *>(m_view.buf); }
+
+    /** Row */
+    template <typename T>
+    T * row(size_t i) const { return data<T>() + i * m_cols; }
+
+    /** Destructor (must be called with GIL held) */
+    ~buffer_view() { PyBuffer_Release(&m_view); }
+
+    private:
+
+    buffer_view(const buffer_view &);
+    buffer_view & operator = (const buffer_view &);
+
+};  // end of class buffer_view
+
+
+/**
+ *  \brief  Check that matrix buffer holds floating point input
+ *
+ *  \param  matrix     Matrix buffer
+ *  \param  dimension  Expected column count
+ */
+static void check_input_matrix(const buffer_view & matrix, size_t dimension) {
+    if (buffer_view::FLOAT64 != matrix.dtype() &&
+        buffer_view::FLOAT32 != matrix.dtype())
+    {
+        throw std::logic_error("Invalid input matrix (float64/float32 expected)");
+    }
+
+    if (2 != matrix.ndim())
+        throw std::logic_error("Invalid input matrix (2-D buffer expected)");
+
+    if (dimension != matrix.cols())
+        throw std::logic_error("Invalid input matrix (dimension mismatch)");
+}
+
+
+/**
+ *  \brief  Transform matrix buffer row to \c lvq_t::input_t
+ *
+ *  NaN values are taken for undefined (just like \c None in Python input).
+ *  The input is expected to be of the matrix column count already,
+ *  so that a single instance may be re-used for all rows.
+ *
+ *  \param  matrix  Matrix buffer (float64 or float32)
+ *  \param  i       Row index
+ *  \param  input   Input (output)
+ */
+static void row2input(
+    const buffer_view & matrix,
+    size_t               i,
+    lvq_t::input_t     & input)
+{
+    const size_t cols = matrix.cols();
+
+    if (buffer_view::FLOAT64 == matrix.dtype()) {
+        const double * row = matrix.row<const double>(i);
+        for (size_t j = 0; j < cols; ++j)
+            input[j] = std::isnan(row[j])
+                     ? lvq_t::base_t::undef
+                     : lvq_t::base_t(row[j]);
+    }
+    else {
+        const float * row = matrix.row<const float>(i);
+        for (size_t j = 0; j < cols; ++j)
+            input[j] = std::isnan(row[j])
+                     ? lvq_t::base_t::undef
+                     : lvq_t::base_t(row[j]);
+    }
+}
+
+
+/**
+ *  \brief  Create Python \c array of given type code and size
+ *
+ *  The array is zero-initialised.
+ *
+ *  \param  typecode  \c array type code
+ *  \param  size      Item count
+ *  \param  itemsize  Item size
+ *
+ *  \return New \c array instance
+ */
+static PyObject * new_array(const char * typecode, size_t size, size_t itemsize) {
+    py_ref py_array_mod(PyImport_ImportModule("array"));
+    if (NULL == py_array_mod.get())
+        throw std::runtime_error("Failed to import array module");
+
+    py_ref py_init(PyBytes_FromStringAndSize(NULL, size * itemsize));
+    if (NULL == py_init.get())
+        throw std::runtime_error("Failed to allocate array initialiser");
+
+    ::memset(PyBytes_AS_STRING(py_init.get()), 0, size * itemsize);
+
+    PyObject * py_array = PyObject_CallMethod(
+        py_array_mod.get(), "array", "sO", typecode, py_init.get());
+
+    if (NULL == py_array)
+        throw std::runtime_error("Failed to create array");
+
+    return py_array;
+}
+
+
+/**
+ *  \brief  Create 2-D matrix
+ *
+ *  The matrix is a \c memoryview of a new zero-initialised \c array.
+ *
+ *  \param  typecode  \c array type code
+ *  \param  rows      Row count
+ *  \param  cols      Column count
+ *  \param  itemsize  Item size
+ *
+ *  \return New 2-D \c memoryview
+ */
+static PyObject * new_matrix(
+    const char * typecode,
+    size_t       rows,
+    size_t       cols,
+    size_t       itemsize)
+{
+    py_ref py_array(new_array(typecode, rows * cols, itemsize));
+
+    py_ref py_view(PyMemoryView_FromObject(py_array.get()));
+    if (NULL == py_view.get())
+        throw std::runtime_error("Failed to create memoryview");
+
+    py_ref py_bytes(PyObject_CallMethod(py_view.get(), "cast", "s", "B"));
+    if (NULL == py_bytes.get())
+        throw std::runtime_error("Failed to cast memoryview");
+
+    PyObject * py_matrix = PyObject_CallMethod(py_bytes.get(), "cast", "s(nn)",
+        typecode, (Py_ssize_t)rows, (Py_ssize_t)cols);
+
+    if (NULL == py_matrix)
+        throw std::runtime_error("Failed to cast memoryview");
+
+    return py_matrix;
+}
+
+//
+// Buffer exports
+//
+
+/**
+ *  \brief  Buffer exporter Python object
+ *
+ *  Exports (read-only or writable) 1-D or 2-D view (C-contiguous
+ *  or with padded rows) of memory owned by another object; the owner
+ *  is kept alive and its export counter is maintained (so that the owner
+ *  may refuse to re-allocate the memory while exported).
+ *  The exporter may also own the memory (a copy); the owner version
+ *  at export may be recorded (e.g. to refuse a stale copy later).
+ */
+typedef struct bufferExporterObject_s {
+    PyObject_HEAD
+    PyObject *   owner;       /**< Memory owner                 */
+    Py_ssize_t * exports;     /**< Owner export counter         */
+    void *       data;        /**< Exported memory              */
+    const char * format;      /**< Item format (struct syntax)  */
+    Py_ssize_t   itemsize;    /**< Item size                    */
+    int          ndim;        /**< Dimensions count (1 or 2)    */
+    Py_ssize_t   shape[2];    /**< Shape                        */
+    Py_ssize_t   strides[2];  /**< Strides                      */
+    int          readonly;    /**< Read-only export             */
+    void *       own;         /**< Owned memory (or NULL)       */
+    uint64_t     version;     /**< Owner version at export      */
+} bufferExporterObject_t;
+
+
+/** Buffer exporter \c getbuffer */
+static int buffer_exporter__getbuffer(
+    PyObject * self, Py_buffer * view, int flags)
+{
+    bufferExporterObject_t * exporter =
+        reinterpret_cast<bufferExporterObject_t *>(self);
+
+    if ((flags & PyBUF_WRITABLE) && exporter->readonly) {
+        PyErr_SetString(PyExc_BufferError, "Read-only buffer");
+        return -1;
+    }
+
+    // Padded rows may only be exported with strides
+    const bool contiguous = 2 != exporter->ndim ||
+        exporter->strides[0] == exporter->itemsize * exporter->shape[1];
+
+    const int contiguity = (PyBUF_C_CONTIGUOUS | PyBUF_F_CONTIGUOUS |
+        PyBUF_ANY_CONTIGUOUS) & ~PyBUF_STRIDES;
+
+    if (!contiguous &&
+        (PyBUF_STRIDES != (flags & PyBUF_STRIDES) || (flags & contiguity)))
+    {
+        PyErr_SetString(PyExc_BufferError, "Non-contiguous buffer");
+        return -1;
+    }
+
+    view->obj        = self;
+    view->buf        = exporter->data;
+    view->len        = exporter->itemsize * exporter->shape[0] *
+                       (2 == exporter->ndim ? exporter->shape[1] : 1);
+    view->readonly   = exporter->readonly;
+    view->itemsize   = exporter->itemsize;
+    view->format     = (flags & PyBUF_FORMAT)
+                     ? const_cast<char *>(exporter->format) : NULL;
+    view->ndim       = exporter->ndim;
+    view->shape      = (flags & PyBUF_ND)      ? exporter->shape   : NULL;
+    view->strides    = (flags & PyBUF_STRIDES) ? exporter->strides : NULL;
+    view->suboffsets = NULL;
+    view->internal   = NULL;
+
+    Py_INCREF(self);
+    ++*exporter->exports;
+
+    return 0;
+}
+
+
+/** Buffer exporter \c releasebuffer */
+static void buffer_exporter__releasebuffer(PyObject * self, Py_buffer * view) {
+    bufferExporterObject_t * exporter =
+        reinterpret_cast<bufferExporterObject_t *>(self);
+
+    --*exporter->exports;
+}
+
+
+/** Buffer exporter destructor */
+static void buffer_exporter__dealloc(PyObject * self) {
+    bufferExporterObject_t * exporter =
+        reinterpret_cast<bufferExporterObject_t *>(self);
+
+    Py_XDECREF(exporter->owner);
+    ::free(exporter->own);
+
+    Py_TYPE(self)->tp_free(self);
+}
+
+
+/** Buffer exporter buffer protocol */
+static PyBufferProcs bufferExporter_as_buffer = {
+    /* bf_getbuffer     */  buffer_exporter__getbuffer,
+    /* bf_releasebuffer */  buffer_exporter__releasebuffer,
+};
+
+
+/** Buffer exporter Python type */
+static PyTypeObject bufferExporterType = {
+    PyObject_HEAD_INIT(NULL)
+
+    /* tp_name          */  "liblvq.buffer_exporter",
+    /* tp_basicsize     */  sizeof(bufferExporterObject_t),
+    /* tp_itemsize      */  0,
+    /* tp_dealloc       */  (destructor)buffer_exporter__dealloc,
+    /* tp_print         */  0,
+    /* tp_getattr       */  0,
+    /* tp_setattr       */  0,
+    /* tp_compare       */  0,
+    /* tp_repr          */  0,
+    /* tp_as_number     */  0,
+    /* tp_as_sequence   */  0,
+    /* tp_as_mapping    */  0,
+    /* tp_hash          */  0,
+    /* tp_call          */  0,
+    /* tp_str           */  0,
+    /* tp_getattro      */  0,
+    /* tp_setattro      */  0,
+    /* tp_as_buffer     */  &bufferExporter_as_buffer,
+    /* tp_flags         */  Py_TPFLAGS_DEFAULT,
+    /* tp_doc           */  "liblvq memory exports",
+
+};  // end of bufferExporterType
+
+
+/**
+ *  \brief  Create buffer exporter of memory owned by an object
+ *
+ *  The memory must stay valid (and not move) as long as the owner
+ *  export counter is non-zero.
+ *  If \c data is \c NULL, zero-initialised memory owned by the exporter
+ *  is allocated (see \c data member).
+ *
+ *  \param  owner     Memory owner
+ *  \param  exports   Owner export counter
+ *  \param  data      Memory (or \c NULL)
+ *  \param  format    Item format (\c struct module syntax)
+ *  \param  itemsize  Item size
+ *  \param  rows      Rows (items count of vectors)
+ *  \param  cols      Columns (0 for vectors)
+ *  \param  stride    Row stride (items, at least \c cols)
+ *  \param  readonly  Read-only view
+ *
+ *  \return New buffer exporter
+ */
+static bufferExporterObject_t * new_exporter(
+    PyObject *   owner,
+    Py_ssize_t * exports,
+    const void * data,
+    const char * format,
+    size_t       itemsize,
+    size_t       rows,
+    size_t       cols,
+    size_t       stride,
+    bool         readonly)
+{
+    void * own = NULL;
+    if (NULL == data) {
+        own = ::calloc(std::max<size_t>(rows * std::max<size_t>(cols, 1), 1), itemsize);
+        if (NULL == own) throw std::bad_alloc();
+
+        data = own;
+    }
+
+    bufferExporterObject_t * exporter =
+        PyObject_New(bufferExporterObject_t, &bufferExporterType);
+
+    if (NULL == exporter) {
+        ::free(own);
+        throw std::runtime_error("Failed to create buffer exporter");
+    }
+
+    Py_INCREF(owner);
+    exporter->owner      = owner;
+    exporter->exports    = exports;
+    exporter->data       = const_cast<void *>(data);
+    exporter->format     = format;
+    exporter->itemsize   = itemsize;
+    exporter->ndim       = 0 == cols ? 1 : 2;
+    exporter->shape[0]   = rows;
+    exporter->shape[1]   = cols;
+    exporter->strides[0] = itemsize * (0 == cols ? 1 : stride);
+    exporter->strides[1] = itemsize;
+    exporter->readonly   = readonly;
+    exporter->own        = own;
+    exporter->version    = 0;
+
+    return exporter;
+}
+
+
+/**
+ *  \brief  Create \c memoryview of buffer exporter
+ *
+ *  \param  exporter  Buffer exporter (reference is stolen)
+ *
+ *  \return New \c memoryview instance
+ */
+static PyObject * exporter2view(bufferExporterObject_t * exporter) {
+    py_ref py_exporter(reinterpret_cast<PyObject *>(exporter));
+
+    PyObject * py_view = PyMemoryView_FromObject(py_exporter.get());
+    if (NULL == py_view)
+        throw std::runtime_error("Failed to create memoryview");
+
+    return py_view;
+}
+
+
+/**
+ *  \brief  Create \c memoryview of memory owned by an object
+ *
+ *  See \ref new_exporter (C-contiguous rows).
+ *
+ *  \param  owner     Memory owner
+ *  \param  exports   Owner export counter
+ *  \param  data      Memory
+ *  \param  format    Item format (\c struct module syntax)
+ *  \param  itemsize  Item size
+ *  \param  rows      Rows (items count of vectors)
+ *  \param  cols      Columns (0 for vectors)
+ *  \param  readonly  Read-only view
+ *
+ *  \return New \c memoryview instance
+ */
+static PyObject * new_export(
+    PyObject *   owner,
+    Py_ssize_t * exports,
+    const void * data,
+    const char * format,
+    size_t       itemsize,
+    size_t       rows,
+    size_t       cols,
+    bool         readonly)
+{
+    return exporter2view(new_exporter(
+        owner, exports, data, format, itemsize, rows, cols, cols, readonly));
+}
+
+
+
+/**
+ *  \brief  Transform Python weight sequence to \c std::vector
+ *
+ *  \param  py_weight  Python weight sequence
+ *
+ *  \return Weight vector
+ */
+static std::vector<double> python2weight(PyObject * py_weight) {
+    Py_ssize_t weight_size = PyObject_Size(py_weight);
+    if (-1 == weight_size)
+        throw std::logic_error("Invalid weights (can't get size)");
+
+    PyObject * py_iter = PyObject_GetIter(py_weight);
+    if (NULL == py_iter)
+        throw std::logic_error("Invalid weights (should be iterable)");
+
+    std::vector<double> weight;
+    weight.reserve(weight_size);
+
+    PyObject * py_w;
+    while (NULL != (py_w = PyIter_Next(py_iter))) {
+        weight.push_back(PyFloat_AsDouble(py_w));
+
+        if (NULL != PyErr_Occurred())
+            throw std::logic_error("Invalid weight (should be double)");
+
+        Py_DECREF(py_w);
+    }
+
+    Py_DECREF(py_iter);
+
+    return weight;
+}
+
+
+/**
+ *  \brief  Transform weight std::vector to Python tuple
+ *
+ *  \param  weight  Weight vector
+ *
+ *  \return Python weight tuple
+ */
+static PyObject * weight2python(const std::vector<double> & weight) {
+    size_t     weight_size = weight.size();
+    PyObject * py_weight   = PyTuple_New(weight_size);
+
+    for (size_t i = 0; i < weight_size; ++i) {
+        PyTuple_SetItem(py_weight, i, Py_BuildValue("d", weight[i]));
+    }
+
+    return py_weight;
+}
+
+
+/**
+ *  \brief  Transform Python tuple of numbers to \c lvq_t::input_t
+ *
+ *  \param  py_input  Python tuple of numbers
+ *
+ *  \return \c lvq_t::input_t
+ */
+static lvq_t::input_t python2input(PyObject * py_input) {
+    Py_ssize_t input_size = PyObject_Size(py_input);
+    if (-1 == input_size)
+        throw std::logic_error("Invalid input (can't get size)");
+
+    PyObject * py_iter = PyObject_GetIter(py_input);
+    if (NULL == py_iter)
+        throw std::logic_error("Invalid input (should be iterable)");
+
+    lvq_t::input_t input(input_size);
+
+    PyObject * py_x;
+    for (size_t i = 0; NULL != (py_x = PyIter_Next(py_iter)); ++i) {
+        input[i] = Py_None == py_x
+                 ? lvq_t::base_t::undef
+                 : lvq_t::base_t(PyFloat_AsDouble(py_x));
+
+        if (NULL != PyErr_Occurred())
+            throw std::logic_error("Invalid input value");
+
+        Py_DECREF(py_x);
+    }
+
+    Py_DECREF(py_iter);
+
+    return input;
+}
+
+
+/**
+ *  \brief  Transform \c lvq_t::input_t to Python tuple of numbers
+ *
+ *  \param  input  \c lvq_t::input_t instance
+ *
+ *  \return Python tuple
+ */
+static PyObject * input2python(const lvq_t::input_t & input) {
+    size_t     input_rank = input.rank();
+    PyObject * py_input   = PyTuple_New(input_rank);
+
+    for (size_t i = 0; i < input_rank; ++i) {
+        PyObject * x;
+
+        if (input[i].is_defined())
+            x = Py_BuildValue("d", input[i]);
+        else {
+            Py_INCREF(Py_None);
+            x = Py_None;
+        }
+
+        PyTuple_SetItem(py_input, i, x);
+    }
+
+    return py_input;
+}
+
+
+/**
+ *  \brief  Transform [cluster, weight] pairs vector to Python representation
+ *
+ *  \param  cw_vec  [cluster, weight] pairs vector
+ *
+ *  \return Python list of [cluster, weight] tuples
+ */
+static PyObject * cw_vec2python(const std::vector<lvq_t::cw_t> & cw_vec) {
+    size_t     cw_vec_size = cw_vec.size();
+    PyObject * py_cw_tuple = PyTuple_New(cw_vec_size);
+
+    for (size_t i = 0; i < cw_vec_size; ++i) {
+        PyTuple_SetItem(py_cw_tuple, i,
+            Py_BuildValue("(nd)", cw_vec[i].first, cw_vec[i].second));
+    }
+
+    return py_cw_tuple;
+}
+
+
+/**
+ *  \brief  Transform Python training/test set to \c lvq_t::tset_classifier_t set
+ *
+ *  The Python training set is an iterable containing (input, cluster) tuples.
+ *
+ *  \param  py_set  Python iterable of number tuples
+ *
+ *  \return Training set
+ */
+static tset_classifier_t python2tset_classifier(PyObject * py_set) {
+    Py_ssize_t set_size = PyObject_Size(py_set);
+    if (-1 == set_size)
+        throw std::logic_error("Invalid training set (can't get size)");
+
+    PyObject * py_iter = PyObject_GetIter(py_set);
+    if (NULL == py_iter)
+        throw std::logic_error("Invalid training set (should be iterable)");
+
+    tset_classifier_t set;
+
+    PyObject * py_ic;
+    while (NULL != (py_ic = PyIter_Next(py_iter))) {
+        if (!PyTuple_Check(py_ic))
+            throw std::logic_error(
+                "Invalid training set ((input, cluster) tuples expected");
+
+        PyObject * py_input   = PyTuple_GetItem(py_ic, 0);
+        PyObject * py_cluster = PyTuple_GetItem(py_ic, 1);
+
+        const lvq_t::input_t input = python2input(py_input);
+
+        if (!PyLong_Check(py_cluster))
+            throw std::logic_error("Invalid cluster (integer expected)");
+
+        Py_ssize_t cluster = PyLong_AsSsize_t(py_cluster);
+
+        if (0 > cluster)
+            throw std::logic_error("Invalid cluster (must be >= 0)");
+
+        set.emplace_back(input, cluster);
+
+        Py_DECREF(py_ic);
+    }
+
+    Py_DECREF(py_iter);
+
+    return set;
+}
+
+
+/**
+ *  \brief  Transform Python training/test set to \c lvq_t::tset_clustering_t set
+ *
+ *  The Python training set is an iterable containing (input, cluster) tuples.
+ *
+ *  \param  py_set  Python iterable of number tuples
+ *
+ *  \return Training set
+ */
+static tset_clustering_t python2tset_clustering(PyObject * py_set) {
+    Py_ssize_t set_size = PyObject_Size(py_set);
+    if (-1 == set_size)
+        throw std::logic_error("Invalid training set (can't get size)");
+
+    PyObject * py_iter = PyObject_GetIter(py_set);
+    if (NULL == py_iter)
+        throw std::logic_error("Invalid training set (should be iterable)");
+
+    tset_clustering_t set;
+
+    PyObject * py_input;
+    while (NULL != (py_input = PyIter_Next(py_iter))) {
+        const lvq_t::input_t input = python2input(py_input);
+
+        set.emplace_back(input);
+
+        Py_DECREF(py_input);
+    }
+
+    Py_DECREF(py_iter);
+
+    return set;
+}
+
+
+/**
+ *  \brief  Transform Python tuple of numbers to dense vector
+ *
+ *  \c None is transformed to NaN (undefined).
+ *
+ *  \param  py_input  Python tuple of numbers
+ *  \param  x         Vector (output)
+ */
+static void python2dense(PyObject * py_input, std::vector<double> & x) {
+    Py_ssize_t input_size = PyObject_Size(py_input);
+    if (-1 == input_size)
+        throw std::logic_error("Invalid input (can't get size)");
+
+    PyObject * py_iter = PyObject_GetIter(py_input);
+    if (NULL == py_iter)
+        throw std::logic_error("Invalid input (should be iterable)");
+
+    x.resize(input_size);
+
+    PyObject * py_x;
+    for (size_t i = 0; NULL != (py_x = PyIter_Next(py_iter)); ++i) {
+        x[i] = Py_None == py_x ? NAN : PyFloat_AsDouble(py_x);
+
+        if (NULL != PyErr_Occurred())
+            throw std::logic_error("Invalid input value");
+
+        Py_DECREF(py_x);
+    }
+
+    Py_DECREF(py_iter);
+}
+
+
+//
+// Binary training set files
+//
+
+/**
+ *  \brief  Binary training set file header
+ *
+ *  File layout (native byte order, sections 8B aligned):
+ *  -# header (64B)
+ *  -# row-major sample matrix (\c count rows of \c dim items of \c dtype,
+ *     NaN stands for undefined value)
+ *  -# sample labels (\c count of \c int64_t, labelled sets only)
+ *  -# validity bitmap (\c count rows of <tt>ceil(dim / 64)</tt>
+ *     \c uint64_t words, bit set iff the value is defined; optional)
+ */
+struct tset_header {
+    /** Item types */
+    enum {
+        FLOAT64 = 0,  /**< \c double items */
+        FLOAT32 = 1,  /**< \c float items  */
+    };
+
+    /** Flags */
+    enum {
+        LABELS   = 0x1,  /**< Labels present          */
+        VALIDITY = 0x2,  /**< Validity bitmap present */
+    };
+
+    /** Constants */
+    enum {
+        VERSION         = 1,           /**< Format version  */
+        BYTE_ORDER_MARK = 0x01020304,  /**< Byte order mark */
+    };
+
+    char     magic[8];     /**< \c "LVQTSET\0"  */
+    uint32_t version;      /**< Format version  */
+    uint32_t byte_order;   /**< Byte order mark */
+    uint32_t dtype;        /**< Item type       */
+    uint32_t flags;        /**< Flags           */
+    uint64_t dim;          /**< Dimension       */
+    uint64_t count;        /**< Sample count    */
+    uint64_t reserved[3];  /**< Reserved (zero) */
+
+    /** Magic */
+    static const char * magic_str() { return "LVQTSET"; }
+
+    /** 8B alignment */
+    static size_t align8(size_t off) { return (off + 7) & ~(size_t)7; }
+
+    /** Item size */
+    size_t itemsize() const {
+        return FLOAT32 == dtype ? sizeof(float) : sizeof(double);
+    }
+
+    /** Validity bitmap words per row */
+    size_t mwords() const { return (dim + 63) / 64; }
+
+    /** Sample matrix offset */
+    size_t matrix_offset() const { return sizeof(tset_header); }
+
+    /** Labels offset */
+    size_t labels_offset() const {
+        return align8(matrix_offset() + count * dim * itemsize());
+    }
+
+    /** Validity bitmap offset */
+    size_t validity_offset() const {
+        return labels_offset() + (flags & LABELS ? count * sizeof(int64_t) : 0);
+    }
+
+    /** File size */
+    size_t file_size() const {
+        return validity_offset() +
+            (flags & VALIDITY ? count * mwords() * sizeof(uint64_t) : 0);
+    }
+
+};  // end of struct tset_header
+
+static_assert(64 == sizeof(tset_header), "Unexpected tset_header size");
+
+
+/**
+ *  \brief  Binary training set file writer
+ *
+ *  Samples are written row by row; labels and the validity bitmap
+ *  (written only if any value is undefined) are kept until \ref close
+ *  which also finalises the header.
+ *  The file is written to a temporary file in the same directory
+ *  and renamed to \c path on \ref close, so readers never see
+ *  an incomplete file (and an existing file is kept on failure).
+ *  Incomplete files are removed on destruction.
+ */
+class tset_writer {
+    private:
+
+    const std::string     m_path;    /**< File path            */
+    std::string           m_tmp;     /**< Temporary file path  */
+    FILE *                m_file;    /**< File                 */
+    tset_header           m_header;  /**< Header               */
+    std::vector<int64_t>  m_labels;  /**< Labels               */
+    std::vector<uint64_t> m_valid;   /**< Validity bitmap      */
+    bool                  m_undef;   /**< Undefined value seen */
+    std::vector<char>     m_row;     /**< Row buffer           */
+
+    /** Write data */
+    void write(const void * data, size_t size) {
+        if (0 < size && 1 != ::fwrite(data, size, 1, m_file))
+            throw std::runtime_error("Failed to write training set file");
+    }
+
+    /** Unique temporary file path (next to \c path) */
+    static std::string temp_path(const std::string & path) {
+        static std::atomic<unsigned> seq(0);
+
+        return path + ".tmp." + std::to_string(::getpid()) + "." +
+            std::to_string(seq.fetch_add(1));
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  path      File path
+     *  \param  dtype     Item type (see \ref tset_header)
+     *  \param  dim       Dimension
+     *  \param  labelled  Samples are labelled
+     */
+    tset_writer(
+        const std::string & path,
+        uint32_t            dtype,
+        size_t              dim,
+        bool                labelled)
+    :
+        m_path(path),
+        m_tmp(temp_path(path)),
+        m_file(NULL),
+        m_undef(false)
+    {
+        const int fd = ::open(m_tmp.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+        if (0 > fd)
+            throw std::runtime_error("Failed to open training set file");
+
+        m_file = ::fdopen(fd, "wb");
+        if (NULL == m_file) {
+            ::close(fd);
+            ::remove(m_tmp.c_str());
+            throw std::runtime_error("Failed to open training set file");
+        }
+
+        ::memset(&m_header, 0, sizeof(m_header));
+        ::strcpy(m_header.magic, tset_header::magic_str());
+        m_header.version    = tset_header::VERSION;
+        m_header.byte_order = tset_header::BYTE_ORDER_MARK;
+        m_header.dtype      = dtype;
+        m_header.flags      = labelled ? tset_header::LABELS : 0;
+        m_header.dim        = dim;
+
+        m_row.resize(dim * m_header.itemsize());
+
+        write(&m_header, sizeof(m_header));  // finalised on close
+    }
+
+    /**
+     *  \brief  Add sample
+     *
+     *  \param  x      Sample (NaN stands for undefined value)
+     *  \param  label  Sample label (ignored for unlabelled sets)
+     */
+    template <typename S>
+    void add(const S * x, int64_t label = 0) {
+        const size_t dim = m_header.dim;
+        const size_t mwords = m_header.mwords();
+
+        m_valid.resize(m_valid.size() + mwords, 0);
+        uint64_t * valid = m_valid.data() + m_valid.size() - mwords;
+
+        for (size_t j = 0; j < dim; ++j) {
+            if (std::isnan(x[j]))
+                m_undef = true;
+            else
+                valid[j / 64] |= (uint64_t)1 << (j % 64);
+        }
+
+        if (tset_header::FLOAT32 == m_header.dtype) {
+            float * row = reinterpret_cast<float *>(m_row.data());
+            for (size_t j = 0; j < dim; ++j) row[j] = (float)x[j];
+        }
+        else {
+            double * row = reinterpret_cast<double *>(m_row.data());
+            for (size_t j = 0; j < dim; ++j) row[j] = (double)x[j];
+        }
+
+        write(m_row.data(), m_row.size());
+
+        if (m_header.flags & tset_header::LABELS) {
+            if (0 > label)
+                throw std::logic_error("Invalid label (must be >= 0)");
+
+            m_labels.push_back(label);
+        }
+
+        ++m_header.count;
+    }
+
+    /** Dimension */
+    size_t dimension() const { return m_header.dim; }
+
+    /** Finalise the file */
+    void close() {
+        static const char pad[8] = { 0 };
+
+        const size_t matrix_end = m_header.matrix_offset() +
+            m_header.count * m_header.dim * m_header.itemsize();
+        write(pad, m_header.labels_offset() - matrix_end);
+
+        write(m_labels.data(), m_labels.size() * sizeof(int64_t));
+
+        if (m_undef) {
+            m_header.flags |= tset_header::VALIDITY;
+            write(m_valid.data(), m_valid.size() * sizeof(uint64_t));
+        }
+
+        if (0 != ::fseek(m_file, 0, SEEK_SET))
+            throw std::runtime_error("Failed to write training set file");
+
+        write(&m_header, sizeof(m_header));
+
+        FILE * file = m_file;
+        m_file = NULL;
+
+        if (0 != ::fclose(file) ||
+            0 != ::rename(m_tmp.c_str(), m_path.c_str()))
+        {
+            ::remove(m_tmp.c_str());
+            throw std::runtime_error("Failed to write training set file");
+        }
+    }
+
+    /** Destructor (removes unfinished file) */
+    ~tset_writer() {
+        if (NULL == m_file) return;
+
+        ::fclose(m_file);
+        ::remove(m_tmp.c_str());
+    }
+
+    private:
+
+    tset_writer(const tset_writer &);
+    tset_writer & operator = (const tset_writer &);
+
+};  // end of class tset_writer
+
+
+/**
+ *  \brief  Native training set (row-major float64 sample matrix)
+ *
+ *  Common base of training set files and in-memory training sets;
+ *  NaN stands for undefined value.
+ *  Sequential training requires \c lvq_t training sets; sets with
+ *  caching enabled convert them once (lazily) and keep them, others
+ *  convert them per call (so that the set isn't held twice).
+ */
+class tset_matrix {
+    protected:
+
+    size_t          m_dim;     /**< Dimension     */
+    size_t          m_count;   /**< Sample count  */
+    const double *  m_matrix;  /**< Sample matrix */
+    const int64_t * m_labels;  /**< Labels (or \c NULL) */
+    const bool      m_cache;   /**< Converted sets are cached */
+
+    mutable std::mutex                         m_cache_mutex;  /**< Cache mutex */
+    mutable std::unique_ptr<tset_classifier_t> m_cset;  /**< Classifier set */
+    mutable std::unique_ptr<tset_clustering_t> m_uset;  /**< Clustering set */
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  cache  Cache converted \c lvq_t training sets
+     */
+    tset_matrix(bool cache = false):
+        m_dim(0),
+        m_count(0),
+        m_matrix(NULL),
+        m_labels(NULL),
+        m_cache(cache)
+    {}
+
+    /** Destructor */
+    ~tset_matrix() {}
+
+    public:
+
+    /** Dimension */
+    size_t dimension() const { return m_dim; }
+
+    /** Sample count */
+    size_t size() const { return m_count; }
+
+    /** Samples are labelled */
+    bool labelled() const { return NULL != m_labels; }
+
+    /** Sample matrix (row-major float64, NaN stands for undefined value) */
+    const double * matrix() const { return m_matrix; }
+
+    /** Sample */
+    const double * row(size_t i) const { return m_matrix + i * m_dim; }
+
+    /** Labels (or \c NULL) */
+    const int64_t * labels() const { return m_labels; }
+
+    /**
+     *  \brief  Check that the samples fit model
+     *
+     *  \param  dim     Model dimension
+     *  \param  superv  Labels are required
+     */
+    void check(size_t dim, bool superv) const {
+        if (dim != dimension())
+            throw std::logic_error(
+                "Invalid training set (dimension mismatch)");
+
+        if (superv && !labelled())
+            throw std::logic_error(
+                "Invalid training set (labels expected)");
+
+        if (!labelled()) return;
+
+        for (size_t i = 0; i < size(); ++i)
+            if (0 > m_labels[i])
+                throw std::logic_error("Invalid cluster (must be >= 0)");
+    }
+
+    /** Sample as \c lvq_t::input_t */
+    lvq_t::input_t input(size_t i) const {
+        lvq_t::input_t input(m_dim);
+
+        const double * x = row(i);
+        for (size_t j = 0; j < m_dim; ++j)
+            input[j] = std::isnan(x[j])
+                     ? lvq_t::base_t::undef
+                     : lvq_t::base_t(x[j]);
+
+        return input;
+    }
+
+    /**
+     *  \brief  Samples as \c lvq_t::tset_classifier
+     *
+     *  \param  conv  Conversion (used unless caching is enabled)
+     *
+     *  \return Cached set (converted once) or \c conv
+     */
+    const tset_classifier_t & classifier_set(tset_classifier_t & conv) const {
+        if (!m_cache) {
+            convert(conv);
+            return conv;
+        }
+
+        std::unique_lock<std::mutex> lock(m_cache_mutex);
+
+        if (!m_cset) {
+            std::unique_ptr<tset_classifier_t> set(new tset_classifier_t);
+            convert(*set);
+            m_cset = std::move(set);
+        }
+
+        return *m_cset;
+    }
+
+    /**
+     *  \brief  Samples as \c lvq_t::tset_clustering
+     *
+     *  \param  conv  Conversion (used unless caching is enabled)
+     *
+     *  \return Cached set (converted once) or \c conv
+     */
+    const tset_clustering_t & clustering_set(tset_clustering_t & conv) const {
+        if (!m_cache) {
+            convert(conv);
+            return conv;
+        }
+
+        std::unique_lock<std::mutex> lock(m_cache_mutex);
+
+        if (!m_uset) {
+            std::unique_ptr<tset_clustering_t> set(new tset_clustering_t);
+            convert(*set);
+            m_uset = std::move(set);
+        }
+
+        return *m_uset;
+    }
+
+    /** Converted sets are cached */
+    bool cached() const { return m_cache; }
+
+    private:
+
+    /** Convert samples to \c lvq_t::tset_classifier */
+    void convert(tset_classifier_t & set) const {
+        set.reserve(size());
+
+        for (size_t i = 0; i < size(); ++i)
+            set.emplace_back(input(i), (size_t)m_labels[i]);
+    }
+
+    /** Convert samples to \c lvq_t::tset_clustering */
+    void convert(tset_clustering_t & set) const {
+        set.reserve(size());
+
+        for (size_t i = 0; i < size(); ++i)
+            set.emplace_back(input(i));
+    }
+
+    tset_matrix(const tset_matrix &);
+    tset_matrix & operator = (const tset_matrix &);
+
+};  // end of class tset_matrix
+
+
+/**
+ *  \brief  Memory-mapped binary training set file
+ *
+ *  The file is mapped read-only; float64 sample matrices are used
+ *  in place (zero-copy, page cache backed).
+ *  float32 matrices (and matrices whose validity bitmap marks values
+ *  undefined without them being NaN) are converted to a float64 copy
+ *  on opening.
+ */
+class tset_file: public tset_matrix {
+    private:
+
+    int                 m_fd;        /**< File descriptor                */
+    void *              m_map;       /**< Mapping                        */
+    size_t              m_map_size;  /**< Mapping size                   */
+    tset_header         m_header;    /**< Header                         */
+    std::vector<double> m_conv;      /**< Converted matrix (if required) */
+
+    /** Mapped data at offset */
+    const char * at(size_t off) const {
+        return reinterpret_cast<const char *>(m_map) + off;
+    }
+
+    /** Unmap and close */
+    void release() {
+        if (NULL != m_map) ::munmap(m_map, m_map_size);
+        if (0 <= m_fd) ::close(m_fd);
+
+        m_map = NULL;
+        m_fd  = -1;
+    }
+
+    /** Validate header */
+    void check_header() const {
+        if (0 != ::memcmp(m_header.magic, tset_header::magic_str(), 8))
+            throw std::logic_error("Invalid training set file (bad magic)");
+
+        if (tset_header::BYTE_ORDER_MARK != m_header.byte_order)
+            throw std::logic_error(
+                "Invalid training set file (byte order mismatch)");
+
+        if (tset_header::VERSION != m_header.version)
+            throw std::logic_error(
+                "Invalid training set file (unsupported version)");
+
+        if (tset_header::FLOAT64 != m_header.dtype &&
+            tset_header::FLOAT32 != m_header.dtype)
+        {
+            throw std::logic_error("Invalid training set file (bad item type)");
+        }
+
+        // Sections must fit in the address space
+        const size_t max_items = SIZE_MAX / 2 / sizeof(double);
+        if (0 < m_header.dim && m_header.count > max_items / m_header.dim)
+            throw std::logic_error("Invalid training set file (too large)");
+
+        if (m_map_size < m_header.file_size())
+            throw std::logic_error("Invalid training set file (truncated)");
+    }
+
+    /** Value defined according to validity bitmap */
+    bool valid(const uint64_t * bitmap, size_t i, size_t j) const {
+        const uint64_t word = bitmap[i * m_header.mwords() + j / 64];
+        return 0 != (word & ((uint64_t)1 << (j % 64)));
+    }
+
+    /** Sample matrix may be used in place */
+    bool in_place() const {
+        if (tset_header::FLOAT64 != m_header.dtype) return false;
+        if (!(m_header.flags & tset_header::VALIDITY)) return true;
+
+        const uint64_t * bitmap = reinterpret_cast<const uint64_t *>(
+            at(m_header.validity_offset()));
+        const double * matrix = reinterpret_cast<const double *>(
+            at(m_header.matrix_offset()));
+
+        for (size_t i = 0; i < m_header.count; ++i)
+            for (size_t j = 0; j < m_header.dim; ++j)
+                if (!valid(bitmap, i, j) &&
+                    !std::isnan(matrix[i * m_header.dim + j])) return false;
+
+        return true;
+    }
+
+    /** Convert sample matrix to float64 */
+    template <typename S>
+    void convert() {
+        const S * matrix = reinterpret_cast<const S *>(
+            at(m_header.matrix_offset()));
+        const uint64_t * bitmap = m_header.flags & tset_header::VALIDITY
+            ? reinterpret_cast<const uint64_t *>(at(m_header.validity_offset()))
+            : NULL;
+
+        m_conv.resize(m_header.count * m_header.dim);
+
+        for (size_t i = 0; i < m_header.count; ++i)
+            for (size_t j = 0; j < m_header.dim; ++j) {
+                const size_t k = i * m_header.dim + j;
+                m_conv[k] = NULL == bitmap || valid(bitmap, i, j)
+                          ? (double)matrix[k] : NAN;
+            }
+
+        m_matrix = m_conv.data();
+    }
+
+    /** Open and map the file */
+    void open(const std::string & path) {
+        m_fd = ::open(path.c_str(), O_RDONLY);
+        if (0 > m_fd)
+            throw std::runtime_error("Failed to open training set file");
+
+        struct stat st;
+        if (0 != ::fstat(m_fd, &st))
+            throw std::runtime_error("Failed to stat training set file");
+
+        m_map_size = st.st_size;
+        if (m_map_size < sizeof(tset_header))
+            throw std::logic_error("Invalid training set file (truncated)");
+
+        m_map = ::mmap(NULL, m_map_size, PROT_READ, MAP_SHARED, m_fd, 0);
+        if (MAP_FAILED == m_map) {
+            m_map = NULL;
+            throw std::runtime_error("Failed to map training set file");
+        }
+
+        ::madvise(m_map, m_map_size, MADV_WILLNEED);
+
+        ::memcpy(&m_header, m_map, sizeof(m_header));
+        check_header();
+
+        m_dim   = m_header.dim;
+        m_count = m_header.count;
+
+        if (m_header.flags & tset_header::LABELS)
+            m_labels = reinterpret_cast<const int64_t *>(
+                at(m_header.labels_offset()));
+
+        if (in_place())
+            m_matrix = reinterpret_cast<const double *>(
+                at(m_header.matrix_offset()));
+        else if (tset_header::FLOAT32 == m_header.dtype)
+            convert<float>();
+        else
+            convert<double>();
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  path  File path
+     */
+    explicit tset_file(const std::string & path):
+        m_fd(-1),
+        m_map(NULL),
+        m_map_size(0)
+    {
+        try { open(path); }
+        catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    /** Sample matrix is used in place */
+    bool mapped() const { return m_conv.empty(); }
+
+    /** Destructor */
+    ~tset_file() { release(); }
+
+    private:
+
+    tset_file(const tset_file &);
+    tset_file & operator = (const tset_file &);
+
+};  // end of class tset_file
+
+
+/**
+ *  \brief  In-memory training set
+ *
+ *  Samples (row-major float64 matrix, NaN stands for undefined value),
+ *  labels and undefined values mask are kept in contiguous arrays.
+ *  The set is built by adding samples (see \ref tset_writer for
+ *  the same interface) and is immutable once closed.
+ *  Converted \c lvq_t training sets are cached by default
+ *  (see \ref tset_matrix).
+ */
+class tset_arena: public tset_matrix {
+    private:
+
+    const size_t          m_mwords;   /**< Mask words per row          */
+    std::vector<double>   m_values;   /**< Sample matrix               */
+    std::vector<int64_t>  m_lstore;   /**< Labels                      */
+    std::vector<uint64_t> m_undef;    /**< Undefined values mask       */
+    size_t                m_ucnt;     /**< Undefined values count      */
+    const bool            m_labelled; /**< Samples are labelled        */
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  dim       Dimension
+     *  \param  labelled  Samples are labelled
+     *  \param  reserve   Expected sample count
+     *  \param  cache     Cache converted \c lvq_t training sets
+     */
+    tset_arena(size_t dim, bool labelled, size_t reserve = 0, bool cache = true):
+        tset_matrix(cache),
+        m_mwords((dim + 63) / 64),
+        m_ucnt(0),
+        m_labelled(labelled)
+    {
+        m_dim = dim;
+
+        m_values.reserve(reserve * dim);
+        m_undef.reserve(reserve * m_mwords);
+        if (labelled) m_lstore.reserve(reserve);
+    }
+
+    /**
+     *  \brief  Add sample
+     *
+     *  \param  x      Sample (NaN stands for undefined value)
+     *  \param  label  Sample label (ignored for unlabelled sets)
+     */
+    template <typename S>
+    void add(const S * x, int64_t label = 0) {
+        m_undef.resize(m_undef.size() + m_mwords, 0);
+        uint64_t * undef = m_undef.data() + m_undef.size() - m_mwords;
+
+        for (size_t j = 0; j < m_dim; ++j) {
+            if (std::isnan(x[j])) {
+                undef[j / 64] |= (uint64_t)1 << (j % 64);
+                ++m_ucnt;
+            }
+
+            m_values.push_back((double)x[j]);
+        }
+
+        if (m_labelled) {
+            if (0 > label)
+                throw std::logic_error("Invalid label (must be >= 0)");
+
+            m_lstore.push_back(label);
+        }
+
+        ++m_count;
+    }
+
+    /** Finalise the set */
+    void close() {
+        m_values.shrink_to_fit();
+        m_lstore.shrink_to_fit();
+        m_undef.shrink_to_fit();
+
+        m_matrix = m_values.data();
+        m_labels = m_labelled ? m_lstore.data() : NULL;
+    }
+
+    /** Undefined values count */
+    size_t undefined_count() const { return m_ucnt; }
+
+    /** Undefined values mask (rows of \c ceil(dim/64) words, bit set iff undefined) */
+    const uint64_t * mask() const { return m_undef.data(); }
+
+    /** Undefined values mask words per row */
+    size_t mask_words() const { return m_mwords; }
+
+};  // end of class tset_arena
+
+
+/**
+ *  \brief  Get file path from Python object
+ *
+ *  \param  py_obj  Python object
+ *  \param  path    Path (output)
+ *
+ *  \return \c true iff the object is a path (\c str, \c bytes
+ *          or \c os.PathLike)
+ */
+static bool python2path(PyObject * py_obj, std::string & path) {
+    if (!PyUnicode_Check(py_obj) && !PyBytes_Check(py_obj) &&
+        !PyObject_HasAttrString(py_obj, "__fspath__")) return false;
+
+    PyObject * py_bytes;
+    if (!PyUnicode_FSConverter(py_obj, &py_bytes))
+        throw std::logic_error("Invalid path");
+
+    py_ref bytes(py_bytes);
+    path = PyBytes_AS_STRING(py_bytes);
+
+    return true;
+}
+
+
+/**
+ *  \brief  Transform Python labels to vector
+ *
+ *  \param  py_labels  1-D int64 buffer or iterable of integers
+ *  \param  labels     Labels (output)
+ */
+static void python2labels(PyObject * py_labels, std::vector<int64_t> & labels) {
+    if (PyObject_CheckBuffer(py_labels)) {
+        buffer_view view(py_labels);
+
+        if (buffer_view::INT64 != view.dtype() || 1 != view.ndim())
+            throw std::logic_error("Invalid labels (1-D int64 buffer expected)");
+
+        const int64_t * data = view.data<const int64_t>();
+        labels.assign(data, data + view.rows());
+
+        return;
+    }
+
+    py_ref iter(PyObject_GetIter(py_labels));
+    if (NULL == iter.get())
+        throw std::logic_error("Invalid labels (should be iterable)");
+
+    labels.clear();
+
+    PyObject * py_label;
+    while (NULL != (py_label = PyIter_Next(iter.get()))) {
+        py_ref label(py_label);
+
+        if (!PyLong_Check(py_label))
+            throw std::logic_error("Invalid cluster (integer expected)");
+
+        labels.push_back(PyLong_AsLongLong(py_label));
+    }
+
+    if (NULL != PyErr_Occurred())
+        throw std::logic_error("Invalid labels (iteration failed)");
+}
+
+
+/**
+ *  \brief  Fill training set from matrix buffer
+ *
+ *  \param  set     Training set (\ref tset_writer or \ref tset_arena)
+ *  \param  matrix  Sample matrix (float64 or float32)
+ *  \param  labels  Labels (or \c NULL)
+ */
+template <class Set>
+static void matrix2tset(
+    Set &                        set,
+    const buffer_view &          matrix,
+    const std::vector<int64_t> * labels)
+{
+    for (size_t i = 0; i < matrix.rows(); ++i) {
+        const int64_t label = NULL != labels ? (*labels)[i] : 0;
+
+        if (buffer_view::FLOAT64 == matrix.dtype())
+            set.add(matrix.row<const double>(i), label);
+        else
+            set.add(matrix.row<const float>(i), label);
+    }
+}
+
+
+/**
+ *  \brief  Sample is an (input, cluster) tuple
+ *
+ *  I.e. a 2-tuple of an input sequence (or buffer) and an integer;
+ *  so 2-D inputs (of numbers or \c None) aren't mistaken for samples.
+ *
+ *  \param  py_sample  Python sample
+ *
+ *  \return \c true iff the sample is labelled
+ */
+static bool labelled_sample(PyObject * py_sample) {
+    if (!PyTuple_Check(py_sample) || 2 != PyTuple_Size(py_sample))
+        return false;
+
+    PyObject * py_input = PyTuple_GetItem(py_sample, 0);
+
+    return
+        (PySequence_Check(py_input) || PyObject_CheckBuffer(py_input)) &&
+        PyIndex_Check(PyTuple_GetItem(py_sample, 1));
+}
+
+
+/**
+ *  \brief  Fill training set from Python sequence
+ *
+ *  Samples are either inputs or (input, cluster) tuples
+ *  (just like training sets of \c train_* functions).
+ *  The set is created once the dimension is known (by the first sample).
+ *
+ *  \param  set     Training set (\ref tset_writer or \ref tset_arena, output)
+ *  \param  create  Set factory: \c create(dim, labelled, size)
+ *  \param  py_set  Python sequence of samples
+ *  \param  labels  Labels (or \c NULL)
+ *
+ *  \return Sample count
+ */
+template <class Set, typename Create>
+static size_t sequence2tset(
+    std::unique_ptr<Set> &       set,
+    const Create &               create,
+    PyObject *                   py_set,
+    const std::vector<int64_t> * labels)
+{
+    py_ref seq(PySequence_Fast(py_set, "Invalid training set (sequence expected)"));
+    if (NULL == seq.get())
+        throw std::logic_error("Invalid training set (sequence expected)");
+
+    const size_t size = PySequence_Fast_GET_SIZE(seq.get());
+    PyObject ** items = PySequence_Fast_ITEMS(seq.get());
+
+    if (0 == size)
+        throw std::logic_error("Invalid training set (empty)");
+
+    if (NULL != labels && labels->size() != size)
+        throw std::logic_error("Invalid labels (sample count mismatch)");
+
+    // (input, cluster) tuples (unless labels are given separately)
+    const bool superv = NULL == labels && labelled_sample(items[0]);
+
+    std::vector<double> x;
+
+    for (size_t i = 0; i < size; ++i) {
+        PyObject * py_input = items[i];
+        int64_t    label    = NULL != labels ? (*labels)[i] : 0;
+
+        if (superv) {
+            if (!PyTuple_Check(py_input) || 2 != PyTuple_Size(py_input))
+                throw std::logic_error(
+                    "Invalid training set ((input, cluster) tuples expected");
+
+            PyObject * py_cluster = PyTuple_GetItem(py_input, 1);
+            if (!PyIndex_Check(py_cluster))
+                throw std::logic_error("Invalid cluster (integer expected)");
+
+            label    = PyNumber_AsSsize_t(py_cluster, NULL);
+            py_input = PyTuple_GetItem(py_input, 0);
+        }
+
+        python2dense(py_input, x);
+
+        if (!set)
+            set.reset(create(x.size(), superv || NULL != labels, size));
+        else if (x.size() != set->dimension())
+            throw std::logic_error("Invalid input (dimension mismatch)");
+
+        set->add(x.data(), label);
+    }
+
+    return size;
+}
+
+
+/**
+ *  \brief  Write training set file from matrix buffer
+ *
+ *  \param  path    File path
+ *  \param  dtype   File item type
+ *  \param  matrix  Sample matrix (float64 or float32)
+ *  \param  labels  Labels (or \c NULL)
+ */
+static void write_tset_matrix(
+    const std::string &          path,
+    uint32_t                     dtype,
+    const buffer_view &          matrix,
+    const std::vector<int64_t> * labels)
+{
+    tset_writer file(path, dtype, matrix.cols(), NULL != labels);
+
+    matrix2tset(file, matrix, labels);
+
+    file.close();
+}
+
+
+/**
+ *  \brief  Write training set file from Python sequence
+ *
+ *  See \ref sequence2tset.
+ *
+ *  \param  path    File path
+ *  \param  dtype   File item type
+ *  \param  py_set  Python sequence of samples
+ *  \param  labels  Labels (or \c NULL)
+ *
+ *  \return Sample count
+ */
+static size_t write_tset_sequence(
+    const std::string &          path,
+    uint32_t                     dtype,
+    PyObject *                   py_set,
+    const std::vector<int64_t> * labels)
+{
+    std::unique_ptr<tset_writer> file;
+
+    const size_t size = sequence2tset(file,
+        [&path, dtype](size_t dim, bool labelled, size_t) {
+            return new tset_writer(path, dtype, dim, labelled);
+        },
+        py_set, labels);
+
+    file->close();
+
+    return size;
+}
+
+
+//
+// Mini-batch (data-parallel) training
+//
+
+/**
+ *  \brief  Squared distance of vectors
+ *
+ *  NaN (undefined) coordinates are skipped.
+ *
+ *  \param  x  Vector
+ *  \param  w  Vector
+ *  \param  n  Dimension
+ *
+ *  \return Squared Euclidean distance over coordinates defined in both
+ */
+static double dist2(const double * x, const double * w, size_t n) {
+    double d2 = 0.0;
+
+    for (size_t j = 0; j < n; ++j) {
+        const double d = x[j] - w[j];
+        if (!std::isnan(d)) d2 += d * d;
+    }
+
+    return d2;
+}
+
+
+/**
+ *  \brief  Transform \c lvq_t::input_t to dense vector
+ *
+ *  Undefined values become NaN.
+ *
+ *  \param  input  Input
+ *  \param  x      Dense vector (output, of the input rank)
+ */
+static void input2dense(const lvq_t::input_t & input, double * x) {
+    const size_t n = input.rank();
+
+    for (size_t j = 0; j < n; ++j)
+        x[j] = input[j].is_defined() ? (double)input[j] : NAN;
+}
+
+
+/**
+ *  \brief  Transform dense vector to \c lvq_t::input_t
+ *
+ *  NaN values become undefined.
+ *
+ *  \param  x      Dense vector
+ *  \param  input  Input (output, of the vector dimension)
+ */
+static void dense2input(const double * x, lvq_t::input_t & input) {
+    const size_t n = input.rank();
+
+    for (size_t j = 0; j < n; ++j)
+        input[j] = std::isnan(x[j])
+                 ? lvq_t::base_t::undef
+                 : lvq_t::base_t(x[j]);
+}
+
+
+/**
+ *  \brief  Training loop progress record
+ */
+struct train_progress {
+    unsigned tlc;      /**< Training loop (1-based)                        */
+    double   dnorm2;   /**< Loop average squared norm of prototype shifts  */
+    unsigned div_cnt;  /**< Diverging loops in a row                       */
+};  // end of struct train_progress
+
+
+/**
+ *  \brief  Training monitor
+ *
+ *  Single-producer single-consumer lock-free ring buffer of training
+ *  loop progress records and cooperative cancellation flag.
+ *  The trainer pushes a record after each loop (records are dropped
+ *  while the ring is full) and checks the flag after each batch.
+ */
+class train_monitor {
+    private:
+
+    enum { CAPACITY = 256 };  /**< Ring capacity (power of 2) */
+
+    train_progress      m_ring[CAPACITY];  /**< Ring                       */
+    std::atomic<size_t> m_head;            /**< Next record written        */
+    std::atomic<size_t> m_tail;            /**< Next record read           */
+    std::atomic<bool>   m_cancel;          /**< Cancellation requested     */
+    train_progress      m_last;            /**< Last record (producer's)   */
+
+    public:
+
+    /** Constructor */
+    train_monitor(): m_head(0), m_tail(0), m_cancel(false) {
+        m_last.tlc     = 0;
+        m_last.dnorm2  = NAN;
+        m_last.div_cnt = 0;
+    }
+
+    /** Push record (producer) */
+    void push(const train_progress & progress) {
+        m_last = progress;
+
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (CAPACITY == head - m_tail.load(std::memory_order_acquire))
+            return;  // full, drop
+
+        m_ring[head % CAPACITY] = progress;
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    /** Pop record (consumer), \c false if there's none */
+    bool pop(train_progress & progress) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (m_head.load(std::memory_order_acquire) == tail) return false;
+
+        progress = m_ring[tail % CAPACITY];
+        m_tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /** Last record (producer) */
+    const train_progress & last() const { return m_last; }
+
+    /** Request cancellation */
+    void cancel() { m_cancel = true; }
+
+    /** Cancellation requested */
+    bool cancelled() const { return m_cancel; }
+
+};  // end of class train_monitor
+
+
+/**
+ *  \brief  Mini-batch LVQ trainer
+ *
+ *  Works on a dense copy of the prototypes and training samples
+ *  (NaN stands for undefined coordinate); samples of training set
+ *  files are used in place.
+ *  Each step takes a batch of (shuffled) samples and
+ *  -# finds best matching units of the batch samples in parallel
+ *     (the prototypes are read-only during the phase),
+ *  -# groups the samples by BMU and, again in parallel (per cluster),
+ *     shifts each prototype by the learning factor multiple
+ *     of the average (signed) difference of its samples.
+ *
+ *  In supervised mode, the difference sign is positive if the BMU matches
+ *  the sample cluster and negative otherwise (LVQ1 rule); in unsupervised
+ *  mode, the BMU is always attracted.
+ *
+ *  Training loop (epoch) error is the loop average \c dnorm2, i.e. squared
+ *  norm of the prototype shift a sample causes (just like \c train1_*
+ *  return); it's compared to the average over the last \c conv_win
+ *  loops and exceeding it \c max_div_cnt times in a row (or reaching
+ *  \c max_tlc loops) ends the training.
+ *  The learning factor of loop \c tlc is \c 1/(2+tlc).
+ *  Note that \c ml::lvq doesn't expose its sequential training loop
+ *  internals; \c batch_size=1 training is therefore left to
+ *  \c ml::lvq::train_* (see \ref train_mode_minibatch).
+ */
+class minibatch_trainer {
+    private:
+
+    const size_t         m_dim;       /**< Dimension                 */
+    const size_t         m_ccnt;      /**< Clusters count            */
+    const size_t         m_size;      /**< Samples count             */
+    std::vector<double>  m_proto;     /**< Prototypes (row-major)    */
+    const double *       m_samples;   /**< Samples (row-major)       */
+    const int64_t *      m_clusters;  /**< Sample clusters           */
+    std::vector<double>  m_sstore;    /**< Samples storage (copy)    */
+    std::vector<int64_t> m_cstore;    /**< Clusters storage (copy)   */
+    const bool           m_superv;    /**< Supervised training       */
+
+    std::vector<size_t>  m_bmu;       /**< Batch samples BMUs        */
+    std::vector<double>  m_bmu_d2;    /**< Batch samples BMU dist^2  */
+    std::vector<size_t>  m_by_bmu;    /**< Batch samples by BMU      */
+    std::vector<size_t>  m_bmu_off;   /**< BMU groups offsets        */
+
+    /** Prototype */
+    double * proto(size_t c) { return m_proto.data() + c * m_dim; }
+
+    /** Sample */
+    const double * sample(size_t i) const {
+        return m_samples + i * m_dim;
+    }
+
+    /** Best matching unit */
+    size_t bmu(const double * x, double & bmu_d2) const {
+        size_t bmu = 0;
+        bmu_d2 = INFINITY;
+
+        for (size_t c = 0; c < m_ccnt; ++c) {
+            const double d2 = dist2(x, m_proto.data() + c * m_dim, m_dim);
+            if (d2 < bmu_d2) {
+                bmu    = c;
+                bmu_d2 = d2;
+            }
+        }
+
+        return bmu;
+    }
+
+    /**
+     *  \brief  Training step
+     *
+     *  \param  pool     Thread pool
+     *  \param  batch    Batch sample indices
+     *  \param  bsize    Batch size
+     *  \param  lfactor  Learning factor
+     *
+     *  \return Sum of the batch samples \c dnorm2
+     */
+    double step(
+        thread_pool  & pool,
+        const size_t * batch,
+        size_t         bsize,
+        double         lfactor)
+    {
+        // Find BMUs
+        pool.parallel_for(bsize, pool.chunk(bsize, 4),
+        [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                m_bmu[i] = bmu(sample(batch[i]), m_bmu_d2[i]);
+        });
+
+        double d2_sum = 0.0;
+        for (size_t i = 0; i < bsize; ++i) d2_sum += m_bmu_d2[i];
+
+        const double dnorm2_sum = lfactor * lfactor * d2_sum;
+
+        // Group samples by BMU (counting sort)
+        std::fill(m_bmu_off.begin(), m_bmu_off.end(), 0);
+        for (size_t i = 0; i < bsize; ++i) ++m_bmu_off[m_bmu[i] + 1];
+        for (size_t c = 0; c < m_ccnt; ++c) m_bmu_off[c + 1] += m_bmu_off[c];
+
+        std::vector<size_t> pos(m_bmu_off.begin(), m_bmu_off.end() - 1);
+        for (size_t i = 0; i < bsize; ++i) m_by_bmu[pos[m_bmu[i]]++] = i;
+
+        std::vector<size_t> touched;
+        for (size_t c = 0; c < m_ccnt; ++c)
+            if (m_bmu_off[c] < m_bmu_off[c + 1]) touched.push_back(c);
+
+        // Update prototypes (the BMU groups are disjoint)
+        pool.parallel_for(touched.size(), 1,
+        [&](size_t begin, size_t end) {
+            std::vector<double> delta(m_dim);
+            std::vector<size_t> count(m_dim);
+
+            for (size_t t = begin; t < end; ++t) {
+                const size_t c = touched[t];
+                double *     w = proto(c);
+
+                std::fill(delta.begin(), delta.end(), 0.0);
+                std::fill(count.begin(), count.end(), 0);
+
+                for (size_t k = m_bmu_off[c]; k < m_bmu_off[c + 1]; ++k) {
+                    const size_t   s = batch[m_by_bmu[k]];
+                    const double * x = sample(s);
+                    const double sign =
+                        !m_superv || (size_t)m_clusters[s] == c ? 1.0 : -1.0;
+
+                    for (size_t j = 0; j < m_dim; ++j) {
+                        const double d = x[j] - w[j];
+                        if (std::isnan(d)) continue;
+
+                        delta[j] += sign * d;
+                        ++count[j];
+                    }
+                }
+
+                for (size_t j = 0; j < m_dim; ++j)
+                    if (count[j]) w[j] += lfactor * delta[j] / count[j];
+            }
+        });
+
+        return dnorm2_sum;
+    }
+
+    /** Constructor (copies prototypes) */
+    minibatch_trainer(const lvq_t & lvq, size_t size, bool superv):
+        m_dim(lvq.dimension()),
+        m_ccnt(lvq.clusters()),
+        m_size(size),
+        m_proto(m_ccnt * m_dim),
+        m_samples(NULL),
+        m_clusters(NULL),
+        m_superv(superv),
+        m_bmu_off(m_ccnt + 1)
+    {
+        for (size_t c = 0; c < m_ccnt; ++c)
+            input2dense(lvq.get(c), proto(c));
+    }
+
+    /** Add sample */
+    void set_sample(size_t i, const lvq_t::input_t & input) {
+        if (m_dim != input.rank())
+            throw std::logic_error("Invalid sample (dimension mismatch)");
+
+        input2dense(input, m_sstore.data() + i * m_dim);
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor (supervised training)
+     *
+     *  \param  lvq  LVQ model
+     *  \param  set  Training set
+     */
+    minibatch_trainer(const lvq_t & lvq, const tset_classifier_t & set):
+        minibatch_trainer(lvq, set.size(), true)
+    {
+        m_sstore.resize(m_size * m_dim);
+        m_cstore.reserve(m_size);
+
+        for (size_t i = 0; i < set.size(); ++i) {
+            set_sample(i, set[i].first);
+
+            if (m_ccnt <= set[i].second)
+                throw std::logic_error("Invalid sample cluster");
+
+            m_cstore.push_back(set[i].second);
+        }
+
+        m_samples  = m_sstore.data();
+        m_clusters = m_cstore.data();
+    }
+
+    /**
+     *  \brief  Constructor (unsupervised training)
+     *
+     *  \param  lvq  LVQ model
+     *  \param  set  Training set
+     */
+    minibatch_trainer(const lvq_t & lvq, const tset_clustering_t & set):
+        minibatch_trainer(lvq, set.size(), false)
+    {
+        m_sstore.resize(m_size * m_dim);
+
+        for (size_t i = 0; i < set.size(); ++i)
+            set_sample(i, set[i]);
+
+        m_samples = m_sstore.data();
+    }
+
+    /**
+     *  \brief  Constructor (native training set)
+     *
+     *  The sample matrix (of a file or in-memory training set)
+     *  is used in place (no copy).
+     *
+     *  \param  lvq     LVQ model
+     *  \param  set     Training set
+     *  \param  superv  Supervised training (labels required)
+     */
+    minibatch_trainer(const lvq_t & lvq, const tset_matrix & set, bool superv):
+        minibatch_trainer(lvq, set.size(), superv)
+    {
+        if (m_superv && !set.labelled())
+            throw std::logic_error("Invalid training set (labels expected)");
+
+        if (m_dim != set.dimension())
+            throw std::logic_error("Invalid sample (dimension mismatch)");
+
+        m_samples  = set.matrix();
+        m_clusters = set.labels();
+
+        if (!m_superv) return;
+
+        for (size_t i = 0; i < m_size; ++i)
+            if (0 > m_clusters[i] || m_ccnt <= (size_t)m_clusters[i])
+                throw std::logic_error("Invalid sample cluster");
+    }
+
+    /**
+     *  \brief  Train
+     *
+     *  \param  pool         Thread pool
+     *  \param  batch_size   Batch size
+     *  \param  conv_win     Convergence window
+     *  \param  max_div_cnt  Max. number of diverging loops in a row
+     *  \param  max_tlc      Max. number of training loops
+     *  \param  monitor      Training monitor (optional)
+     *  \param  loop_done    Called after each loop (optional)
+     *
+     *  \return \c false iff the training was cancelled
+     */
+    bool train(
+        thread_pool &                 pool,
+        size_t                        batch_size,
+        unsigned                      conv_win,
+        unsigned                      max_div_cnt,
+        unsigned                      max_tlc,
+        train_monitor *               monitor   = NULL,
+        const std::function<void()> & loop_done = std::function<void()>())
+    {
+        const size_t size = m_size;
+
+        if (0 == size || 0 == m_ccnt) return true;
+
+        if (0 == batch_size) batch_size = 1;
+        batch_size = std::min(batch_size, size);
+
+        m_bmu.resize(batch_size);
+        m_bmu_d2.resize(batch_size);
+        m_by_bmu.resize(batch_size);
+
+        std::vector<size_t> order(size);
+        for (size_t i = 0; i < size; ++i) order[i] = i;
+
+        std::mt19937 gen(rng_draw());
+
+        std::vector<double> win;  // last loops average errors
+        unsigned div_cnt = 0;
+
+        for (unsigned tlc = 0; tlc < max_tlc; ++tlc) {
+            const double lfactor = 1.0 / (2.0 + tlc);
+
+            // Shuffle samples
+            for (size_t i = size - 1; i > 0; --i)
+                std::swap(order[i], order[gen() % (i + 1)]);
+
+            double dnorm2_sum = 0.0;
+            for (size_t b = 0; b < size; b += batch_size) {
+                if (NULL != monitor && monitor->cancelled()) return false;
+
+                const size_t bsize = std::min(batch_size, size - b);
+                dnorm2_sum += step(pool, order.data() + b, bsize, lfactor);
+            }
+
+            const double err = dnorm2_sum / size;
+
+            // Convergence check
+            if (0.0 < err && !win.empty()) {
+                double win_avg = 0.0;
+                for (double e: win) win_avg += e;
+                win_avg /= win.size();
+
+                div_cnt = err > win_avg ? div_cnt + 1 : 0;
+            }
+
+            if (NULL != monitor) monitor->push({ tlc + 1, err, div_cnt });
+
+            if (loop_done) loop_done();
+
+            if (0.0 == err || div_cnt > max_div_cnt) break;
+
+            win.push_back(err);
+            if (win.size() > conv_win) win.erase(win.begin());
+        }
+
+        return true;
+    }
+
+    /** Dimension */
+    size_t dimension() const { return m_dim; }
+
+    /** Clusters count */
+    size_t clusters() const { return m_ccnt; }
+
+    /**
+     *  \brief  Store trained prototypes
+     *
+     *  \param  lvq  LVQ model
+     */
+    void store(lvq_t & lvq) const {
+        lvq_t::input_t input(m_dim);
+
+        for (size_t c = 0; c < m_ccnt; ++c) {
+            dense2input(m_proto.data() + c * m_dim, input);
+            lvq.set(input, c);
+        }
+    }
+
+};  // end of class minibatch_trainer
+
+
+/**
+ *  \brief  Training mode
+ *
+ *  Mini-batch training of single sample batches is the sequential
+ *  training; it's left to \c ml::lvq.
+ *
+ *  \param  mode        Training mode name (\c NULL means default)
+ *  \param  batch_size  Mini-batch size
+ *
+ *  \return \c true iff mini-batch training is requested
+ */
+static bool train_mode_minibatch(const char * mode, size_t batch_size) {
+    if (NULL == mode || 0 == ::strcmp(mode, "sequential")) return false;
+    if (0 == ::strcmp(mode, "minibatch")) return 1 < batch_size;
+
+    throw std::logic_error("Invalid training mode "
+        "(\"sequential\" or \"minibatch\" expected)");
+}
+
+
+//
+// Prototype seeding
+//
+
+/**
+ *  \brief  Data-driven prototype seeding
+ *
+ *  Chooses training samples to initialise prototypes with:
+ *  - k-means++ (samples drawn with probability proportional
+ *    to the squared distance to the nearest seed chosen so far),
+ *  - k-means|| (a few rounds of independent oversampling by the same
+ *    distribution, candidates are reclustered by weighted k-means++),
+ *  - per-class stratified sampling (supervised models).
+ *
+ *  Distances to seeds are updated in parallel; random choices use
+ *  a local generator (per-chunk generators seeded from it in parallel
+ *  phases), so the seeds are reproducible (see \ref rng_draw)
+ *  regardless of the thread count.
+ */
+class prototype_seeder {
+    private:
+
+    const tset_matrix &  m_set;      /**< Samples                      */
+    thread_pool &        m_pool;     /**< Thread pool                  */
+    const size_t         m_size;     /**< Sample count                 */
+    const size_t         m_chunk;    /**< Sample chunk size            */
+    std::vector<size_t>  m_seeds;    /**< Seed samples                 */
+    size_t               m_counted;  /**< Seeds accounted in distances */
+    std::vector<double>  m_d2;       /**< Sample distance to seeds^2   */
+    std::vector<size_t>  m_near;     /**< Sample nearest seed          */
+    std::vector<double>  m_csum;     /**< Chunk sums of \c m_d2        */
+    mutable std::mt19937 m_gen;      /**< RNG                          */
+
+    /** Uniform random number from [0, 1) */
+    double uniform() const {
+        return std::uniform_real_distribution<double>(0.0, 1.0)(m_gen);
+    }
+
+    /** Uniform random index from [0, n) */
+    size_t uniform(size_t n) const {
+        return std::min((size_t)(uniform() * n), n - 1);
+    }
+
+    /** Chunks count */
+    size_t chunks() const { return (m_size + m_chunk - 1) / m_chunk; }
+
+    /**
+     *  \brief  Run \c fn(chunk, begin, end) for each sample chunk in parallel
+     *
+     *  Chunking doesn't depend on the pool (so neither do the results).
+     */
+    template <class Fn>
+    void for_chunks(const Fn & fn) {
+        const size_t cnt = chunks();
+
+        m_pool.parallel_for(cnt, m_pool.chunk(cnt, 1), [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k)
+                fn(k, k * m_chunk, std::min((k + 1) * m_chunk, m_size));
+        });
+    }
+
+    /** Squared distance of samples */
+    double dist2(size_t i, size_t k) const {
+        return ::dist2(m_set.row(i), m_set.row(k), m_set.dimension());
+    }
+
+    /**
+     *  \brief  Account new seeds in sample distances
+     *
+     *  \return Potential (sum of squared distances to nearest seeds)
+     */
+    double update() {
+        const size_t from = m_counted;
+        m_counted = m_seeds.size();
+
+        for_chunks([&](size_t chunk, size_t begin, size_t end) {
+            double sum = 0.0;
+
+            for (size_t i = begin; i < end; ++i) {
+                for (size_t s = from; s < m_counted; ++s) {
+                    const double d2 = dist2(i, m_seeds[s]);
+
+                    if (d2 < m_d2[i]) {
+                        m_d2[i]   = d2;
+                        m_near[i] = s;
+                    }
+                }
+
+                sum += m_d2[i];
+            }
+
+            m_csum[chunk] = sum;
+        });
+
+        double potential = 0.0;
+        for (double sum: m_csum) potential += sum;
+
+        return potential;
+    }
+
+    /**
+     *  \brief  Draw sample proportionally to squared distance to seeds
+     *
+     *  \param  potential  Sum of squared distances
+     *
+     *  \return Sample (uniformly drawn if all the samples are seeds)
+     */
+    size_t draw(double potential) const {
+        if (!(0.0 < potential)) return uniform(m_size);
+
+        double r = uniform() * potential;
+
+        size_t k = 0;
+        for (; k + 1 < chunks() && r >= m_csum[k]; ++k) r -= m_csum[k];
+
+        const size_t begin = k * m_chunk;
+        const size_t end   = std::min(begin + m_chunk, m_size);
+
+        for (size_t i = begin; i < end; ++i) {
+            if (r < m_d2[i]) return i;
+            r -= m_d2[i];
+        }
+
+        // Rounding: last sample of non-zero weight
+        for (size_t i = end; i-- > begin; )
+            if (0.0 < m_d2[i]) return i;
+
+        return begin;
+    }
+
+    /**
+     *  \brief  Weighted k-means++ over candidate seeds
+     *
+     *  \param  cand    Candidate samples
+     *  \param  weight  Candidate weights
+     *  \param  k       Seeds count
+     *
+     *  \return Seeds
+     */
+    std::vector<size_t> recluster(
+        const std::vector<size_t> & cand,
+        const std::vector<double> & weight,
+        size_t                      k) const
+    {
+        const size_t n = cand.size();
+
+        std::vector<double> d2(n, INFINITY);
+        std::vector<double> p(n);
+        std::vector<size_t> seeds;
+
+        for (size_t last = SIZE_MAX; seeds.size() < k; ) {
+            if (SIZE_MAX != last)
+                m_pool.parallel_for(n, m_pool.chunk(n), [&](size_t begin, size_t end) {
+                    for (size_t c = begin; c < end; ++c)
+                        d2[c] = std::min(d2[c], dist2(cand[c], cand[last]));
+                });
+
+            double sum = 0.0;
+            for (size_t c = 0; c < n; ++c)
+                sum += p[c] = weight[c] * (std::isinf(d2[c]) ? 1.0 : d2[c]);
+
+            size_t c = 0;
+            if (0.0 < sum) {
+                double r = uniform() * sum;
+                for (; c + 1 < n && r >= p[c]; ++c) r -= p[c];
+
+                while (0.0 == p[c]) --c;  // rounding
+            }
+            else
+                c = uniform(n);
+
+            seeds.push_back(cand[c]);
+            last = c;
+        }
+
+        return seeds;
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  set   Training set
+     *  \param  pool  Thread pool
+     *  \param  seed  RNG seed
+     */
+    prototype_seeder(const tset_matrix & set, thread_pool & pool, unsigned seed):
+        m_set(set),
+        m_pool(pool),
+        m_size(set.size()),
+        m_chunk(256),
+        m_counted(0),
+        m_d2(set.size(), INFINITY),
+        m_near(set.size(), 0),
+        m_csum(chunks(), 0.0),
+        m_gen(seed)
+    {
+        if (0 == m_size)
+            throw std::logic_error("Invalid training set (empty)");
+    }
+
+    /**
+     *  \brief  k-means++ seeding
+     *
+     *  \param  k  Seeds count
+     *
+     *  \return Seed samples
+     */
+    std::vector<size_t> kmeanspp(size_t k) {
+        if (m_seeds.empty() && 0 < k) m_seeds.push_back(uniform(m_size));
+
+        double potential = update();
+
+        while (m_seeds.size() < k) {
+            m_seeds.push_back(draw(potential));
+            potential = update();
+        }
+
+        return m_seeds;
+    }
+
+    /**
+     *  \brief  k-means|| seeding
+     *
+     *  \param  k       Seeds count
+     *  \param  rounds  Oversampling rounds
+     *
+     *  \return Seed samples
+     */
+    std::vector<size_t> kmeans_parallel(size_t k, unsigned rounds) {
+        const double oversampling = 2.0 * k;  // expected samples per round
+
+        if (m_seeds.empty() && 0 < k) m_seeds.push_back(uniform(m_size));
+
+        double potential = update();
+
+        for (unsigned round = 0; round < rounds && 0.0 < potential; ++round) {
+            std::vector<unsigned>            gen_seed(chunks());
+            std::vector<std::vector<size_t>> chosen(chunks());
+
+            for (auto & seed: gen_seed) seed = m_gen();
+
+            for_chunks([&](size_t chunk, size_t begin, size_t end) {
+                std::minstd_rand gen(gen_seed[chunk]);
+                std::uniform_real_distribution<double> u(0.0, 1.0);
+
+                for (size_t i = begin; i < end; ++i)
+                    if (u(gen) * potential < oversampling * m_d2[i])
+                        chosen[chunk].push_back(i);
+            });
+
+            for (const auto & samples: chosen)
+                m_seeds.insert(m_seeds.end(), samples.begin(), samples.end());
+
+            potential = update();
+        }
+
+        if (m_seeds.size() <= k) return kmeanspp(k);
+
+        // Candidates are weighted by samples closest to them
+        std::vector<double> weight(m_seeds.size(), 0.0);
+        for (size_t i = 0; i < m_size; ++i) weight[m_near[i]] += 1.0;
+
+        return recluster(m_seeds, weight, k);
+    }
+
+    /**
+     *  \brief  Stratified seeding
+     *
+     *  Seed \c c is a random sample of class \c c; seeds of classes
+     *  without samples are chosen by k-means++.
+     *
+     *  \param  k  Classes (seeds) count
+     *
+     *  \return Seed samples
+     */
+    std::vector<size_t> stratified(size_t k) {
+        if (!m_set.labelled())
+            throw std::logic_error("Invalid training set (labels expected)");
+
+        // Reservoir sampling of each class
+        std::vector<size_t> pick(k, SIZE_MAX);
+        std::vector<size_t> seen(k, 0);
+
+        for (size_t i = 0; i < m_size; ++i) {
+            const int64_t label = m_set.labels()[i];
+            if (0 > label || k <= (size_t)label)
+                throw std::logic_error("Invalid sample cluster");
+
+            if (0 == uniform(++seen[label])) pick[label] = i;
+        }
+
+        std::vector<size_t> missing;
+        for (size_t c = 0; c < k; ++c) {
+            if (SIZE_MAX == pick[c])
+                missing.push_back(c);
+            else
+                m_seeds.push_back(pick[c]);
+        }
+
+        if (missing.empty()) return pick;
+
+        const std::vector<size_t> seeds = kmeanspp(k);
+        for (size_t m = 0; m < missing.size(); ++m)
+            pick[missing[m]] = seeds[k - missing.size() + m];
+
+        return pick;
+    }
+
+};  // end of class prototype_seeder
+
+
+//
+// Dense prototype storage and SIMD distance kernels
+//
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LIBLVQ_SIMD_X86
+#endif
+
+/** Squared distance kernel (over \c n items) */
+template <typename T>
+struct sqdist_fn {
+    typedef T (* type)(const T * a, const T * b, size_t n);
+};
+
+/** Masked squared distance kernel (items with mask bit set only) */
+template <typename T>
+struct sqdist_masked_fn {
+    typedef T (* type)(
+        const T * a, const T * b, const uint64_t * mask, size_t n);
+};
+
+/** Update kernel (\f$w += f (x - w)\f$ where defined, i.e. not NaN) */
+template <typename T>
+struct update_fn {
+    typedef T (* type)(T * w, const T * x, T f, size_t n);
+};
+
+
+/** Validity bitmask bit */
+inline static bool mask_bit(const uint64_t * mask, size_t i) {
+    return (mask[i >> 6] >> (i & 63)) & 1;
+}
+
+
+/** Squared distance (scalar) */
+template <typename T>
+static T sqdist_scalar(const T * a, const T * b, size_t n) {
+    T d2 = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        const T d = a[i] - b[i];
+        d2 += d * d;
+    }
+
+    return d2;
+}
+
+
+/** Masked squared distance (scalar) */
+template <typename T>
+static T sqdist_masked_scalar(
+    const T * a, const T * b, const uint64_t * mask, size_t n)
+{
+    T d2 = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        if (!mask_bit(mask, i)) continue;
+
+        const T d = a[i] - b[i];
+        d2 += d * d;
+    }
+
+    return d2;
+}
+
+
+/**
+ *  \brief  Update (scalar)
+ *
+ *  Items undefined (NaN) in either \c w or \c x are left intact.
+ *
+ *  \return Squared norm of the shift of \c w
+ */
+template <typename T>
+static T update_scalar(T * w, const T * x, T f, size_t n) {
+    T dnorm2 = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        const T d = x[i] - w[i];
+        if (std::isnan(d)) continue;
+
+        const T s = f * d;
+        w[i]    += s;
+        dnorm2  += s * s;
+    }
+
+    return dnorm2;
+}
+
+
+#ifdef LIBLVQ_SIMD_X86
+
+/** Squared distance (AVX2, float32) */
+__attribute__((target("avx2,fma")))
+static float sqdist_avx2(const float * a, const float * b, size_t n) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256 d0 = _mm256_sub_ps(
+            _mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+        const __m256 d1 = _mm256_sub_ps(
+            _mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+
+        acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+        acc1 = _mm256_fmadd_ps(d1, d1, acc1);
+    }
+    for (; i + 8 <= n; i += 8) {
+        const __m256 d = _mm256_sub_ps(
+            _mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+
+        acc0 = _mm256_fmadd_ps(d, d, acc0);
+    }
+
+    acc0 = _mm256_add_ps(acc0, acc1);
+    __m128 s = _mm_add_ps(
+        _mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+
+    return _mm_cvtss_f32(s) + sqdist_scalar(a + i, b + i, n - i);
+}
+
+/** Squared distance (AVX2, float64) */
+__attribute__((target("avx2,fma")))
+static double sqdist_avx2(const double * a, const double * b, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256d d0 = _mm256_sub_pd(
+            _mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+        const __m256d d1 = _mm256_sub_pd(
+            _mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4));
+
+        acc0 = _mm256_fmadd_pd(d0, d0, acc0);
+        acc1 = _mm256_fmadd_pd(d1, d1, acc1);
+    }
+    for (; i + 4 <= n; i += 4) {
+        const __m256d d = _mm256_sub_pd(
+            _mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+
+        acc0 = _mm256_fmadd_pd(d, d, acc0);
+    }
+
+    acc0 = _mm256_add_pd(acc0, acc1);
+    __m128d s = _mm_add_pd(
+        _mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+    s = _mm_add_sd(s, _mm_unpackhi_pd(s, s));
+
+    return _mm_cvtsd_f64(s) + sqdist_scalar(a + i, b + i, n - i);
+}
+
+/** Squared distance (AVX-512, float32) */
+__attribute__((target("avx512f")))
+static float sqdist_avx512(const float * a, const float * b, size_t n) {
+    __m512 acc = _mm512_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m512 d = _mm512_sub_ps(
+            _mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+
+        acc = _mm512_fmadd_ps(d, d, acc);
+    }
+
+    // Horizontal sum (GCC lane extraction intrinsics warn spuriously)
+    alignas(64) float lanes[16];
+    _mm512_store_ps(lanes, acc);
+
+    float d2 = 0;
+    for (size_t l = 0; l < 16; ++l) d2 += lanes[l];
+
+    return d2 + sqdist_scalar(a + i, b + i, n - i);
+}
+
+/** Squared distance (AVX-512, float64) */
+__attribute__((target("avx512f")))
+static double sqdist_avx512(const double * a, const double * b, size_t n) {
+    __m512d acc = _mm512_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m512d d = _mm512_sub_pd(
+            _mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i));
+
+        acc = _mm512_fmadd_pd(d, d, acc);
+    }
+
+    // Horizontal sum (GCC lane extraction intrinsics warn spuriously)
+    alignas(64) double lanes[8];
+    _mm512_store_pd(lanes, acc);
+
+    double d2 = 0;
+    for (size_t l = 0; l < 8; ++l) d2 += lanes[l];
+
+    return d2 + sqdist_scalar(a + i, b + i, n - i);
+}
+
+
+/** AVX2 lanes selected by mask bits (8 x float32) */
+__attribute__((target("avx2,fma")))
+inline static __m256 lanes_avx2_ps(const uint64_t * mask, size_t i) {
+    const __m256i sel  = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256i bits = _mm256_set1_epi32((mask[i >> 6] >> (i & 63)) & 0xff);
+
+    return _mm256_castsi256_ps(
+        _mm256_cmpeq_epi32(_mm256_and_si256(bits, sel), sel));
+}
+
+/** AVX2 lanes selected by mask bits (4 x float64) */
+__attribute__((target("avx2,fma")))
+inline static __m256d lanes_avx2_pd(const uint64_t * mask, size_t i) {
+    const __m256i sel  = _mm256_setr_epi64x(1, 2, 4, 8);
+    const __m256i bits = _mm256_set1_epi64x((mask[i >> 6] >> (i & 63)) & 0xf);
+
+    return _mm256_castsi256_pd(
+        _mm256_cmpeq_epi64(_mm256_and_si256(bits, sel), sel));
+}
+
+/** Masked squared distance (AVX2, float32) */
+__attribute__((target("avx2,fma")))
+static float sqdist_masked_avx2(
+    const float * a, const float * b, const uint64_t * mask, size_t n)
+{
+    __m256 acc = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 d = _mm256_and_ps(lanes_avx2_ps(mask, i), _mm256_sub_ps(
+            _mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+
+        acc = _mm256_fmadd_ps(d, d, acc);
+    }
+
+    __m128 s = _mm_add_ps(
+        _mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+
+    float d2 = _mm_cvtss_f32(s);
+    for (; i < n; ++i)
+        if (mask_bit(mask, i)) d2 += (a[i] - b[i]) * (a[i] - b[i]);
+
+    return d2;
+}
+
+/** Masked squared distance (AVX2, float64) */
+__attribute__((target("avx2,fma")))
+static double sqdist_masked_avx2(
+    const double * a, const double * b, const uint64_t * mask, size_t n)
+{
+    __m256d acc = _mm256_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d d = _mm256_and_pd(lanes_avx2_pd(mask, i), _mm256_sub_pd(
+            _mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+
+        acc = _mm256_fmadd_pd(d, d, acc);
+    }
+
+    __m128d s = _mm_add_pd(
+        _mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+    s = _mm_add_sd(s, _mm_unpackhi_pd(s, s));
+
+    double d2 = _mm_cvtsd_f64(s);
+    for (; i < n; ++i)
+        if (mask_bit(mask, i)) d2 += (a[i] - b[i]) * (a[i] - b[i]);
+
+    return d2;
+}
+
+/**
+ *  \brief  Update (AVX2, float64)
+ *
+ *  No FMA, so that updated items are exactly those of the scalar kernel.
+ */
+__attribute__((target("avx2")))
+static double update_avx2(double * w, const double * x, double f, size_t n) {
+    const __m256d vf  = _mm256_set1_pd(f);
+    __m256d       acc = _mm256_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d vw  = _mm256_loadu_pd(w + i);
+        const __m256d d   = _mm256_sub_pd(_mm256_loadu_pd(x + i), vw);
+        const __m256d def = _mm256_cmp_pd(d, d, _CMP_ORD_Q);
+        const __m256d s   = _mm256_and_pd(def, _mm256_mul_pd(vf, d));
+
+        _mm256_storeu_pd(w + i,
+            _mm256_blendv_pd(vw, _mm256_add_pd(vw, s), def));
+
+        acc = _mm256_add_pd(acc, _mm256_mul_pd(s, s));
+    }
+
+    __m128d s = _mm_add_pd(
+        _mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+    s = _mm_add_sd(s, _mm_unpackhi_pd(s, s));
+
+    return _mm_cvtsd_f64(s) + update_scalar(w + i, x + i, f, n - i);
+}
+
+/** Masked squared distance (AVX-512, float32) */
+__attribute__((target("avx512f")))
+static float sqdist_masked_avx512(
+    const float * a, const float * b, const uint64_t * mask, size_t n)
+{
+    __m512 acc = _mm512_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __mmask16 k = (mask[i >> 6] >> (i & 63)) & 0xffff;
+        const __m512 d = _mm512_maskz_sub_ps(k,
+            _mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+
+        acc = _mm512_fmadd_ps(d, d, acc);
+    }
+
+    alignas(64) float lanes[16];
+    _mm512_store_ps(lanes, acc);
+
+    float d2 = 0;
+    for (size_t l = 0; l < 16; ++l) d2 += lanes[l];
+
+    for (; i < n; ++i)
+        if (mask_bit(mask, i)) d2 += (a[i] - b[i]) * (a[i] - b[i]);
+
+    return d2;
+}
+
+/** Masked squared distance (AVX-512, float64) */
+__attribute__((target("avx512f")))
+static double sqdist_masked_avx512(
+    const double * a, const double * b, const uint64_t * mask, size_t n)
+{
+    __m512d acc = _mm512_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __mmask8 k = (mask[i >> 6] >> (i & 63)) & 0xff;
+        const __m512d d = _mm512_maskz_sub_pd(k,
+            _mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i));
+
+        acc = _mm512_fmadd_pd(d, d, acc);
+    }
+
+    alignas(64) double lanes[8];
+    _mm512_store_pd(lanes, acc);
+
+    double d2 = 0;
+    for (size_t l = 0; l < 8; ++l) d2 += lanes[l];
+
+    for (; i < n; ++i)
+        if (mask_bit(mask, i)) d2 += (a[i] - b[i]) * (a[i] - b[i]);
+
+    return d2;
+}
+
+/** Update (AVX-512, float64; no FMA, see \ref update_avx2) */
+__attribute__((target("avx512f")))
+static double update_avx512(double * w, const double * x, double f, size_t n) {
+    const __m512d vf  = _mm512_set1_pd(f);
+    __m512d       acc = _mm512_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m512d  vw = _mm512_loadu_pd(w + i);
+        const __m512d  d  = _mm512_sub_pd(_mm512_loadu_pd(x + i), vw);
+        const __mmask8 k  = _mm512_cmp_pd_mask(d, d, _CMP_ORD_Q);
+        const __m512d  s  = _mm512_maskz_mul_pd(k, vf, d);
+
+        _mm512_mask_storeu_pd(w + i, k, _mm512_add_pd(vw, s));
+
+        acc = _mm512_add_pd(acc, _mm512_mul_pd(s, s));
+    }
+
+    alignas(64) double lanes[8];
+    _mm512_store_pd(lanes, acc);
+
+    double dnorm2 = 0;
+    for (size_t l = 0; l < 8; ++l) dnorm2 += lanes[l];
+
+    return dnorm2 + update_scalar(w + i, x + i, f, n - i);
+}
+
+#endif  // end of #ifdef LIBLVQ_SIMD_X86
+
+
+/**
+ *  \brief  SIMD kernels
+ *
+ *  Selected at run time according to CPU capabilities.
+ *  \c LIBLVQ_SIMD environment variable (\c "scalar", \c "avx2",
+ *  \c "avx512") may restrict the selection.
+ */
+struct simd_kernels {
+    const char *                    isa;          /**< Instruction set  */
+    sqdist_fn<float>::type          sqdist_f32;   /**< float32 kernel   */
+    sqdist_fn<double>::type         sqdist_f64;   /**< float64 kernel   */
+    sqdist_masked_fn<float>::type   sqdistm_f32;  /**< float32 kernel   */
+    sqdist_masked_fn<double>::type  sqdistm_f64;  /**< float64 kernel   */
+    update_fn<double>::type         update_f64;   /**< float64 kernel   */
+
+    /** Squared distance (float32) */
+    float sqdist(const float * a, const float * b, size_t n) const {
+        return sqdist_f32(a, b, n);
+    }
+
+    /** Squared distance (float64) */
+    double sqdist(const double * a, const double * b, size_t n) const {
+        return sqdist_f64(a, b, n);
+    }
+
+    /** Masked squared distance (float32) */
+    float sqdist(
+        const float * a, const float * b, const uint64_t * mask, size_t n) const
+    {
+        return sqdistm_f32(a, b, mask, n);
+    }
+
+    /** Masked squared distance (float64) */
+    double sqdist(
+        const double * a, const double * b, const uint64_t * mask, size_t n) const
+    {
+        return sqdistm_f64(a, b, mask, n);
+    }
+
+    /** Update (float64, see \ref update_scalar) */
+    double update(double * w, const double * x, double f, size_t n) const {
+        return update_f64(w, x, f, n);
+    }
+
+    /** Kernels selection */
+    static simd_kernels select() {
+        simd_kernels k = {
+            "scalar",
+            sqdist_scalar<float>,        sqdist_scalar<double>,
+            sqdist_masked_scalar<float>, sqdist_masked_scalar<double>,
+            update_scalar<double>,
+        };
+
+#ifdef LIBLVQ_SIMD_X86
+        const char * env = ::getenv("LIBLVQ_SIMD");
+        const std::string limit(NULL == env ? "" : env);
+
+        if ("scalar" == limit) return k;
+
+        __builtin_cpu_init();
+
+        if ("avx2" != limit && __builtin_cpu_supports("avx512f")) {
+            k.isa         = "avx512";
+            k.sqdist_f32  = sqdist_avx512;
+            k.sqdist_f64  = sqdist_avx512;
+            k.sqdistm_f32 = sqdist_masked_avx512;
+            k.sqdistm_f64 = sqdist_masked_avx512;
+            k.update_f64  = update_avx512;
+        }
+        else if (__builtin_cpu_supports("avx2") &&
+                 __builtin_cpu_supports("fma"))
+        {
+            k.isa         = "avx2";
+            k.sqdist_f32  = sqdist_avx2;
+            k.sqdist_f64  = sqdist_avx2;
+            k.sqdistm_f32 = sqdist_masked_avx2;
+            k.sqdistm_f64 = sqdist_masked_avx2;
+            k.update_f64  = update_avx2;
+        }
+#endif  // end of #ifdef LIBLVQ_SIMD_X86
+
+        return k;
+    }
+
+};  // end of struct simd_kernels
+
+
+/** SIMD kernels instance */
+static const simd_kernels & simd() {
+    static const simd_kernels kernels = simd_kernels::select();
+    return kernels;
+}
+
+
+/**
+ *  \brief  Check dense vector for undefined (NaN) values
+ *
+ *  \param  x  Vector
+ *  \param  n  Dimension
+ *
+ *  \return \c true iff any value is undefined
+ */
+template <typename S>
+static bool dense_undef(const S * x, size_t n) {
+    for (size_t j = 0; j < n; ++j)
+        if (std::isnan(x[j])) return true;
+
+    return false;
+}
+
+
+/**
+ *  \brief  Dense codebook (prototypes matrix) interface
+ *
+ *  Row-major matrix of prototypes in contiguous aligned storage;
+ *  rows are zero-padded to 64 B multiples so that the SIMD kernels
+ *  run over whole vectors.
+ *  The codebook mirrors the \c lvq_t prototypes and serves nearest
+ *  prototype search and distance computation.
+ *
+ *  Undefined values are stored as 0 accompanied by a packed validity
+ *  bitmask (per query and per incomplete prototype); masked kernels
+ *  skip them in distance computation, just like \c realx
+ *  arithmetic does.
+ *  Queries use NaN for undefined values.
+ */
+class dense_codebook {
+    public:
+
+    /** Dimension */
+    virtual size_t dimension() const = 0;
+
+    /** Clusters count */
+    virtual size_t clusters() const = 0;
+
+    /** All prototypes are fully defined */
+    virtual bool complete() const = 0;
+
+    /** Storage type name */
+    virtual const char * dtype() const = 0;
+
+    /** Storage item size */
+    virtual size_t itemsize() const = 0;
+
+    /** Row stride (items, rows are zero-padded) */
+    virtual size_t stride() const = 0;
+
+    /** Prototype rows */
+    virtual const void * data() const = 0;
+
+    /** Validity bitmask words per row */
+    virtual size_t mwords() const = 0;
+
+    /** Prototype validity bitmasks */
+    virtual const uint64_t * mask() const = 0;
+
+    /** Refresh all prototypes */
+    virtual void load(const lvq_t & lvq) = 0;
+
+    /** Refresh prototype */
+    virtual void set(size_t cluster, const lvq_t::input_t & input) = 0;
+
+    /** Get prototype */
+    virtual void get(size_t cluster, lvq_t::input_t & input) const = 0;
+
+    /** Nearest prototype (float64 query, approximate if indexed) */
+    virtual size_t classify(const double * x) const = 0;
+
+    /** Nearest prototype (float32 query, approximate if indexed) */
+    virtual size_t classify(const float * x) const = 0;
+
+    /** Nearest prototype (float64 query, exact; the index isn't used) */
+    virtual size_t nearest(const double * x) const = 0;
+
+    /** Nearest prototype (float32 query, exact; the index isn't used) */
+    virtual size_t nearest(const float * x) const = 0;
+
+    /** Squared distances to all prototypes (float64 query) */
+    virtual void dist2(const double * x, double * d2) const = 0;
+
+    /** Squared distances to all prototypes (float32 query) */
+    virtual void dist2(const float * x, double * d2) const = 0;
+
+    /**
+     *  \brief  Nearest prototypes of index candidates (float64 query)
+     *
+     *  Candidates are prototypes of the lists probed by the query
+     *  (see \ref build_index); if the \c nprobe nearest lists hold less
+     *  than \c k prototypes, next nearest lists are probed, too.
+     *  All prototypes are candidates if not indexed.
+     *
+     *  \param  x     Query
+     *  \param  k     Nearest prototypes count
+     *  \param  cand  Candidates squared distances and clusters (output);
+     *                the \c k nearest ones first, sorted by distance
+     *                (ties by cluster)
+     */
+    virtual void candidates(
+        const double *                            x,
+        size_t                                    k,
+        std::vector<std::pair<double, size_t> > & cand) const = 0;
+
+    /** Nearest prototypes of index candidates (float32 query) */
+    virtual void candidates(
+        const float *                             x,
+        size_t                                    k,
+        std::vector<std::pair<double, size_t> > & cand) const = 0;
+
+    /**
+     *  \brief  Build IVF index
+     *
+     *  Prototypes are clustered to \c nlist inverted lists by k-means
+     *  (coarse quantiser); queries scan prototypes of the \c nprobe lists
+     *  of the nearest centroids only.
+     *  Modified prototypes are moved to the list of their nearest centroid;
+     *  centroids are only updated by rebuilding the index.
+     *
+     *  \param  nlist   Lists count (0 means square root of clusters count)
+     *  \param  nprobe  Lists probed by queries (0 means \c nlist/8)
+     *  \param  iters   k-means iterations
+     *  \param  pool    Thread pool
+     */
+    virtual void build_index(
+        size_t        nlist,
+        size_t        nprobe,
+        unsigned      iters,
+        thread_pool & pool) = 0;
+
+    /** Drop index */
+    virtual void drop_index() = 0;
+
+    /** Index lists count (0 if not indexed) */
+    virtual size_t index_nlist() const = 0;
+
+    /** Index lists probed by queries */
+    virtual size_t index_nprobe() const = 0;
+
+    /** Set index lists probed by queries (recall/latency trade-off) */
+    virtual void set_index_nprobe(size_t nprobe) = 0;
+
+    /**
+     *  \brief  Set exact search pruning
+     *
+     *  Distances of prototypes to \c pivots pivot prototypes (chosen by
+     *  farthest-first traversal) are kept up to date.
+     *  The exact nearest prototype search (classification, testing
+     *  and the BMU search of online training steps, see \c train1_*)
+     *  evaluates the query distance to the pivots first; a prototype
+     *  is skipped if the triangle inequality lower bound
+     *  \f$\max_p |d(x, p) - d(c, p)|\f$ of its distance exceeds
+     *  the best distance found so far, so the result is the same
+     *  as of the linear scan.
+     *  Pruning only applies if both the query and all prototypes
+     *  are fully defined.
+     *
+     *  \param  pivots  Pivots count (0 disables pruning)
+     *  \param  pool    Thread pool
+     */
+    virtual void set_pruning(size_t pivots, thread_pool & pool) = 0;
+
+    /** Pruning pivots count */
+    virtual size_t pruning_pivots() const = 0;
+
+    /**
+     *  \brief  Nearest prototype search counters
+     *
+     *  \param  evals   Distance evaluations (output)
+     *  \param  pruned  Pruned evaluations (output)
+     *  \param  reset   Reset counters
+     */
+    virtual void pruning_stats(
+        uint64_t & evals,
+        uint64_t & pruned,
+        bool       reset) const = 0;
+
+    /**
+     *  \brief  Deep copy
+     *
+     *  The copy owns its storage (external read-only storage is shared
+     *  until modified); index and pruning pivots are copied,
+     *  search counters (see \ref pruning_stats) are shared.
+     */
+    virtual dense_codebook * clone() const = 0;
+
+    /** Destructor */
+    virtual ~dense_codebook() {}
+
+};  // end of class dense_codebook
+
+
+/**
+ *  \brief  Dense codebook
+ *
+ *  \tparam  T  Storage type (\c float or \c double)
+ */
+template <typename T>
+class codebook: public dense_codebook {
+    private:
+
+    /** Row alignment (in items) */
+    static const size_t align = 64 / sizeof(T);
+
+    /** Query (values and validity bitmask) */
+    struct query_t {
+        const T *        values;    /**< Values (undefined are 0)   */
+        const uint64_t * mask;      /**< Validity bitmask           */
+        uint64_t *       qmask;     /**< Query and prototype bitmask (scratch) */
+        bool             complete;  /**< All values defined         */
+    };  // end of struct query_t
+
+    const size_t          m_dim;      /**< Dimension                     */
+    const size_t          m_ccnt;     /**< Clusters count                */
+    const size_t          m_stride;   /**< Row stride                    */
+    const size_t          m_mwords;   /**< Row bitmask words             */
+    T *                   m_data;     /**< Prototypes                    */
+    std::shared_ptr<void> m_storage;  /**< External (read-only) storage  */
+    std::vector<uint64_t> m_mask;     /**< Prototypes validity bitmasks  */
+    std::vector<bool>     m_undef;    /**< Prototype has undefined coord */
+    size_t                m_ucnt;     /**< Incomplete prototypes count   */
+
+    /** IVF index (see \ref dense_codebook::build_index) */
+    struct ivf_t {
+        size_t                           nprobe;     /**< Lists probed        */
+        std::vector<T>                   centroids;  /**< Centroids (rows)    */
+        std::vector<std::vector<size_t>> lists;      /**< Inverted lists      */
+        std::vector<size_t>              list;       /**< Prototype list      */
+        std::vector<size_t>              pos;        /**< Position in list    */
+    };  // end of struct ivf_t
+
+    std::unique_ptr<ivf_t> m_ivf;  /**< IVF index (or empty) */
+
+    std::vector<size_t>           m_pivots;    /**< Pruning pivots          */
+    std::vector<char>             m_is_pivot;  /**< Prototype is pivot      */
+    std::vector<double>           m_pdist;     /**< Prototype-pivot dists   */
+    /** Nearest prototype search counters */
+    struct counters_t {
+        std::atomic<uint64_t> evals;   /**< Distance evaluations */
+        std::atomic<uint64_t> pruned;  /**< Pruned evaluations   */
+
+        counters_t(): evals(0), pruned(0) {}
+    };  // end of struct counters_t
+
+    std::shared_ptr<counters_t> m_counters;  /**< Search counters (shared by clones) */
+
+    /**
+     *  \brief  Pruning bound rounding allowance
+     *
+     *  Distances computed by the kernels (in storage precision) are
+     *  off by a relative error of up to about dimension-times machine
+     *  epsilon; a prototype \c c is only pruned if
+     *  \f$|d(x, p) - d(c, p)| > d_{best} + \epsilon (d(x, p) + d(c, p))\f$,
+     *  so bounds computed in finite precision never prune the linear
+     *  scan winner (regardless of the data norm).
+     */
+    double prune_eps() const {
+        return 2.0 * std::numeric_limits<T>::epsilon() * (m_dim + 1);
+    }
+
+    /** Distance of prototypes */
+    double proto_dist(size_t c1, size_t c2) const {
+        return std::sqrt(simd().sqdist(row(c1), row(c2), m_stride));
+    }
+
+    /** Update prototype-pivot distances of modified prototype */
+    void update_pivots(size_t c) {
+        const size_t pcnt = m_pivots.size();
+
+        for (size_t k = 0; k < pcnt; ++k)
+            m_pdist[c * pcnt + k] = proto_dist(c, m_pivots[k]);
+
+        if (!m_is_pivot[c]) return;
+
+        // Pivot moved: update its column
+        const size_t k = std::find(m_pivots.begin(), m_pivots.end(), c)
+                       - m_pivots.begin();
+
+        for (size_t c2 = 0; c2 < m_ccnt; ++c2)
+            m_pdist[c2 * pcnt + k] = proto_dist(c2, c);
+    }
+
+    /** Prototype modified */
+    void modified(size_t c) {
+        if (m_ivf) reassign(c);
+        if (!m_pivots.empty()) update_pivots(c);
+    }
+
+    /** Own storage (external storage is copied before modification) */
+    void detach() {
+        if (!m_storage) return;
+
+        const size_t bytes = std::max<size_t>(m_ccnt * m_stride, 1) * sizeof(T);
+
+        void * data;
+        if (0 != ::posix_memalign(&data, 64, bytes))
+            throw std::bad_alloc();
+
+        ::memcpy(data, m_data, m_ccnt * m_stride * sizeof(T));
+        m_data = reinterpret_cast<T *>(data);
+        m_storage.reset();
+    }
+
+    /** Prototype */
+    T * row(size_t c) { return m_data + c * m_stride; }
+
+    /** Prototype */
+    const T * row(size_t c) const { return m_data + c * m_stride; }
+
+    /** Prototype validity bitmask */
+    const uint64_t * row_mask(size_t c) const {
+        return m_mask.data() + c * m_mwords;
+    }
+
+    /**
+     *  \brief  Convert query to storage type
+     *
+     *  Per-thread zero-padded scratch buffers are used.
+     */
+    template <typename S>
+    query_t query(const S * x) const {
+        static thread_local std::vector<T>        values;
+        static thread_local std::vector<uint64_t> mask;
+        static thread_local std::vector<uint64_t> qmask;
+
+        values.assign(m_stride, T(0));
+        mask.assign(m_mwords, 0);
+        qmask.resize(m_mwords);
+
+        bool complete = true;
+        for (size_t j = 0; j < m_dim; ++j) {
+            if (std::isnan(x[j])) {
+                complete = false;
+                continue;
+            }
+
+            values[j] = (T)x[j];
+            mask[j >> 6] |= (uint64_t)1 << (j & 63);
+        }
+
+        query_t q = { values.data(), mask.data(), qmask.data(), complete };
+        return q;
+    }
+
+    /**
+     *  \brief  Squared distance of query to prototype
+     *
+     *  \param  q  Query
+     *  \param  c  Cluster
+     */
+    double dist2(const query_t & q, size_t c) const {
+        const simd_kernels & k = simd();
+
+        if (!m_undef[c]) {
+            // Fully defined query and prototype
+            if (q.complete) return k.sqdist(q.values, row(c), m_stride);
+
+            return k.sqdist(q.values, row(c), q.mask, m_stride);
+        }
+
+        const uint64_t * pmask = row_mask(c);
+        for (size_t i = 0; i < m_mwords; ++i) q.qmask[i] = q.mask[i] & pmask[i];
+
+        return k.sqdist(q.values, row(c), q.qmask, m_stride);
+    }
+
+    /** Nearest prototype */
+    size_t classify(const query_t & q, double & bmu_d2) const {
+        if (!m_pivots.empty() && q.complete && 0 == m_ucnt)
+            return classify_pruned(q, bmu_d2);
+
+
+        size_t bmu = 0;
+        bmu_d2 = INFINITY;
+
+        for (size_t c = 0; c < m_ccnt; ++c) {
+            const double d2 = dist2(q, c);
+            if (d2 < bmu_d2) {
+                bmu    = c;
+                bmu_d2 = d2;
+            }
+        }
+
+        m_counters->evals.fetch_add(m_ccnt, std::memory_order_relaxed);
+
+        return bmu;
+    }
+
+    /**
+     *  \brief  Nearest prototype (triangle inequality pruning)
+     *
+     *  See \ref dense_codebook::set_pruning.
+     *  Ties are resolved to the lowest index (just like the linear scan).
+     */
+    size_t classify_pruned(const query_t & q, double & bmu_d2) const {
+        const size_t pcnt = m_pivots.size();
+        const double eps  = prune_eps();
+
+        static thread_local std::vector<double> xp;  // query-pivot distances
+        xp.resize(pcnt);
+
+        size_t bmu = 0;
+        bmu_d2 = INFINITY;
+
+        for (size_t k = 0; k < pcnt; ++k) {
+            const size_t c  = m_pivots[k];
+            const double d2 = dist2(q, c);
+
+            xp[k] = std::sqrt(d2);
+
+            if (d2 < bmu_d2 || (d2 == bmu_d2 && c < bmu)) {
+                bmu    = c;
+                bmu_d2 = d2;
+            }
+        }
+
+        size_t evals = pcnt;
+
+        for (size_t c = 0; c < m_ccnt; ++c) {
+            if (m_is_pivot[c]) continue;
+
+            // Lower bound of distance exceeds the best one
+            const double   best = std::sqrt(bmu_d2);
+            const double * pd   = m_pdist.data() + c * pcnt;
+
+            bool prune = false;
+            for (size_t k = 0; k < pcnt && !prune; ++k)
+                prune = std::fabs(xp[k] - pd[k]) > best + eps * (xp[k] + pd[k]);
+
+            if (prune) continue;
+
+            const double d2 = dist2(q, c);
+            ++evals;
+
+            if (d2 < bmu_d2 || (d2 == bmu_d2 && c < bmu)) {
+                bmu    = c;
+                bmu_d2 = d2;
+            }
+        }
+
+        m_counters->evals.fetch_add(evals, std::memory_order_relaxed);
+        m_counters->pruned.fetch_add(m_ccnt - evals, std::memory_order_relaxed);
+
+        return bmu;
+    }
+
+    /** Index centroid */
+    const T * centroid(const std::vector<T> & centroids, size_t l) const {
+        return centroids.data() + l * m_stride;
+    }
+
+    /** Nearest centroid of prototype */
+    size_t nearest_list(
+        size_t                 c,
+        const std::vector<T> & centroids,
+        size_t                 nlist) const
+    {
+        const simd_kernels & k = simd();
+
+        size_t nearest = 0;
+        double near_d2 = INFINITY;
+
+        for (size_t l = 0; l < nlist; ++l) {
+            const T * w = centroid(centroids, l);
+            const double d2 = m_undef[c]
+                ? k.sqdist(row(c), w, row_mask(c), m_stride)
+                : k.sqdist(row(c), w, m_stride);
+
+            if (d2 < near_d2) {
+                nearest = l;
+                near_d2 = d2;
+            }
+        }
+
+        return nearest;
+    }
+
+    /** Move prototype to the list of its nearest centroid */
+    void reassign(size_t c) {
+        ivf_t & ivf = *m_ivf;
+
+        const size_t l = nearest_list(c, ivf.centroids, ivf.lists.size());
+        if (l == ivf.list[c]) return;
+
+        // Swap-remove from the current list
+        std::vector<size_t> & old = ivf.lists[ivf.list[c]];
+        const size_t p = ivf.pos[c];
+        old[p] = old.back();
+        ivf.pos[old[p]] = p;
+        old.pop_back();
+
+        ivf.list[c] = l;
+        ivf.pos[c]  = ivf.lists[l].size();
+        ivf.lists[l].push_back(c);
+    }
+
+    /**
+     *  \brief  Non-empty lists of the centroids nearest to query
+     *
+     *  \param  q     Query
+     *  \param  pmin  Minimal prototypes count (lists beyond \c nprobe
+     *                are probed until the probed lists hold \c pmin)
+     */
+    std::vector<size_t> probe(const query_t & q, size_t pmin = 0) const {
+        const simd_kernels & k   = simd();
+        const ivf_t &        ivf = *m_ivf;
+
+        std::vector<std::pair<double, size_t> > cd2;
+        cd2.reserve(ivf.lists.size());
+
+        for (size_t l = 0; l < ivf.lists.size(); ++l) {
+            if (ivf.lists[l].empty()) continue;
+
+            const T * w = centroid(ivf.centroids, l);
+            cd2.emplace_back(q.complete
+                ? k.sqdist(q.values, w, m_stride)
+                : k.sqdist(q.values, w, q.mask, m_stride), l);
+        }
+
+        size_t nprobe = std::min(ivf.nprobe, cd2.size());
+        std::partial_sort(cd2.begin(), cd2.begin() + nprobe, cd2.end());
+
+        size_t pcnt = 0;
+        for (size_t i = 0; i < nprobe; ++i)
+            pcnt += ivf.lists[cd2[i].second].size();
+
+        // Too few prototypes probed: next nearest lists
+        if (pcnt < pmin) {
+            std::sort(cd2.begin() + nprobe, cd2.end());
+
+            while (pcnt < pmin && nprobe < cd2.size())
+                pcnt += ivf.lists[cd2[nprobe++].second].size();
+        }
+
+        std::vector<size_t> lists(nprobe);
+        for (size_t i = 0; i < nprobe; ++i) lists[i] = cd2[i].second;
+
+        return lists;
+    }
+
+    /** Nearest prototype (of index candidates if indexed) */
+    size_t search(const query_t & q, double & bmu_d2) const {
+        if (!m_ivf) return classify(q, bmu_d2);
+
+
+        size_t bmu = 0;
+        bmu_d2 = INFINITY;
+
+        for (size_t l: probe(q))
+            for (size_t c: m_ivf->lists[l]) {
+                const double d2 = dist2(q, c);
+                if (d2 < bmu_d2 || (d2 == bmu_d2 && c < bmu)) {
+                    bmu    = c;
+                    bmu_d2 = d2;
+                }
+            }
+
+        return bmu;
+    }
+
+    /** Nearest prototype */
+    template <typename S>
+    size_t classify_impl(const S * x) const {
+        double bmu_d2;
+        return search(query(x), bmu_d2);
+    }
+
+    /** Nearest prototype (exact) */
+    template <typename S>
+    size_t nearest_impl(const S * x) const {
+        double bmu_d2;
+        return classify(query(x), bmu_d2);
+    }
+
+    /** Nearest prototypes of index candidates */
+    template <typename S>
+    void candidates_impl(
+        const S *                                 x,
+        size_t                                    k,
+        std::vector<std::pair<double, size_t> > & cand) const
+    {
+        const query_t q = query(x);
+
+        cand.clear();
+
+        if (!m_ivf) {
+            for (size_t c = 0; c < m_ccnt; ++c)
+                cand.emplace_back(dist2(q, c), c);
+        }
+        else {
+            for (size_t l: probe(q, k))
+                for (size_t c: m_ivf->lists[l])
+                    cand.emplace_back(dist2(q, c), c);
+        }
+
+        k = std::min(k, cand.size());
+        std::partial_sort(cand.begin(), cand.begin() + k, cand.end());
+    }
+
+    /** Squared distances to all prototypes */
+    template <typename S>
+    void dist2_impl(const S * x, double * d2) const {
+        const query_t q = query(x);
+
+        for (size_t c = 0; c < m_ccnt; ++c)
+            d2[c] = dist2(q, c);
+    }
+
+    public:
+
+    /** Row stride (items) for dimension */
+    static size_t row_stride(size_t dim) {
+        return (dim + align - 1) / align * align;
+    }
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  dim   Dimension
+     *  \param  ccnt  Clusters count
+     */
+    codebook(size_t dim, size_t ccnt):
+        m_dim(dim),
+        m_ccnt(ccnt),
+        m_stride(row_stride(dim)),
+        m_mwords((m_stride + 63) / 64),
+        m_data(NULL),
+        m_mask(ccnt * m_mwords, 0),
+        m_undef(ccnt, false),
+        m_ucnt(0),
+        m_counters(std::make_shared<counters_t>())
+    {
+        const size_t bytes = std::max<size_t>(m_ccnt * m_stride, 1) * sizeof(T);
+
+        void * data;
+        if (0 != ::posix_memalign(&data, 64, bytes))
+            throw std::bad_alloc();
+
+        ::memset(data, 0, bytes);
+        m_data = reinterpret_cast<T *>(data);
+    }
+
+    /**
+     *  \brief  Constructor (external storage)
+     *
+     *  Prototype rows are used in place (\c data must be 64B aligned,
+     *  of \ref stride items per row, zero-padded);
+     *  \c storage keeps the memory alive.
+     *  The storage is read-only (e.g. mapped file); it's shared by clones
+     *  and copied once a prototype is modified.
+     *
+     *  \param  dim      Dimension
+     *  \param  ccnt     Clusters count
+     *  \param  data     Prototype rows
+     *  \param  mask     Prototype validity bitmasks
+     *  \param  storage  Storage owner
+     */
+    codebook(
+        size_t                        dim,
+        size_t                        ccnt,
+        T *                           data,
+        const uint64_t *              mask,
+        const std::shared_ptr<void> & storage)
+    :
+        m_dim(dim),
+        m_ccnt(ccnt),
+        m_stride(row_stride(dim)),
+        m_mwords((m_stride + 63) / 64),
+        m_data(data),
+        m_storage(storage),
+        m_mask(mask, mask + ccnt * m_mwords),
+        m_undef(ccnt, false),
+        m_ucnt(0),
+        m_counters(std::make_shared<counters_t>())
+    {
+        for (size_t c = 0; c < m_ccnt; ++c) {
+            const uint64_t * cmask = row_mask(c);
+
+            for (size_t j = 0; j < m_dim && !m_undef[c]; ++j)
+                m_undef[c] = !mask_bit(cmask, j);
+
+            if (m_undef[c]) ++m_ucnt;
+        }
+    }
+
+    size_t dimension() const { return m_dim; }
+
+    size_t clusters() const { return m_ccnt; }
+
+    bool complete() const { return 0 == m_ucnt; }
+
+    const char * dtype() const {
+        return sizeof(T) == sizeof(float) ? "float32" : "float64";
+    }
+
+    size_t itemsize() const { return sizeof(T); }
+
+    size_t stride() const { return m_stride; }
+
+    const void * data() const { return m_data; }
+
+    size_t mwords() const { return m_mwords; }
+
+    const uint64_t * mask() const { return m_mask.data(); }
+
+    void load(const lvq_t & lvq) {
+        for (size_t c = 0; c < m_ccnt; ++c)
+            set(c, lvq.get(c));
+    }
+
+    void set(size_t c, const lvq_t::input_t & input) {
+        detach();
+
+        T *        w     = row(c);
+        uint64_t * mask  = m_mask.data() + c * m_mwords;
+        bool       undef = false;
+
+        std::fill(mask, mask + m_mwords, 0);
+
+        for (size_t j = 0; j < m_dim; ++j) {
+            if (input[j].is_defined()) {
+                w[j] = (T)(double)input[j];
+                mask[j >> 6] |= (uint64_t)1 << (j & 63);
+            }
+            else {
+                w[j]  = T(0);
+                undef = true;
+            }
+        }
+
+        if (undef != m_undef[c]) {
+            m_undef[c] = undef;
+            m_ucnt += undef ? 1 : -1;
+        }
+
+        modified(c);
+    }
+
+    void get(size_t c, lvq_t::input_t & input) const {
+        const T *        w    = row(c);
+        const uint64_t * mask = row_mask(c);
+
+        for (size_t j = 0; j < m_dim; ++j)
+            input[j] = mask_bit(mask, j)
+                     ? lvq_t::base_t((double)w[j])
+                     : lvq_t::base_t::undef;
+    }
+
+    size_t classify(const double * x) const { return classify_impl(x); }
+
+    size_t classify(const float * x) const { return classify_impl(x); }
+
+    size_t nearest(const double * x) const { return nearest_impl(x); }
+
+    size_t nearest(const float * x) const { return nearest_impl(x); }
+
+    void dist2(const double * x, double * d2) const { dist2_impl(x, d2); }
+
+    void dist2(const float * x, double * d2) const { dist2_impl(x, d2); }
+
+    void candidates(
+        const double *                            x,
+        size_t                                    k,
+        std::vector<std::pair<double, size_t> > & cand) const
+    {
+        candidates_impl(x, k, cand);
+    }
+
+    void candidates(
+        const float *                             x,
+        size_t                                    k,
+        std::vector<std::pair<double, size_t> > & cand) const
+    {
+        candidates_impl(x, k, cand);
+    }
+
+
+    void build_index(
+        size_t        nlist,
+        size_t        nprobe,
+        unsigned      iters,
+        thread_pool & pool)
+    {
+        if (0 == m_ccnt)
+            throw std::logic_error("Can't index empty codebook");
+
+        if (0 == nlist) nlist = (size_t)std::lround(std::sqrt((double)m_ccnt));
+        nlist = std::max<size_t>(std::min(nlist, m_ccnt), 1);
+
+        if (0 == nprobe) nprobe = std::max<size_t>(nlist / 8, 1);
+
+        std::unique_ptr<ivf_t> ivf(new ivf_t);
+        ivf->nprobe = std::min(nprobe, nlist);
+        ivf->centroids.assign(nlist * m_stride, T(0));
+
+        // Initial centroids: distinct random prototypes
+        std::vector<size_t> perm(m_ccnt);
+        for (size_t c = 0; c < m_ccnt; ++c) perm[c] = c;
+
+        std::mt19937 gen(rng_draw());
+
+        for (size_t l = 0; l < nlist; ++l) {
+            std::swap(perm[l], perm[l + gen() % (m_ccnt - l)]);
+            std::copy(row(perm[l]), row(perm[l]) + m_stride,
+                ivf->centroids.begin() + l * m_stride);
+        }
+
+        // k-means (Lloyd) iterations
+        std::vector<size_t> assign(m_ccnt);
+        std::vector<double> sum(nlist * m_dim);
+        std::vector<size_t> cnt(nlist * m_dim);
+
+        for (unsigned it = 0; ; ++it) {
+            pool.parallel_for(m_ccnt, pool.chunk(m_ccnt),
+            [&](size_t begin, size_t end) {
+                for (size_t c = begin; c < end; ++c)
+                    assign[c] = nearest_list(c, ivf->centroids, nlist);
+            });
+
+            if (it == iters) break;
+
+            // Centroids are means of defined coordinates
+            std::fill(sum.begin(), sum.end(), 0.0);
+            std::fill(cnt.begin(), cnt.end(), 0);
+
+            for (size_t c = 0; c < m_ccnt; ++c) {
+                const size_t off = assign[c] * m_dim;
+
+                for (size_t j = 0; j < m_dim; ++j)
+                    if (mask_bit(row_mask(c), j)) {
+                        sum[off + j] += row(c)[j];
+                        ++cnt[off + j];
+                    }
+            }
+
+            for (size_t l = 0; l < nlist; ++l)
+                for (size_t j = 0; j < m_dim; ++j)
+                    if (0 < cnt[l * m_dim + j])
+                        ivf->centroids[l * m_stride + j] =
+                            (T)(sum[l * m_dim + j] / cnt[l * m_dim + j]);
+        }
+
+        // Inverted lists
+        ivf->lists.resize(nlist);
+        ivf->list = assign;
+        ivf->pos.resize(m_ccnt);
+
+        for (size_t c = 0; c < m_ccnt; ++c) {
+            ivf->pos[c] = ivf->lists[assign[c]].size();
+            ivf->lists[assign[c]].push_back(c);
+        }
+
+        m_ivf = std::move(ivf);
+    }
+
+    void drop_index() { m_ivf.reset(); }
+
+    void set_pruning(size_t pivots, thread_pool & pool) {
+        const size_t pcnt = std::min(pivots, m_ccnt);
+
+        m_pivots.clear();
+        m_is_pivot.assign(m_ccnt, 0);
+        m_pdist.assign(m_ccnt * pcnt, 0.0);
+
+        if (0 == pcnt) return;
+
+        // Farthest-first traversal
+        std::vector<double> mind(m_ccnt, INFINITY);
+        size_t pivot = std::mt19937(rng_draw())() % m_ccnt;
+
+        for (size_t k = 0; k < pcnt; ++k) {
+            if (0.0 == mind[pivot]) break;  // remaining prototypes coincide
+
+            m_pivots.push_back(pivot);
+            m_is_pivot[pivot] = 1;
+
+            pool.parallel_for(m_ccnt, pool.chunk(m_ccnt),
+            [&](size_t begin, size_t end) {
+                for (size_t c = begin; c < end; ++c) {
+                    const double d = proto_dist(c, pivot);
+
+                    m_pdist[c * pcnt + k] = d;
+                    mind[c] = std::min(mind[c], d);
+                }
+            });
+
+            pivot = std::max_element(mind.begin(), mind.end()) - mind.begin();
+        }
+
+        // Fewer pivots found: compact rows
+        const size_t found = m_pivots.size();
+        if (found < pcnt) {
+            for (size_t c = 0; c < m_ccnt; ++c)
+                for (size_t k = 0; k < found; ++k)
+                    m_pdist[c * found + k] = m_pdist[c * pcnt + k];
+
+            m_pdist.resize(m_ccnt * found);
+        }
+    }
+
+    size_t pruning_pivots() const { return m_pivots.size(); }
+
+    void pruning_stats(uint64_t & evals, uint64_t & pruned, bool reset) const {
+        evals  = reset ? m_counters->evals.exchange(0)  : m_counters->evals.load();
+        pruned = reset ? m_counters->pruned.exchange(0) : m_counters->pruned.load();
+    }
+
+    size_t index_nlist() const { return m_ivf ? m_ivf->lists.size() : 0; }
+
+    size_t index_nprobe() const { return m_ivf ? m_ivf->nprobe : 0; }
+
+    void set_index_nprobe(size_t nprobe) {
+        if (!m_ivf)
+            throw std::logic_error("No index built");
+
+        m_ivf->nprobe = std::max<size_t>(std::min(nprobe, m_ivf->lists.size()), 1);
+    }
+
+    dense_codebook * clone() const { return new codebook(*this); }
+
+    /** Destructor */
+    ~codebook() { if (!m_storage) ::free(m_data); }
+
+    private:
+
+    /** Deep copy (see \ref clone) */
+    codebook(const codebook & orig):
+        m_dim(orig.m_dim),
+        m_ccnt(orig.m_ccnt),
+        m_stride(orig.m_stride),
+        m_mwords(orig.m_mwords),
+        m_data(orig.m_data),
+        m_storage(orig.m_storage),
+        m_mask(orig.m_mask),
+        m_undef(orig.m_undef),
+        m_ucnt(orig.m_ucnt),
+        m_ivf(orig.m_ivf ? new ivf_t(*orig.m_ivf) : NULL),
+        m_pivots(orig.m_pivots),
+        m_is_pivot(orig.m_is_pivot),
+        m_pdist(orig.m_pdist),
+        m_counters(orig.m_counters)
+    {
+        if (m_storage) return;  // shared read-only storage
+
+        const size_t bytes = std::max<size_t>(m_ccnt * m_stride, 1) * sizeof(T);
+
+        void * data;
+        if (0 != ::posix_memalign(&data, 64, bytes))
+            throw std::bad_alloc();
+
+        ::memcpy(data, orig.m_data, m_ccnt * m_stride * sizeof(T));
+        m_data = reinterpret_cast<T *>(data);
+    }
+
+    codebook & operator = (const codebook &);
+
+};  // end of class codebook
+
+
+/**
+ *  \brief  Create dense codebook
+ *
+ *  \param  dtype  Storage type name (\c "float32" or \c "float64")
+ *  \param  dim    Dimension
+ *  \param  ccnt   Clusters count
+ *
+ *  \return Dense codebook
+ */
+static dense_codebook * new_codebook(
+    const char * dtype,
+    size_t       dim,
+    size_t       ccnt)
+{
+    if (0 == ::strcmp(dtype, "float32"))
+        return new codebook<float>(dim, ccnt);
+
+    if (0 == ::strcmp(dtype, "float64"))
+        return new codebook<double>(dim, ccnt);
+
+    throw std::logic_error("Invalid dtype (\"float32\" or \"float64\" expected)");
+}
+
+
+/**
+ *  \brief  Training samples chunk
+ *
+ *  Reusable native buffer for training samples pulled from a Python
+ *  iterator chunk by chunk (dense rows, NaN stands for undefined).
+ *  Memory use is bounded by the chunk capacity.
+ */
+class tset_chunk {
+    private:
+
+    const size_t        m_dim;       /**< Dimension          */
+    const size_t        m_capacity;  /**< Chunk capacity     */
+    std::vector<double> m_values;    /**< Samples            */
+    std::vector<size_t> m_clusters;  /**< Sample clusters    */
+    size_t              m_size;      /**< Samples in chunk   */
+
+    /** Transform Python input to row */
+    void python2row(PyObject * py_input, double * row) const {
+        PyObject * py_iter = PyObject_GetIter(py_input);
+        if (NULL == py_iter)
+            throw std::logic_error("Invalid input (should be iterable)");
+
+        py_ref iter(py_iter);
+
+        size_t     j = 0;
+        PyObject * py_x;
+        while (NULL != (py_x = PyIter_Next(py_iter))) {
+            py_ref x(py_x);
+
+            if (m_dim <= j)
+                throw std::logic_error("Invalid input (dimension mismatch)");
+
+            row[j++] = Py_None == py_x ? NAN : PyFloat_AsDouble(py_x);
+
+            if (NULL != PyErr_Occurred())
+                throw std::logic_error("Invalid input value");
+        }
+
+        if (NULL != PyErr_Occurred())
+            throw std::logic_error("Invalid input (iteration failed)");
+
+        if (m_dim != j)
+            throw std::logic_error("Invalid input (dimension mismatch)");
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  dim       Dimension
+     *  \param  capacity  Chunk capacity
+     */
+    tset_chunk(size_t dim, size_t capacity):
+        m_dim(dim),
+        m_capacity(std::max<size_t>(capacity, 1)),
+        m_values(m_dim * m_capacity),
+        m_clusters(m_capacity),
+        m_size(0)
+    {}
+
+    /** Samples in chunk */
+    size_t size() const { return m_size; }
+
+    /** Sample */
+    const double * row(size_t i) const { return m_values.data() + i * m_dim; }
+
+    /** Sample cluster (supervised samples only) */
+    size_t cluster(size_t i) const { return m_clusters[i]; }
+
+    /**
+     *  \brief  Pull next chunk
+     *
+     *  Supervised samples are (input, cluster) tuples,
+     *  unsupervised samples are inputs.
+     *  Must be called with GIL held.
+     *
+     *  \param  py_iter  Python iterator
+     *  \param  superv   Supervised samples
+     *
+     *  \return \c false iff the iterator is exhausted
+     */
+    bool pull(PyObject * py_iter, bool superv) {
+        m_size = 0;
+
+        PyObject * py_sample;
+        while (m_size < m_capacity &&
+            NULL != (py_sample = PyIter_Next(py_iter)))
+        {
+            py_ref sample(py_sample);
+            PyObject * py_input = py_sample;
+
+            if (superv) {
+                if (!PyTuple_Check(py_sample) || 2 != PyTuple_Size(py_sample))
+                    throw std::logic_error(
+                        "Invalid training set ((input, cluster) tuples expected");
+
+                py_input = PyTuple_GetItem(py_sample, 0);
+
+                PyObject * py_cluster = PyTuple_GetItem(py_sample, 1);
+                if (!PyLong_Check(py_cluster))
+                    throw std::logic_error("Invalid cluster (integer expected)");
+
+                Py_ssize_t cluster = PyLong_AsSsize_t(py_cluster);
+                if (0 > cluster)
+                    throw std::logic_error("Invalid cluster (must be >= 0)");
+
+                m_clusters[m_size] = cluster;
+            }
+
+            python2row(py_input, m_values.data() + m_size * m_dim);
+            ++m_size;
+        }
+
+        if (NULL != PyErr_Occurred())
+            throw std::logic_error("Invalid training set (iteration failed)");
+
+        return 0 < m_size;
+    }
+
+};  // end of class tset_chunk
+
+
+//
+// Binary model files
+//
+
+/**
+ *  \brief  Binary model image header
+ *
+ *  Image layout (native byte order):
+ *  -# header (64B)
+ *  -# prototype rows (\c ccnt rows of \c stride items of \c dtype,
+ *     zero-padded, undefined values are 0), i.e. the \ref codebook
+ *     storage as is
+ *  -# validity bitmasks (\c ccnt rows of <tt>ceil(stride / 64)</tt>
+ *     \c uint64_t words, bit set iff the value is defined)
+ *
+ *  The checksum covers everything but the header.
+ */
+struct model_header {
+    /** Item types */
+    enum {
+        FLOAT64 = 0,  /**< \c double items */
+        FLOAT32 = 1,  /**< \c float items  */
+    };
+
+    /** Flags */
+    enum {
+        DENSE    = 0x1,  /**< Model has dense prototypes      */
+        NO_UNDEF = 0x2,  /**< Undefined values not allowed    */
+    };
+
+    /** Constants */
+    enum {
+        VERSION         = 1,           /**< Format version  */
+        BYTE_ORDER_MARK = 0x01020304,  /**< Byte order mark */
+    };
+
+    char     magic[8];     /**< \c "LVQMODL\0"  */
+    uint32_t version;      /**< Format version  */
+    uint32_t byte_order;   /**< Byte order mark */
+    uint32_t dtype;        /**< Item type       */
+    uint32_t flags;        /**< Model flags     */
+    uint64_t dim;          /**< Dimension       */
+    uint64_t ccnt;         /**< Clusters count  */
+    uint64_t stride;       /**< Row stride      */
+    uint64_t checksum;     /**< Payload checksum (FNV-1a over words) */
+    uint64_t reserved1;    /**< Reserved (zero) */
+
+    /** Magic */
+    static const char * magic_str() { return "LVQMODL"; }
+
+    /** Item size */
+    size_t itemsize() const {
+        return FLOAT32 == dtype ? sizeof(float) : sizeof(double);
+    }
+
+    /** Validity bitmask words per row */
+    size_t mwords() const { return (stride + 63) / 64; }
+
+    /** Prototype rows offset */
+    size_t data_offset() const { return sizeof(model_header); }
+
+    /** Validity bitmasks offset */
+    size_t mask_offset() const {
+        return data_offset() + ccnt * stride * itemsize();
+    }
+
+    /** Image size */
+    size_t image_size() const {
+        return mask_offset() + ccnt * mwords() * sizeof(uint64_t);
+    }
+
+};  // end of struct model_header
+
+static_assert(64 == sizeof(model_header), "Unexpected model_header size");
+
+
+/**
+ *  \brief  Checksum (64-bit FNV-1a over 64-bit words)
+ *
+ *  \param  data  Data (8B aligned)
+ *  \param  size  Data size (multiple of 8)
+ *
+ *  \return Checksum
+ */
+static uint64_t checksum64(const void * data, size_t size) {
+    const uint64_t * word = reinterpret_cast<const uint64_t *>(data);
+
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size / sizeof(uint64_t); ++i)
+        hash = (hash ^ word[i]) * 0x100000001b3ull;
+
+    return hash;
+}
+
+
+/**
+ *  \brief  Binary model image size
+ *
+ *  \param  dense  Dense prototypes
+ *
+ *  \return Image size
+ */
+static size_t model_image_size(const dense_codebook & dense) {
+    return sizeof(model_header) +
+        dense.clusters() * dense.stride() * dense.itemsize() +
+        dense.clusters() * dense.mwords() * sizeof(uint64_t);
+}
+
+
+/**
+ *  \brief  Write binary model image
+ *
+ *  \param  dense  Dense prototypes
+ *  \param  flags  Model flags (see \ref model_header)
+ *  \param  image  Image (of \ref model_image_size, 8B aligned)
+ */
+static void model_image_write(
+    const dense_codebook & dense,
+    uint32_t               flags,
+    char *                 image)
+{
+    model_header header;
+    ::memset(&header, 0, sizeof(header));
+    ::strcpy(header.magic, model_header::magic_str());
+    header.version    = model_header::VERSION;
+    header.byte_order = model_header::BYTE_ORDER_MARK;
+    header.dtype      = sizeof(float) == dense.itemsize()
+                      ? model_header::FLOAT32 : model_header::FLOAT64;
+    header.flags      = flags;
+    header.dim        = dense.dimension();
+    header.ccnt       = dense.clusters();
+    header.stride     = dense.stride();
+
+    ::memcpy(image + header.data_offset(), dense.data(),
+        header.mask_offset() - header.data_offset());
+    ::memcpy(image + header.mask_offset(), dense.mask(),
+        header.image_size() - header.mask_offset());
+
+    header.checksum = checksum64(image + header.data_offset(),
+        header.image_size() - header.data_offset());
+
+    ::memcpy(image, &header, sizeof(header));
+}
+
+
+/**
+ *  \brief  Create dense prototypes from binary model image
+ *
+ *  Prototype rows are used in place; \c storage must keep the image
+ *  alive (and the image must be 64B aligned).
+ *
+ *  \param  image    Image
+ *  \param  size     Image size
+ *  \param  verify   Verify checksum
+ *  \param  storage  Image storage owner
+ *  \param  flags    Model flags (output)
+ *
+ *  \return Dense prototypes
+ */
+static dense_codebook * model_image_load(
+    char *                        image,
+    size_t                        size,
+    bool                          verify,
+    const std::shared_ptr<void> & storage,
+    uint32_t &                    flags)
+{
+    if (size < sizeof(model_header))
+        throw std::logic_error("Invalid model image (truncated)");
+
+    model_header header;
+    ::memcpy(&header, image, sizeof(header));
+
+    if (0 != ::memcmp(header.magic, model_header::magic_str(), 8))
+        throw std::logic_error("Invalid model image (bad magic)");
+
+    if (model_header::BYTE_ORDER_MARK != header.byte_order)
+        throw std::logic_error("Invalid model image (byte order mismatch)");
+
+    if (model_header::VERSION != header.version)
+        throw std::logic_error("Invalid model image (unsupported version)");
+
+    const bool f32 = model_header::FLOAT32 == header.dtype;
+    if (!f32 && model_header::FLOAT64 != header.dtype)
+        throw std::logic_error("Invalid model image (bad item type)");
+
+    const size_t stride = f32
+        ? codebook<float>::row_stride(header.dim)
+        : codebook<double>::row_stride(header.dim);
+
+    if (header.stride != stride)
+        throw std::logic_error("Invalid model image (bad row stride)");
+
+    // Sections must fit in the address space
+    const size_t max_items = SIZE_MAX / 4 / sizeof(double);
+    if (0 < stride && header.ccnt > max_items / stride)
+        throw std::logic_error("Invalid model image (too large)");
+
+    if (size < header.image_size())
+        throw std::logic_error("Invalid model image (truncated)");
+
+    if (verify && header.checksum != checksum64(
+        image + header.data_offset(),
+        header.image_size() - header.data_offset()))
+    {
+        throw std::logic_error("Invalid model image (checksum mismatch)");
+    }
+
+    flags = header.flags;
+
+    char *           data = image + header.data_offset();
+    const uint64_t * mask = reinterpret_cast<const uint64_t *>(
+        image + header.mask_offset());
+
+    if (f32)
+        return new codebook<float>(header.dim, header.ccnt,
+            reinterpret_cast<float *>(data), mask, storage);
+
+    return new codebook<double>(header.dim, header.ccnt,
+        reinterpret_cast<double *>(data), mask, storage);
+}
+
+
+/**
+ *  \brief  Create LVQ model from dense prototypes
+ *
+ *  \param  dense  Dense prototypes
+ *
+ *  \return LVQ model
+ */
+static lvq_t * codebook2lvq(const dense_codebook & dense) {
+    std::unique_ptr<lvq_t> lvq(new lvq_t(dense.dimension(), dense.clusters()));
+
+    lvq_t::input_t input(dense.dimension());
+    for (size_t c = 0; c < dense.clusters(); ++c) {
+        dense.get(c, input);
+        lvq->set(input, c);
+    }
+
+    return lvq.release();
+}
+
+
+/**
+ *  \brief  LVQ object access
+ *
+ *  The \c ml::lvq instance of models having dense prototypes only
+ *  (see \c load_mmap) is built from them on the first access.
+ *
+ *  \param  self  Python LVQ object
+ *
+ *  \return LVQ model
+ */
+static lvq_t * python2lvq(PyObject * self) {
+    lvqObject_t * py_lvq = reinterpret_cast<lvqObject_t *>(self);
+
+    lvq_t * lvq = __atomic_load_n(&py_lvq->lvq, __ATOMIC_ACQUIRE);
+    if (NULL != lvq) return lvq;
+
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (NULL == py_lvq->lvq)
+        __atomic_store_n(&py_lvq->lvq,
+            codebook2lvq(*py_lvq->dense), __ATOMIC_RELEASE);
+
+    return py_lvq->lvq;
+}
+
+
+/**
+ *  \brief  Model dimension
+ *
+ *  Doesn't build the \c ml::lvq instance (see \ref python2lvq).
+ *
+ *  \param  self  Python LVQ object
+ */
+static size_t model_dimension(PyObject * self) {
+    const lvqObject_t * py_lvq = reinterpret_cast<lvqObject_t *>(self);
+
+    return NULL != py_lvq->dense
+        ? py_lvq->dense->dimension() : py_lvq->lvq->dimension();
+}
+
+
+/**
+ *  \brief  Model clusters count
+ *
+ *  Doesn't build the \c ml::lvq instance (see \ref python2lvq).
+ *
+ *  \param  self  Python LVQ object
+ */
+static size_t model_clusters(PyObject * self) {
+    const lvqObject_t * py_lvq = reinterpret_cast<lvqObject_t *>(self);
+
+    return NULL != py_lvq->dense
+        ? py_lvq->dense->clusters() : py_lvq->lvq->clusters();
+}
+
+
+/**
+ *  \brief  Map binary model file
+ *
+ *  The file is mapped read-only: the pages are shared via the page
+ *  cache (also among forked processes); dense prototypes copy them
+ *  once modified (see \ref codebook).
+ *
+ *  \param  file  File path
+ *  \param  size  Mapping size (output)
+ *
+ *  \return Mapping
+ */
+static std::shared_ptr<void> model_file_map(const char * file, size_t & size) {
+    const int fd = ::open(file, O_RDONLY);
+    if (0 > fd)
+        throw std::runtime_error("Failed to open model file");
+
+    struct stat st;
+    if (0 != ::fstat(fd, &st)) {
+        ::close(fd);
+        throw std::runtime_error("Failed to stat model file");
+    }
+
+    size = st.st_size;
+    if (0 == size) {
+        ::close(fd);
+        throw std::logic_error("Invalid model image (truncated)");
+    }
+
+    void * map = ::mmap(NULL, size,
+        PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (MAP_FAILED == map)
+        throw std::runtime_error("Failed to map model file");
+
+    const size_t map_size = size;
+    return std::shared_ptr<void>(map,
+        [map_size](void * addr) { ::munmap(addr, map_size); });
+}
+
+
+//
+// Forward declarations
+//
+
+/** \cond */
+static PyTypeObject * get_lvqType();
+static PyTypeObject * get_lvqClassifierStatisticsType();
+static PyTypeObject * get_lvqClusteringStatisticsType();
+static PyTypeObject * get_trainJobType();
+static PyTypeObject * get_trainingSetType();
+static PyTypeObject * get_snapshotType();
+static std::unique_ptr<tset_arena> new_tset_arena(
+    PyObject * py_set, PyObject * py_labels, bool cache = true);
+static void delete_batcher(classify_batcher * batcher);
+/** \endcond */
+
+
+/**
+ *  \brief  LVQ constructor
+ *
+ *  \param  py_lvq  Python LVQ object
+ *  \param  args    Arguments
+ *  \param  kwds    Keywords
+ */
+static void liblvq__lvq__create(
+    lvqObject_t * py_lvq,
+    PyObject    * args,
+    PyObject    * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = {
+        "dimension", "clusters", "dtype", "allow_undef", NULL };
+
+    size_t       dimension;
+    size_t       clusters;
+    const char * dtype       = NULL;
+    int          allow_undef = 1;
+    parse_args_kw(args, kwds, "nn|zp", kwlist,
+        &dimension, &clusters, &dtype, &allow_undef);
+
+    // Create ml::lvq instance
+    py_lvq->lvq         = new lvq_t(dimension, clusters);
+    py_lvq->allow_undef = allow_undef;
+
+    // Dense prototypes copy
+    if (NULL != dtype) {
+        py_lvq->dense = new_codebook(dtype, dimension, clusters);
+        py_lvq->dense->load(*py_lvq->lvq);
+    }
+
+    if (NULL == py_lvq->lock) py_lvq->lock = new rwlock();
+
+    if (NULL == py_lvq->snapshots) py_lvq->snapshots = new snapshot_cell();
+}
+
+
+/**
+ *  \brief  LVQ destructor
+ *
+ *  \param  py_lvq  Python LVQ object
+ *
+ *  \return 0
+ */
+static int liblvq__lvq__destroy(lvqObject_t * py_lvq) {
+    classify_batcher * batcher = py_lvq->batcher;
+    py_lvq->batcher = NULL;
+
+    if (NULL != batcher) delete_batcher(batcher);
+
+    // Stops the deferred publisher (it uses the model)
+    snapshot_cell * snapshots = py_lvq->snapshots;
+    py_lvq->snapshots = NULL;
+
+    if (NULL != snapshots) {
+        gil_release nogil;
+        delete snapshots;
+    }
+
+    lvq_t * lvq = py_lvq->lvq;
+    py_lvq->lvq = NULL;
+
+    if (NULL != lvq) delete lvq;
+
+    dense_codebook * dense = py_lvq->dense;
+    py_lvq->dense = NULL;
+
+    if (NULL != dense) delete dense;
+
+    rwlock * lock = py_lvq->lock;
+    py_lvq->lock = NULL;
+
+    if (NULL != lock) delete lock;
+
+    return 0;
+}
+
+/** \cond */
+static void BINDING_IDENT(liblvq__lvq__destroy)(lvqObject_t * py_lvq) {
+    wrap_X(0, liblvq__lvq__destroy, py_lvq);
+}
+/** \endcond */
+
+
+/**
+ *  \brief  Statistics clusters count
+ *
+ *  \param  py_arg  Clusters count or Python LVQ object
+ *
+ *  \return Clusters count
+ */
+static size_t stats_clusters(PyObject * py_arg) {
+    if (PyObject_TypeCheck(py_arg, get_lvqType()))
+        return model_clusters(py_arg);
+
+    const Py_ssize_t ccnt = PyIndex_Check(py_arg)
+        ? PyNumber_AsSsize_t(py_arg, PyExc_OverflowError) : -1;
+
+    if (0 > ccnt) {
+        PyErr_Clear();
+        throw std::logic_error("Invalid clusters count or lvq object");
+    }
+
+    return ccnt;
+}
+
+
+/**
+ *  \brief  LVQ classifier statistics constructor
+ *
+ *  The statistics are created for given clusters count or LVQ object;
+ *  in the latter case, the statistics are bound to the object
+ *  (see \c update).
+ *
+ *  \param  py_lvq_stats  Python LVQ classifier statistics object
+ *  \param  args          Arguments
+ *  \param  kwds          Keywords
+ */
+static void liblvq__lvq__classifier_statistics__create(
+    lvqClassifierStatisticsObject_t * py_lvq_stats,
+    PyObject                        * args,
+    PyObject                        * kwds)
+{
+    // Get arguments
+    PyObject * py_arg;
+    parse_args(args, "O", &py_arg);
+
+    const size_t ccnt = stats_clusters(py_arg);
+
+    // Create ml::lvq::classifier_statistics instance
+    py_lvq_stats->lvq_stats = new lvq_classifier_stats_t(ccnt);
+
+    if (PyObject_TypeCheck(py_arg, get_lvqType())) {
+        Py_INCREF(py_arg);
+        py_lvq_stats->py_lvq = py_arg;
+    }
+}
+
+
+/**
+ *  \brief  LVQ classifier statistics destructor
+ *
+ *  \param  py_lvq_stats  Python LVQ classifier statistics object
+ *
+ *  \return 0
+ */
+static int liblvq__lvq__classifier_statistics__destroy(
+    lvqClassifierStatisticsObject_t * py_lvq_stats)
+{
+    lvq_classifier_stats_t * lvq_stats = py_lvq_stats->lvq_stats;
+    py_lvq_stats->lvq_stats = NULL;
+
+    if (NULL != lvq_stats) delete lvq_stats;
+
+    Py_CLEAR(py_lvq_stats->py_lvq);
+
+    return 0;
+}
+
+/** \cond */
+static void BINDING_IDENT(liblvq__lvq__classifier_statistics__destroy)(
+    lvqClassifierStatisticsObject_t * py_lvq_stats)
+{
+    wrap_X(0, liblvq__lvq__classifier_statistics__destroy, py_lvq_stats);
+}
+/** \endcond */
+
+
+/**
+ *  \brief  LVQ clustering statistics constructor
+ *
+ *  See classifier statistics constructor.
+ *
+ *  \param  py_lvq_stats  Python LVQ clustering statistics object
+ *  \param  args          Arguments
+ *  \param  kwds          Keywords
+ */
+static void liblvq__lvq__clustering_statistics__create(
+    lvqClusteringStatisticsObject_t * py_lvq_stats,
+    PyObject                        * args,
+    PyObject                        * kwds)
+{
+    // Get arguments
+    PyObject * py_arg;
+    parse_args(args, "O", &py_arg);
+
+    const size_t ccnt = stats_clusters(py_arg);
+
+    // Create ml::lvq::clustering_statistics instance
+    py_lvq_stats->lvq_stats = new lvq_clustering_stats_t(ccnt);
+
+    if (PyObject_TypeCheck(py_arg, get_lvqType())) {
+        Py_INCREF(py_arg);
+        py_lvq_stats->py_lvq = py_arg;
+    }
+}
+
+
+/**
+ *  \brief  LVQ clustering statistics destructor
+ *
+ *  \param  py_lvq_stats  Python LVQ clustering statistics object
+ *
+ *  \return 0
+ */
+static int liblvq__lvq__clustering_statistics__destroy(
+    lvqClusteringStatisticsObject_t * py_lvq_stats)
+{
+    lvq_clustering_stats_t * lvq_stats = py_lvq_stats->lvq_stats;
+    py_lvq_stats->lvq_stats = NULL;
+
+    if (NULL != lvq_stats) delete lvq_stats;
+
+    Py_CLEAR(py_lvq_stats->py_lvq);
+
+    return 0;
+}
+
+/** \cond */
+static void BINDING_IDENT(liblvq__lvq__clustering_statistics__destroy)(
+    lvqClusteringStatisticsObject_t * py_lvq_stats)
+{
+    wrap_X(0, liblvq__lvq__clustering_statistics__destroy, py_lvq_stats);
+}
+/** \endcond */
+
+
+//
+// ml::lvq member functions binding
+//
+
+/** RNG seed */
+static PyObject * rng_seed(PyObject * args) {
+    int seed = 0;
+    parse_args(args, "|i", &seed);
+    srand(seed);
+
+    std::unique_lock<std::mutex> lock(rng_mutex);
+    rng_inst.seed(seed);
+
+    // No return value
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+/** \cond */
+static PyObject * BINDING_IDENT(rng_seed)(PyObject * self, PyObject * args) {
+    return wrap_X(self, rng_seed, args);
+}
+/** \endcond */
+
+
+/** Set worker threads count */
+static PyObject * set_num_threads(PyObject * args) {
+    size_t threads;
+    parse_args(args, "n", &threads);
+
+    {
+        gil_release nogil;  // old pool workers are joined
+        set_pool_threads(threads);
+    }
+
+    // No return value
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+/** \cond */
+static PyObject * BINDING_IDENT(set_num_threads)(PyObject * self, PyObject * args) {
+    return wrap_X((PyObject *)NULL, set_num_threads, args);
+}
+/** \endcond */
+
+
+/** Get SIMD instruction set used by dense models */
+static PyObject * simd_isa(PyObject * args) {
+    parse_args(args, "");
+
+    return Py_BuildValue("s", simd().isa);
+}
+
+/** \cond */
+static PyObject * BINDING_IDENT(simd_isa)(PyObject * self, PyObject * args) {
+    return wrap_X((PyObject *)NULL, simd_isa, args);
+}
+/** \endcond */
+
+
+/** Get worker threads count */
+static PyObject * get_num_threads(PyObject * args) {
+    parse_args(args, "");
+
+    return Py_BuildValue("n", get_pool()->concurrency());
+}
+
+/** \cond */
+static PyObject * BINDING_IDENT(get_num_threads)(PyObject * self, PyObject * args) {
+    return wrap_X((PyObject *)NULL, get_num_threads, args);
+}
+/** \endcond */
+
+
+/**
+ *  \brief  Write binary training set file
+ *
+ *  \c set is either a 2-D float64/float32 matrix buffer (NaN stands for
+ *  undefined value) or a sequence of inputs or (input, cluster) tuples.
+ *  Labels may also be given separately (1-D int64 buffer or iterable).
+ *  The file may be passed to \c train_* and \c test_* methods instead
+ *  of the set.
+ *
+ *  \return Sample count
+ */
+static PyObject * write_tset(PyObject * args, PyObject * kwds) {
+    // Get arguments
+    static const char * kwlist[] = { "path", "set", "labels", "dtype", NULL };
+
+    PyObject *   py_path;
+    PyObject *   py_set;
+    PyObject *   py_labels = Py_None;
+    const char * dtype     = NULL;
+    parse_args_kw(args, kwds, "OO|Oz", kwlist,
+        &py_path, &py_set, &py_labels, &dtype);
+
+    std::string path;
+    if (!python2path(py_path, path))
+        throw std::logic_error("Invalid path");
+
+    uint32_t file_dtype = tset_header::FLOAT64;
+    if (NULL != dtype && 0 == ::strcmp(dtype, "float32"))
+        file_dtype = tset_header::FLOAT32;
+    else if (NULL != dtype && 0 != ::strcmp(dtype, "float64"))
+        throw std::logic_error("Invalid dtype (\"float64\" or \"float32\" expected)");
+
+    std::vector<int64_t> labels;
+    if (Py_None != py_labels) python2labels(py_labels, labels);
+
+    const std::vector<int64_t> * labels_ptr =
+        Py_None != py_labels ? &labels : NULL;
+
+    // Call implementation
+    size_t cnt;
+
+    if (PyObject_CheckBuffer(py_set)) {
+        buffer_view matrix(py_set);
+
+        if (buffer_view::FLOAT64 != matrix.dtype() &&
+            buffer_view::FLOAT32 != matrix.dtype())
+        {
+            throw std::logic_error(
+                "Invalid input matrix (float64/float32 expected)");
+        }
+
+        if (2 != matrix.ndim())
+            throw std::logic_error("Invalid input matrix (2-D buffer expected)");
+
+        if (NULL != labels_ptr && labels.size() != matrix.rows())
+            throw std::logic_error("Invalid labels (sample count mismatch)");
+
+        gil_release nogil;
+        write_tset_matrix(path, file_dtype, matrix, labels_ptr);
+        cnt = matrix.rows();
+    }
+    else
+        cnt = write_tset_sequence(path, file_dtype, py_set, labels_ptr);
+
+    // Transform result
+    return Py_BuildValue("n", cnt);
+}
+
+/** \cond */
+static PyObject * BINDING_IDENT(write_tset)(
+    PyObject * self, PyObject * args, PyObject * kwds)
+{
+    return wrap_X((PyObject *)NULL, write_tset, args, kwds);
+}
+/** \endcond */
+
+
+/**
+ *  \brief  Constructor
+ *
+ *  \param  type  Python LVQ type
+ *  \param  args  Arguments
+ *  \param  kwds  Keywords
+ *
+ *  \return LVQ instance
+ */
+static PyObject * liblvq__lvq__new(
+    PyTypeObject * type,
+    PyObject     * args,
+    PyObject     * kwds)
+{
+    lvqObject_t * py_lvq = reinterpret_cast<lvqObject_t *>(
+        type->tp_alloc(type, 0));
+
+    if (NULL == py_lvq) return NULL;
+
+    liblvq__lvq__create(py_lvq, args, kwds);
+    snapshot_publish(reinterpret_cast<PyObject *>(py_lvq));
+
+    return reinterpret_cast<PyObject *>(py_lvq);
+}
+
+/** \cond */
+static PyObject * BINDING_IDENT(liblvq__lvq__new)(
+    PyTypeObject * type,
+    PyObject     * args,
+    PyObject     * kwds)
+{
+    return wrap_X((PyObject *)NULL, liblvq__lvq__new, type, args, kwds);
+}
+/** \endcond */
+
+
+/**
+ *  \brief  Constructor (__init__)
+ *
+ *  \param  self  Python LQV object
+ *  \param  args  Arguments
+ *  \param  kwds  Keywords
+ *
+ *  \return 0
+ */
+static int liblvq__lvq__init(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    lvqObject_t * py_lvq = reinterpret_cast<lvqObject_t *>(self);
+
+    if (0 < py_lvq->exports)
+        throw std::logic_error("Prototypes are exported");
+
+    // Re-create ml::lvq instance (the lock and snapshots are kept)
+    lvqObject_t created;
+    ::memset(&created, 0, sizeof(created));
+    created.lock      = py_lvq->lock;
+    created.snapshots = py_lvq->snapshots;
+
+    liblvq__lvq__create(&created, args, kwds);
+
+    bool exported;
+    {
+        lvq_writer access(self);
+
+        // Prototype exports are created with the GIL held; check them
+        // and replace the model atomically
+        PyGILState_STATE gil = PyGILState_Ensure();
+
+        exported = 0 < py_lvq->exports;
+
+        if (!exported) {
+            std::swap(py_lvq->lvq,         created.lvq);
+            std::swap(py_lvq->dense,       created.dense);
+            std::swap(py_lvq->allow_undef, created.allow_undef);
+        }
+
+        PyGILState_Release(gil);
+
+        if (!exported) snapshot_publish(self);
+    }
+
+    created.lock      = NULL;
+    created.snapshots = NULL;
+    liblvq__lvq__destroy(&created);
+
+    if (exported)
+        throw std::logic_error("Prototypes are exported");
+
+    return 0;
+}
+
+/** \cond */
+static int BINDING_IDENT(liblvq__lvq__init)(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    return wrap_X((int)-1, liblvq__lvq__init, self, args, kwds);
+}
+/** \endcond */
+
+
+/** Dense prototypes copy access */
+#define python2lvq_dense(self) \
+    ((reinterpret_cast<lvqObject_t *>(self))->dense)
+
+
+/**
+ *  \brief  Reject undefined input values if not allowed
+ *
+ *  Models created with \c allow_undef=False don't accept undefined values.
+ *
+ *  \param  self   Python LVQ object
+ *  \param  input  Input
+ */
+static void check_undef(PyObject * self, const lvq_t::input_t & input) {
+    if (reinterpret_cast<lvqObject_t *>(self)->allow_undef) return;
+
+    for (size_t j = 0; j < input.rank(); ++j)
+        if (!input[j].is_defined())
+            throw std::logic_error("Undefined input values not allowed");
+}
+
+/** \cond */
+static void check_undef(PyObject * self, const tset_classifier_t & set) {
+    for (const auto & sample: set) check_undef(self, sample.first);
+}
+
+static void check_undef(PyObject * self, const tset_clustering_t & set) {
+    for (const auto & sample: set) check_undef(self, sample);
+}
+
+template <typename S>
+static void check_undef(PyObject * self, const S * x, size_t n) {
+    if (reinterpret_cast<lvqObject_t *>(self)->allow_undef) return;
+
+    if (dense_undef(x, n))
+        throw std::logic_error("Undefined input values not allowed");
+}
+
+static void check_undef(PyObject * self, const tset_arena & set) {
+    if (reinterpret_cast<lvqObject_t *>(self)->allow_undef) return;
+
+    if (0 < set.undefined_count())
+        throw std::logic_error("Undefined input values not allowed");
+}
+/** \endcond */
+
+
+/**
+ *  \brief  Refresh dense prototypes copy
+ *
+ *  Must be called with the object locked for writing.
+ *
+ *  \param  self     Python LVQ object
+ *  \param  cluster  Cluster (all if \c SIZE_MAX)
+ */
+static void dense_refresh(PyObject * self, size_t cluster = SIZE_MAX) {
+    dense_codebook * dense = python2lvq_dense(self);
+    if (NULL == dense) return;
+
+    if (SIZE_MAX == cluster)
+        dense->load(*python2lvq(self));
+    else
+        dense->set(cluster, python2lvq(self)->get(cluster));
+}
+
+
+/**
+ *  \brief  Check dense query dimension
+ *
+ *  \param  self   Python LVQ object
+ *  \param  dense  Dense prototypes
+ *  \param  x      Query
+ */
+static void check_dimension(
+    PyObject *                  self,
+    const dense_codebook &      dense,
+    const std::vector<double> & x)
+{
+    if (dense.dimension() != x.size())
+        throw std::logic_error("Invalid input (dimension mismatch)");
+
+    check_undef(self, x.data(), x.size());
+}
+
+
+//
+// Model snapshots
+//
+
+/**
+ *  \brief  Immutable model snapshot
+ *
+ *  Copy of the model (and of its dense prototypes) of a version.
+ *  Snapshots are shared by readers (classification, testing)
+ *  which therefore don't lock the model, so they aren't blocked
+ *  by training; a snapshot is released by its last reader.
+ *  Snapshots of models without \c ml::lvq instance (see \ref python2lvq)
+ *  build it from the dense prototypes once needed.
+ */
+class lvq_snapshot {
+    private:
+
+    const uint64_t                        m_version;  /**< Model version      */
+    const uint64_t                        m_tuning;   /**< Tuning generation  */
+    mutable std::unique_ptr<const lvq_t>  m_lvq;      /**< Model (lazy)       */
+    mutable std::once_flag                m_lvq_once; /**< Model built        */
+    const std::unique_ptr<dense_codebook> m_copy;     /**< Dense copy         */
+    const dense_codebook * const          m_dense;    /**< Dense prototypes   */
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  version  Model version
+     *  \param  tuning   Search tuning generation
+     *  \param  lvq      Model (or \c NULL if \c dense is given)
+     *  \param  dense    Dense prototypes (or \c NULL)
+     */
+    lvq_snapshot(
+        uint64_t               version,
+        uint64_t               tuning,
+        const lvq_t *          lvq,
+        const dense_codebook * dense)
+    :
+        m_version(version),
+        m_tuning(tuning),
+        m_lvq(NULL != lvq ? new lvq_t(*lvq) : NULL),
+        m_copy(NULL != dense ? dense->clone() : NULL),
+        m_dense(m_copy.get())
+    {}
+
+    /** Model version */
+    uint64_t version() const { return m_version; }
+
+    /** Search tuning generation */
+    uint64_t tuning() const { return m_tuning; }
+
+    /** Snapshot is of the current model version and tuning */
+    bool current(const snapshot_cell & cell) const {
+        return cell.version() == m_version && cell.tuning() == m_tuning;
+    }
+
+    /** Model */
+    const lvq_t & lvq() const {
+        std::call_once(m_lvq_once, [this]() {
+            if (!m_lvq) m_lvq.reset(codebook2lvq(*m_dense));
+        });
+
+        return *m_lvq;
+    }
+
+    /** Dimension */
+    size_t dimension() const {
+        return m_dense ? m_dense->dimension() : lvq().dimension();
+    }
+
+    /** Clusters count */
+    size_t clusters() const {
+        return m_dense ? m_dense->clusters() : lvq().clusters();
+    }
+
+    /** Dense prototypes (or \c NULL) */
+    const dense_codebook * dense() const { return m_dense; }
+
+    private:
+
+    lvq_snapshot(const lvq_snapshot &);
+    lvq_snapshot & operator = (const lvq_snapshot &);
+
+};  // end of class lvq_snapshot
+
+/** Shared snapshot */
+typedef std::shared_ptr<const lvq_snapshot> lvq_snapshot_ptr;
+
+
+/**
+ *  \brief  Publish snapshot of the current model version
+ *
+ *  Must be called with the object locked (for reading or writing).
+ *  The snapshot is only made if the published one is stale.
+ *
+ *  \param  self  Python LVQ object
+ *
+ *  \return Published snapshot
+ */
+static lvq_snapshot_ptr snapshot_publish(PyObject * self) {
+    snapshot_cell & cell = python2lvq_snapshots(self);
+    std::unique_lock<std::mutex> lock(cell.mutex());
+
+    lvq_snapshot_ptr snapshot = cell.load();
+    if (snapshot && snapshot->current(cell)) return snapshot;
+
+    const lvq_t *          lvq   = reinterpret_cast<lvqObject_t *>(self)->lvq;
+    const dense_codebook * dense = python2lvq_dense(self);
+
+    snapshot = std::make_shared<const lvq_snapshot>(
+        cell.version(), cell.tuning(), lvq, dense);
+
+    const size_t copies = (NULL != lvq ? 1 : 0) + (NULL != dense ? 1 : 0);
+    cell.store(snapshot,
+        copies * snapshot->clusters() * snapshot->dimension());
+
+    return snapshot;
+}
+
+
+/**
+ *  \brief  Publish modified model (writers)
+ *
+ *  Must be called with the object locked for writing.
+ *  The snapshot is published if due (see \ref snapshot_cell),
+ *  otherwise (or if it fails) the publication is deferred.
+ *
+ *  \param  self  Python LVQ object
+ */
+static void snapshot_update(PyObject * self) {
+    snapshot_cell & cell = python2lvq_snapshots(self);
+
+    try {
+        if (cell.due()) {
+            snapshot_publish(self);
+            return;
+        }
+    }
+    catch (...) {}  // deferred
+
+    try {
+        cell.defer([self]() {
+            rwlock & lock = python2lvq_lock(self);
+            lock.lock_shared();
+
+            try { snapshot_publish(self); }
+            catch (...) {
+                lock.unlock_shared();
+                throw;
+            }
+
+            lock.unlock_shared();
+        });
+    }
+    catch (...) {}  // the next modification publishes
+}
+
+
+/**
+ *  \brief  Latest published snapshot
+ *
+ *  Snapshots are published by writers (see \ref snapshot_update)
+ *  so readers neither lock nor copy; modifications of large models
+ *  may be published with delay (see \ref snapshot_cell).
+ *  The snapshot may be kept (it's immutable).
+ *
+ *  \param  self  Python LVQ object
+ *
+ *  \return Snapshot
+ */
+static lvq_snapshot_ptr snapshot_acquire(PyObject * self) {
+    return python2lvq_snapshots(self).load();
+}
+
+
+/**
+ *  \brief  Set all prototypes from matrix rows
+ *
+ *  Must be called with the object locked for writing.
+ *
+ *  \param  self    Python LVQ object
+ *  \param  rows    Prototype rows (NaN stands for undefined value)
+ *  \param  stride  Row stride (items)
+ */
+template <typename S>
+static void rows2prototypes(PyObject * self, const S * rows, size_t stride) {
+    lvq_t & lvq = *python2lvq(self);
+    const size_t dim = lvq.dimension();
+
+    lvq_t::input_t input(dim);
+
+    for (size_t c = 0; c < lvq.clusters(); ++c) {
+        const S * row = rows + c * stride;
+
+        for (size_t j = 0; j < dim; ++j)
+            input[j] = std::isnan(row[j])
+                     ? lvq_t::base_t::undef
+                     : lvq_t::base_t(row[j]);
+
+        lvq.set(input, c);
+    }
+
+    dense_refresh(self);
+}
+
+
+/**
+ *  \brief  Check prototype matrix rows
+ *
+ *  \param  self    Python LVQ object
+ *  \param  rows    Prototype rows
+ *  \param  stride  Row stride (items)
+ */
+template <typename S>
+static void check_prototypes(PyObject * self, const S * rows, size_t stride) {
+    const lvq_t & lvq = *python2lvq(self);
+
+    for (size_t c = 0; c < lvq.clusters(); ++c)
+        check_undef(self, rows + c * stride, lvq.dimension());
+}
+
+
+/**
+ *  \brief  Writable prototypes export of the object
+ *
+ *  \param  self       Python LVQ object
+ *  \param  py_matrix  Python object
+ *
+ *  \return Exporter of the writable \c prototypes view \c py_matrix
+ *          (or of the view it's derived from), \c NULL if it's not one
+ */
+static bufferExporterObject_t * prototypes_export(
+    PyObject * self,
+    PyObject * py_matrix)
+{
+    if (!PyMemoryView_Check(py_matrix)) return NULL;
+
+    PyObject * base = PyMemoryView_GET_BASE(py_matrix);
+    if (NULL == base || &bufferExporterType != Py_TYPE(base)) return NULL;
+
+    bufferExporterObject_t * exporter =
+        reinterpret_cast<bufferExporterObject_t *>(base);
+
+    if (self != exporter->owner || exporter->readonly) return NULL;
+
+    return exporter;
+}
+
+
+/**
+ *  \brief  Open training/test set file
+ *
+ *  The file is mapped with the GIL released and checked to fit the model.
+ *
+ *  \param  self    Python LVQ object
+ *  \param  path    File path
+ *  \param  superv  Labels are required
+ *
+ *  \return Training set file
+ */
+static std::unique_ptr<tset_file> open_tset(
+    PyObject *          self,
+    const std::string & path,
+    bool                superv)
+{
+    std::unique_ptr<tset_file> file;
+    {
+        gil_release nogil;
+        file.reset(new tset_file(path));
+    }
+
+    file->check(model_dimension(self), superv);
+    check_undef(self, file->matrix(), file->size() * file->dimension());
+
+    return file;
+}
+
+
+/**
+ *  \brief  Get native training/test set
+ *
+ *  \c TrainingSet objects are used as they are (no conversion);
+ *  binary training set file paths are opened (see \ref open_tset).
+ *  The set is checked to fit the model.
+ *
+ *  \param  self    Python LVQ object
+ *  \param  py_set  Training/test set
+ *  \param  superv  Labels are required
+ *  \param  file    Training set file (output, if opened)
+ *
+ *  \return Native training set or \c NULL (Python sequence or buffer)
+ */
+static const tset_matrix * python2tset_matrix(
+    PyObject *                   self,
+    PyObject *                   py_set,
+    bool                         superv,
+    std::unique_ptr<tset_file> & file)
+{
+    if (PyObject_TypeCheck(py_set, get_trainingSetType())) {
+        const tset_arena & set = *python2tset_arena(py_set);
+
+        set.check(model_dimension(self), superv);
+        check_undef(self, set);
+
+        return &set;
+    }
+
+    std::string path;
+    if (!python2path(py_set, path)) return NULL;
+
+    file = open_tset(self, path, superv);
+
+    return file.get();
+}
+
+
+/**
+ *  \brief  ml::lvq::set binding
+ */
+static PyObject * liblvq__lvq__set(PyObject * self, PyObject * args) {
+    // Get arguments
+    PyObject * py_input;
+    size_t     cluster;
+    parse_args(args, "On", &py_input, &cluster);
+
+    const lvq_t::input_t input = python2input(py_input);
+    check_undef(self, input);
+
+    // Call implementation
+    {
+        lvq_writer access(self);
+        python2lvq(self)->set(input, cluster);
+        dense_refresh(self, cluster);
+    }
+
+    // No return value
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+BINDING_INST(liblvq__lvq__set)
+
+
+/**
+ *  \brief  ml::lvq::get binding
+ */
+static PyObject * liblvq__lvq__get(PyObject * self, PyObject * args) {
+    // Get arguments
+    size_t cluster;
+    parse_args(args, "n", &cluster);
+
+    // Call implementation (representant copy is made under lock)
+    const lvq_t::input_t representant = [self, cluster]() -> lvq_t::input_t {
+        lvq_reader access(self);
+        return python2lvq(self)->get(cluster);
+    }();
+
+    // Transform result
+    return input2python(representant);
+}
+
+BINDING_INST(liblvq__lvq__get)
+
+
+/**
+ *  \brief  Prototype matrix
+ *
+ *  Returns clusters x dimension \c memoryview of the prototypes
+ *  (NaN stands for undefined value).
+ *  Read-only prototypes of dense models (see \c dtype) without
+ *  undefined values are exported in place (no copy; rows are padded,
+ *  the view reflects further training); a float64 copy is exported
+ *  otherwise.
+ *  \c writable views are always float64 copies (never zero-copy);
+ *  changes are committed explicitly by \c set_prototypes(view),
+ *  which raises if the model was modified since the export (or if
+ *  the rows are invalid). Releasing the view doesn't write it back.
+ */
+static PyObject * liblvq__lvq__prototypes(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = { "writable", NULL };
+
+    int writable = 0;
+    parse_args_kw(args, kwds, "|p", kwlist, &writable);
+
+    Py_ssize_t * exports = &reinterpret_cast<lvqObject_t *>(self)->exports;
+
+    // In place export (the model isn't replaced while exported)
+    const dense_codebook * dense = python2lvq_dense(self);
+
+    if (NULL != dense && dense->complete() && !writable) {
+        return exporter2view(new_exporter(self, exports,
+            dense->data(), sizeof(float) == dense->itemsize() ? "f" : "d",
+            dense->itemsize(), dense->clusters(), dense->dimension(),
+            dense->stride(), true));
+    }
+
+    // Copy
+    const size_t ccnt = model_clusters(self);
+    const size_t dim  = model_dimension(self);
+
+    bufferExporterObject_t * exporter = new_exporter(self, exports,
+        NULL, "d", sizeof(double), ccnt, dim, dim, !writable);
+
+    py_ref py_exporter(reinterpret_cast<PyObject *>(exporter));
+    {
+        lvq_reader access(self);
+
+        const lvq_t & lvq = *python2lvq(self);
+        if (ccnt != lvq.clusters() || dim != lvq.dimension())
+            throw std::logic_error("Model changed during export");
+
+        double * rows = static_cast<double *>(exporter->data);
+
+        for (size_t c = 0; c < ccnt; ++c)
+            input2dense(lvq.get(c), rows + c * dim);
+
+        exporter->version = python2lvq_snapshots(self).version();
+    }
+
+    return exporter2view(
+        reinterpret_cast<bufferExporterObject_t *>(py_exporter.release()));
+}
+
+BINDING_INST_KW(liblvq__lvq__prototypes)
+
+
+/**
+ *  \brief  Set all prototypes
+ *
+ *  \c matrix is a clusters x dimension C-contiguous float64/float32
+ *  buffer (NaN stands for undefined value); it's copied natively.
+ *  Writable \c prototypes views of the model are only set if the model
+ *  wasn't modified since their export (e.g. trained meanwhile);
+ *  the view may be committed again after further changes.
+ */
+static PyObject * liblvq__lvq__set_prototypes(PyObject * self, PyObject * args) {
+    // Get arguments
+    PyObject * py_matrix;
+    parse_args(args, "O", &py_matrix);
+
+    buffer_view matrix(py_matrix);
+    check_input_matrix(matrix, model_dimension(self));
+
+    if (model_clusters(self) != matrix.rows())
+        throw std::logic_error("Invalid input matrix (clusters count mismatch)");
+
+    const bool f32 = buffer_view::FLOAT32 == matrix.dtype();
+
+    if (f32)
+        check_prototypes(self, matrix.data<const float>(), matrix.cols());
+    else
+        check_prototypes(self, matrix.data<const double>(), matrix.cols());
+
+    bufferExporterObject_t * exporter = prototypes_export(self, py_matrix);
+
+    // Call implementation (a stale view doesn't modify the model)
+    {
+        gil_release nogil;
+        std::unique_lock<rwlock> access(python2lvq_lock(self));
+
+        snapshot_cell & snapshots = python2lvq_snapshots(self);
+        if (NULL != exporter && snapshots.version() != exporter->version)
+            throw std::logic_error("Model changed since prototypes export");
+
+        snapshots.modified();
+
+        if (f32)
+            rows2prototypes(self, matrix.data<const float>(), matrix.cols());
+        else
+            rows2prototypes(self, matrix.data<const double>(), matrix.cols());
+
+        if (NULL != exporter) exporter->version = snapshots.version();
+
+        snapshot_update(self);
+    }
+
+    Py_RETURN_NONE;
+}
+
+BINDING_INST(liblvq__lvq__set_prototypes)
+
+
+/**
+ *  \brief  ml::lvq::set_random binding
+ */
+static PyObject * liblvq__lvq__set_random(PyObject * self, PyObject * args) {
+    // Get arguments
+    size_t cluster = SIZE_MAX;
+    parse_args(args, "|n", &cluster);
+
+    // Call implementation
+    {
+        lvq_writer access(self);
+
+        if (SIZE_MAX == cluster)
+            python2lvq(self)->set_random();
+        else
+            python2lvq(self)->set_random(cluster);
+
+        dense_refresh(self, cluster);
+    }
+
+    // No return value
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+BINDING_INST(liblvq__lvq__set_random)
+
+
+/**
+ *  \brief  Set prototypes from data
+ *
+ *  Prototypes are set to training samples chosen by \c method:
+ *  - \c "kmeans++" (default): k-means++ seeding,
+ *  - \c "kmeans||": k-means|| seeding (\c rounds oversampling rounds),
+ *  - \c "stratified": random sample of each class (labelled sets only;
+ *    prototype \c c is a sample of class \c c).
+ *
+ *  \c set is a training set as accepted by \c train_* methods
+ *  (labels may also be given separately, see \c TrainingSet).
+ *  Distances are computed by \c threads worker threads (module pool
+ *  by default) without the model locked; the RNG is seeded by
+ *  \c rng_seed.
+ */
+static PyObject * liblvq__lvq__set_from_data(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = {
+        "set", "method", "labels", "threads", "rounds", NULL };
+
+    PyObject *   py_set;
+    const char * method    = "kmeans++";
+    PyObject *   py_labels = Py_None;
+    size_t       threads   = 0;
+    unsigned     rounds    = 5;
+    parse_args_kw(args, kwds, "O|sOnI", kwlist,
+        &py_set, &method, &py_labels, &threads, &rounds);
+
+    const bool stratified = 0 == ::strcmp(method, "stratified");
+
+    if (!stratified &&
+        0 != ::strcmp(method, "kmeans++") && 0 != ::strcmp(method, "kmeans||"))
+    {
+        throw std::logic_error("Invalid seeding method "
+            "(\"kmeans++\", \"kmeans||\" or \"stratified\" expected)");
+    }
+
+    // Native training set (converted unless given)
+    std::unique_ptr<tset_file>  file;
+    std::unique_ptr<tset_arena> arena;
+
+    const tset_matrix * set = Py_None == py_labels
+        ? python2tset_matrix(self, py_set, stratified, file)
+        : NULL;
+
+    if (NULL == set) {
+        arena = new_tset_arena(py_set, py_labels, false);
+        arena->check(model_dimension(self), stratified);
+        check_undef(self, *arena);
+
+        set = arena.get();
+    }
+
+    std::shared_ptr<thread_pool> pool = 0 < threads
+        ? std::make_shared<thread_pool>(threads)
+        : get_pool();
+
+    const size_t ccnt = model_clusters(self);
+    const size_t dim  = model_dimension(self);
+
+    // Seeds are chosen without the model locked
+    std::vector<double> rows(ccnt * dim);
+    {
+        gil_release nogil;
+
+        prototype_seeder seeder(*set, *pool, rng_draw());
+
+        const std::vector<size_t> seeds = stratified
+            ? seeder.stratified(ccnt)
+            : 0 == ::strcmp(method, "kmeans||")
+            ? seeder.kmeans_parallel(ccnt, rounds)
+            : seeder.kmeanspp(ccnt);
+
+        for (size_t c = 0; c < ccnt; ++c)
+            std::copy(set->row(seeds[c]), set->row(seeds[c]) + dim,
+                rows.begin() + c * dim);
+    }
+
+    // Call implementation
+    {
+        lvq_writer access(self);
+        rows2prototypes(self, rows.data(), dim);
+    }
+
+    Py_RETURN_NONE;
+}
+
+BINDING_INST_KW(liblvq__lvq__set_from_data)
+
+
+/**
+ *  \brief  Online training step of dense model
+ *
+ *  The best matching unit is found on the dense prototypes (masked
+ *  kernels, pruning; see \ref dense_codebook::nearest), so the step
+ *  costs no scalar scan of the \c ml::lvq prototypes.
+ *  The LVQ1 update (BMU attracted to the input, or repelled if \c cluster
+ *  is given and doesn't match the BMU) then runs on the float64 copy
+ *  of the \c ml::lvq prototype, which is written back to the model
+ *  and refreshed in the dense prototypes (that row only).
+ *  Storage rounding therefore never leaks into the model.
+ *
+ *  Must be called with the object locked for writing.
+ *
+ *  \param  lvq      Model
+ *  \param  dense    Dense prototypes
+ *  \param  x        Input (undefined values are NaN)
+ *  \param  cluster  Input cluster (\c SIZE_MAX for unsupervised step)
+ *  \param  lfactor  Learning factor
+ *
+ *  \return Squared norm of the prototype shift
+ */
+static double train1_dense(
+    lvq_t &          lvq,
+    dense_codebook & dense,
+    const double *   x,
+    size_t           cluster,
+    double           lfactor)
+{
+    const size_t dim = lvq.dimension();
+
+    if (SIZE_MAX != cluster && lvq.clusters() <= cluster)
+        throw std::logic_error("Invalid cluster");
+
+    const size_t bmu = dense.nearest(x);
+    if (SIZE_MAX != cluster && cluster != bmu) lfactor = -lfactor;
+
+    static thread_local std::vector<double> w;
+    w.resize(dim);
+    input2dense(lvq.get(bmu), w.data());
+
+    const double dnorm2 = simd().update(w.data(), x, lfactor, dim);
+
+    lvq_t::input_t proto(dim);
+    dense2input(w.data(), proto);
+
+    lvq.set(proto, bmu);
+    dense.set(bmu, proto);
+
+    return dnorm2;
+}
+
+
+/**
+ *  \brief  Online training step binding implementation
+ *
+ *  Dense models train by \ref train1_dense, others by \c ml::lvq.
+ *
+ *  \param  self     Python LVQ object
+ *  \param  input    Input
+ *  \param  cluster  Input cluster (\c SIZE_MAX for unsupervised step)
+ *  \param  lfactor  Learning factor
+ *
+ *  \return Squared norm of the prototype shift
+ */
+static double train1(
+    PyObject *             self,
+    const lvq_t::input_t & input,
+    size_t                 cluster,
+    double                 lfactor)
+{
+    lvq_writer access(self);
+
+    lvq_t &          lvq   = *python2lvq(self);
+    dense_codebook * dense = python2lvq_dense(self);
+
+    if (NULL != dense) {
+        if (input.rank() != lvq.dimension())
+            throw std::logic_error("Invalid input (dimension mismatch)");
+
+        std::vector<double> x(input.rank());
+        input2dense(input, x.data());
+
+        return train1_dense(lvq, *dense, x.data(), cluster, lfactor);
+    }
+
+    return SIZE_MAX != cluster
+        ? lvq.train1_supervised(input, cluster, lfactor)
+        : lvq.train1_unsupervised(input, lfactor);
+}
+
+
+/**
+ *  \brief  \c ml::lvq::train1_supervised binding
+ */
+static PyObject * liblvq__lvq__train1_supervised(PyObject * self, PyObject * args) {
+    // Get arguments
+    PyObject *    py_input;
+    size_t        cluster;
+    lvq_t::base_t lfactor;
+    parse_args(args, "Ond", &py_input, &cluster, &lfactor);
+
+    const lvq_t::input_t input = python2input(py_input);
+    check_undef(self, input);
+
+    // Call implementation
+    const double dnorm2 = train1(self, input, cluster, lfactor);
+
+    // Transform result
+    return Py_BuildValue("d", dnorm2);
+}
+
+BINDING_INST(liblvq__lvq__train1_supervised)
+
+
+/**
+ *  \brief  \c ml::lvq::train1_unsupervised binding
+ */
+static PyObject * liblvq__lvq__train1_unsupervised(PyObject * self, PyObject * args) {
+    // Get arguments
+    PyObject *    py_input;
+    lvq_t::base_t lfactor;
+    parse_args(args, "Od", &py_input, &lfactor);
+
+    const lvq_t::input_t input = python2input(py_input);
+    check_undef(self, input);
+
+    // Call implementation
+    const double dnorm2 = train1(self, input, SIZE_MAX, lfactor);
+
+    // Transform result
+    return Py_BuildValue("d", dnorm2);
+}
+
+BINDING_INST(liblvq__lvq__train1_unsupervised)
+
+
+/**
+ *  \brief  Learning factor schedule
+ *
+ *  Learning factor of online training step \c t:
+ *  - \c CONSTANT:    \c lfactor
+ *  - \c INVERSE:     \c lfactor/(1+decay*t)
+ *  - \c EXPONENTIAL: \c lfactor*exp(-decay*t)
+ *  - \c STEP:        \c lfactor*exp(-decay*floor(t/step))
+ */
+class lfactor_schedule {
+    public:
+
+    /** Schedule kind */
+    enum kind_t {
+        CONSTANT,     /**< Constant learning factor     */
+        INVERSE,      /**< Inverse-time decay           */
+        EXPONENTIAL,  /**< Exponential decay            */
+        STEP,         /**< Exponential decay in steps   */
+    };  // end of enum kind_t
+
+    private:
+
+    kind_t m_kind;     /**< Schedule kind          */
+    double m_lfactor;  /**< Initial factor         */
+    double m_decay;    /**< Decay rate             */
+    size_t m_step;     /**< Step length (\c STEP)  */
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  kind     Schedule kind
+     *  \param  lfactor  Initial learning factor
+     *  \param  decay    Decay rate
+     *  \param  step     Step length (\c STEP schedule)
+     */
+    lfactor_schedule(kind_t kind, double lfactor, double decay, size_t step = 1):
+        m_kind(kind),
+        m_lfactor(lfactor),
+        m_decay(decay),
+        m_step(step)
+    {
+        if (0.0 > decay)
+            throw std::logic_error("Invalid schedule (negative decay)");
+
+        if (0 == step)
+            throw std::logic_error("Invalid schedule (zero step)");
+    }
+
+    /**
+     *  \brief  Constructor (kind by name)
+     *
+     *  \param  name     \c "constant", \c "inverse", \c "exponential" or \c "step"
+     *  \param  lfactor  Initial learning factor
+     *  \param  decay    Decay rate
+     *  \param  step     Step length (\c "step" schedule)
+     */
+    lfactor_schedule(const char * name, double lfactor, double decay, size_t step):
+        lfactor_schedule(name2kind(name), lfactor, decay, step)
+    {}
+
+    /** Schedule kind by name */
+    static kind_t name2kind(const char * name) {
+        if (0 == ::strcmp(name, "constant"))    return CONSTANT;
+        if (0 == ::strcmp(name, "inverse"))     return INVERSE;
+        if (0 == ::strcmp(name, "exponential")) return EXPONENTIAL;
+        if (0 == ::strcmp(name, "step"))        return STEP;
+
+        throw std::logic_error("Invalid schedule (\"constant\", \"inverse\", "
+            "\"exponential\" or \"step\" expected)");
+    }
+
+    /** Learning factor of step \c t */
+    double operator () (size_t t) const {
+        switch (m_kind) {
+            case CONSTANT:    return m_lfactor;
+            case INVERSE:     return m_lfactor / (1.0 + m_decay * t);
+            case EXPONENTIAL: return m_lfactor * std::exp(-m_decay * t);
+            case STEP:        return m_lfactor * std::exp(-m_decay * (t / m_step));
+        }
+
+        return m_lfactor;  // unreachable
+    }
+
+};  // end of class lfactor_schedule
+
+
+/**
+ *  \brief  Batched online training
+ *
+ *  Applies online training steps (see \c train1_*) on matrix rows
+ *  in order, with the GIL released.
+ *  Step \c i uses learning factor \c schedule(start+i).
+ *
+ *  \param  self      Python LVQ object
+ *  \param  matrix    Sample matrix (float64 or float32)
+ *  \param  labels    Sample clusters (or \c NULL for unsupervised steps)
+ *  \param  schedule  Learning factor schedule
+ *  \param  start     Schedule step of the first sample
+ *  \param  dnorm2    Squared norms of prototype shifts (output)
+ */
+static void train1_batch(
+    PyObject *                   self,
+    const buffer_view &          matrix,
+    const std::vector<int64_t> * labels,
+    const lfactor_schedule &     schedule,
+    size_t                       start,
+    double *                     dnorm2)
+{
+    const size_t rows = matrix.rows();
+    const size_t dim  = matrix.cols();
+
+    if (NULL != labels && rows != labels->size())
+        throw std::logic_error("Invalid labels (size mismatch)");
+
+    lvq_writer access(self);
+
+    lvq_t &          lvq   = *python2lvq(self);
+    dense_codebook * dense = python2lvq_dense(self);
+    const size_t     ccnt  = lvq.clusters();
+
+    check_input_matrix(matrix, lvq.dimension());
+
+    if (NULL != labels)
+        for (int64_t label: *labels)
+            if (0 > label || ccnt <= (size_t)label)
+                throw std::logic_error("Invalid cluster");
+
+    for (size_t i = 0; i < rows; ++i) {
+        if (buffer_view::FLOAT64 == matrix.dtype())
+            check_undef(self, matrix.row<const double>(i), dim);
+        else
+            check_undef(self, matrix.row<const float>(i), dim);
+    }
+
+    // Dense model: BMU search on the dense prototypes
+    if (NULL != dense) {
+        std::vector<double> x(dim);
+
+        for (size_t i = 0; i < rows; ++i) {
+            const double * row = x.data();
+
+            if (buffer_view::FLOAT64 == matrix.dtype())
+                row = matrix.row<const double>(i);
+            else
+                std::copy(matrix.row<const float>(i),
+                    matrix.row<const float>(i) + dim, x.begin());
+
+            dnorm2[i] = train1_dense(lvq, *dense, row,
+                NULL != labels ? (size_t)(*labels)[i] : SIZE_MAX,
+                schedule(start + i));
+        }
+
+        return;
+    }
+
+    lvq_t::input_t input(dim);
+
+    for (size_t i = 0; i < rows; ++i) {
+        row2input(matrix, i, input);
+
+        const lvq_t::base_t lf(schedule(start + i));
+
+        dnorm2[i] = NULL != labels
+            ? lvq.train1_supervised(input, (size_t)(*labels)[i], lf)
+            : lvq.train1_unsupervised(input, lf);
+    }
+}
+
+
+/**
+ *  \brief  Batched \c ml::lvq::train1_supervised binding
+ *
+ *  Trains on rows of a 2-D C-contiguous float64/float32 buffer
+ *  (see \ref train1_batch and \ref lfactor_schedule).
+ *  Returns \c array('d') of the steps' squared prototype shift norms.
+ */
+static PyObject * liblvq__lvq__train1_supervised_batch(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = {
+        "matrix", "labels", "schedule", "lfactor", "decay", "step", "start",
+        NULL };
+
+    PyObject *   py_matrix;
+    PyObject *   py_labels;
+    const char * schedule = "constant";
+    double       lfactor  = 0.1;
+    double       decay    = 0.0;
+    size_t       step     = 1;
+    size_t       start    = 0;
+    parse_args_kw(args, kwds, "OO|sddnn", kwlist,
+        &py_matrix, &py_labels, &schedule, &lfactor, &decay, &step, &start);
+
+    const lfactor_schedule sched(schedule, lfactor, decay, step);
+
+    buffer_view matrix(py_matrix);
+
+    std::vector<int64_t> labels;
+    python2labels(py_labels, labels);
+
+    py_ref py_result(new_array("d", matrix.rows(), sizeof(double)));
+    buffer_view out(py_result.get(), true);
+
+    // Call implementation
+    train1_batch(self, matrix, &labels, sched, start, out.data<double>());
+
+    return py_result.release();
+}
+
+BINDING_INST_KW(liblvq__lvq__train1_supervised_batch)
+
+
+/**
+ *  \brief  Batched \c ml::lvq::train1_unsupervised binding
+ *
+ *  See \ref liblvq__lvq__train1_supervised_batch.
+ */
+static PyObject * liblvq__lvq__train1_unsupervised_batch(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = {
+        "matrix", "schedule", "lfactor", "decay", "step", "start", NULL };
+
+    PyObject *   py_matrix;
+    const char * schedule = "constant";
+    double       lfactor  = 0.1;
+    double       decay    = 0.0;
+    size_t       step     = 1;
+    size_t       start    = 0;
+    parse_args_kw(args, kwds, "O|sddnn", kwlist,
+        &py_matrix, &schedule, &lfactor, &decay, &step, &start);
+
+    const lfactor_schedule sched(schedule, lfactor, decay, step);
+
+    buffer_view matrix(py_matrix);
+
+    py_ref py_result(new_array("d", matrix.rows(), sizeof(double)));
+    buffer_view out(py_result.get(), true);
+
+    // Call implementation
+    train1_batch(self, matrix, NULL, sched, start, out.data<double>());
+
+    return py_result.release();
+}
+
+BINDING_INST_KW(liblvq__lvq__train1_unsupervised_batch)
+
+
+/**
+ *  \brief  Train LVQ model using mini-batch trainer
+ *
+ *  Must be called with the object locked for writing.
+ *  The prototypes are stored and published after each loop
+ *  (see \ref snapshot_publish).
+ *
+ *  \param  self         Python LVQ object
+ *  \param  trainer      Mini-batch trainer (of the model)
+ *  \param  batch_size   Batch size
+ *  \param  threads      Worker threads count (0 means module pool)
+ *  \param  conv_win     Convergence window
+ *  \param  max_div_cnt  Max. number of diverging loops in a row
+ *  \param  max_tlc      Max. number of training loops
+ */
+static void train_minibatch(
+    PyObject *          self,
+    minibatch_trainer & trainer,
+    size_t              batch_size,
+    size_t              threads,
+    unsigned            conv_win,
+    unsigned            max_div_cnt,
+    unsigned            max_tlc)
+{
+    std::shared_ptr<thread_pool> pool = 0 < threads
+        ? std::make_shared<thread_pool>(threads)
+        : get_pool();
+
+    trainer.train(*pool, batch_size, conv_win, max_div_cnt, max_tlc, NULL,
+    [self, &trainer]() {
+        python2lvq_snapshots(self).modified();
+        trainer.store(*python2lvq(self));
+        dense_refresh(self);
+        snapshot_publish(self);
+    });
+}
+
+
+/**
+ *  \brief  \c ml::lvq::train_supervised binding
+ *
+ *  \c mode="minibatch" selects data-parallel mini-batch training
+ *  (see \ref minibatch_trainer) using \c threads worker threads
+ *  (module pool by default); \c batch_size=1 is the sequential training.
+ *  \c set may also be a binary training set file path
+ *  (see \ref write_tset); the file is mapped to memory.
+ *  \c TrainingSet objects are used without conversion.
+ */
+static PyObject * liblvq__lvq__train_supervised(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = {
+        "set", "conv_win", "max_div_cnt", "max_tlc",
+        "mode", "batch_size", "threads", NULL };
+
+    PyObject *   py_set;
+    unsigned     conv_win    = LIBLVQ__ML__LVQ__TRAIN__CONV_WIN;
+    unsigned     max_div_cnt = LIBLVQ__ML__LVQ__TRAIN__MAX_DIV_CNT;
+    unsigned     max_tlc     = LIBLVQ__ML__LVQ__TRAIN__MAX_TLC;
+    const char * mode        = NULL;
+    size_t       batch_size  = 1024;
+    size_t       threads     = 0;
+    parse_args_kw(args, kwds, "O|IIIsnn", kwlist,
+        &py_set, &conv_win, &max_div_cnt, &max_tlc,
+        &mode, &batch_size, &threads);
+
+    const bool minibatch = train_mode_minibatch(mode, batch_size);
+
+    std::unique_ptr<tset_file> file;
+    const tset_matrix * native = python2tset_matrix(self, py_set, true, file);
+
+    tset_classifier_t         conv;
+    const tset_classifier_t * set = &conv;
+
+    if (NULL != native) {
+        if (!minibatch) {
+            gil_release nogil;
+            set = &native->classifier_set(conv);  // cached by TrainingSet
+        }
+    }
+    else {
+        conv = python2tset_classifier(py_set);
+        check_undef(self, conv);
+    }
+
+    // Call implementation
+    {
+        lvq_writer access(self);
+        lvq_t & lvq = *python2lvq(self);
+
+        if (minibatch) {
+            std::unique_ptr<minibatch_trainer> trainer(native
+                ? new minibatch_trainer(lvq, *native, true)
+                : new minibatch_trainer(lvq, conv));
+
+            train_minibatch(self, *trainer,
+                batch_size, threads, conv_win, max_div_cnt, max_tlc);
+        }
+        else
+            lvq.train_supervised(*set, conv_win, max_div_cnt, max_tlc);
+
+        dense_refresh(self);
+        snapshot_publish(self);
+    }
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+BINDING_INST_KW(liblvq__lvq__train_supervised)
+
+
+/**
+ *  \brief  \c ml::lvq::train_unsupervised binding
+ *
+ *  \c mode="minibatch" selects data-parallel mini-batch training
+ *  (see \ref minibatch_trainer) using \c threads worker threads
+ *  (module pool by default); \c batch_size=1 is the sequential training.
+ *  \c set may also be a binary training set file path
+ *  (see \ref write_tset); the file is mapped to memory.
+ *  \c TrainingSet objects are used without conversion.
+ */
+static PyObject * liblvq__lvq__train_unsupervised(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = {
+        "set", "conv_win", "max_div_cnt", "max_tlc",
+        "mode", "batch_size", "threads", NULL };
+
+    PyObject *   py_set;
+    unsigned     conv_win    = LIBLVQ__ML__LVQ__TRAIN__CONV_WIN;
+    unsigned     max_div_cnt = LIBLVQ__ML__LVQ__TRAIN__MAX_DIV_CNT;
+    unsigned     max_tlc     = LIBLVQ__ML__LVQ__TRAIN__MAX_TLC;
+    const char * mode        = NULL;
+    size_t       batch_size  = 1024;
+    size_t       threads     = 0;
+    parse_args_kw(args, kwds, "O|IIIsnn", kwlist,
+        &py_set, &conv_win, &max_div_cnt, &max_tlc,
+        &mode, &batch_size, &threads);
+
+    const bool minibatch = train_mode_minibatch(mode, batch_size);
+
+    std::unique_ptr<tset_file> file;
+    const tset_matrix * native = python2tset_matrix(self, py_set, false, file);
+
+    tset_clustering_t         conv;
+    const tset_clustering_t * set = &conv;
+
+    if (NULL != native) {
+        if (!minibatch) {
+            gil_release nogil;
+            set = &native->clustering_set(conv);  // cached by TrainingSet
+        }
+    }
+    else {
+        conv = python2tset_clustering(py_set);
+        check_undef(self, conv);
+    }
+
+    // Call implementation
+    {
+        lvq_writer access(self);
+        lvq_t & lvq = *python2lvq(self);
+
+        if (minibatch) {
+            std::unique_ptr<minibatch_trainer> trainer(native
+                ? new minibatch_trainer(lvq, *native, false)
+                : new minibatch_trainer(lvq, conv));
+
+            train_minibatch(self, *trainer,
+                batch_size, threads, conv_win, max_div_cnt, max_tlc);
+        }
+        else
+            lvq.train_unsupervised(*set, conv_win, max_div_cnt, max_tlc);
+
+        dense_refresh(self);
+        snapshot_publish(self);
+    }
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+BINDING_INST_KW(liblvq__lvq__train_unsupervised)
+
+
+//
+// Asynchronous training
+//
+
+/**
+ *  \brief  Asynchronous training job
+ *
+ *  Runs mini-batch training (see \ref minibatch_trainer) on a native
+ *  thread with the GIL released.
+ *  The trainer works on a copy of the prototypes; the model is only
+ *  locked (for writing) when the trained prototypes are stored,
+ *  so it may be used in the meantime.
+ *  The store fails if the model was modified since the training
+ *  started (see \ref snapshot_cell::version), so that concurrent
+ *  modifications aren't silently overwritten.
+ *  Progress is reported via \ref train_monitor; asyncio futures
+ *  waiting for the job are resolved (thread-safely) on completion.
+ */
+class train_job {
+    private:
+
+    PyObject *                         m_py_job;     /**< Python job (borrowed) */
+    PyObject *                         m_py_lvq;     /**< Python LVQ object     */
+    PyObject *                         m_py_set;     /**< Python training set   */
+    std::unique_ptr<tset_file>         m_file;       /**< Training set file     */
+    std::unique_ptr<minibatch_trainer> m_trainer;    /**< Trainer               */
+    std::shared_ptr<thread_pool>       m_pool;       /**< Thread pool           */
+    size_t                             m_batch_size; /**< Batch size            */
+    unsigned                           m_conv_win;   /**< Convergence window    */
+    unsigned                           m_max_div_cnt;/**< Max. diverging loops  */
+    unsigned                           m_max_tlc;    /**< Max. training loops   */
+    uint64_t                           m_version;    /**< Model version trained */
+    train_monitor                      m_monitor;    /**< Monitor               */
+    std::atomic<bool>                  m_keep;       /**< Store if cancelled    */
+    std::thread                        m_thread;     /**< Training thread       */
+    mutable std::mutex                 m_mutex;      /**< Completion mutex      */
+    std::condition_variable            m_done_cond;  /**< Completion            */
+    bool                               m_done;       /**< Job finished          */
+    bool                               m_cancelled;  /**< Training cancelled    */
+    bool                               m_stored;     /**< Prototypes stored     */
+    std::string                        m_error;      /**< Failure (or empty)    */
+    std::vector<std::pair<PyObject *, PyObject *> > m_waiters;  /**< (loop, future) */
+
+    /** Store trained prototypes (and publish them) */
+    void store() {
+        rwlock & lock = python2lvq_lock(m_py_lvq);
+        std::unique_lock<rwlock> access(lock);
+
+        snapshot_cell & snapshots = python2lvq_snapshots(m_py_lvq);
+        if (snapshots.version() != m_version)
+            throw std::logic_error("Model changed during training");
+
+        snapshots.modified();
+
+        lvq_t & lvq = *python2lvq(m_py_lvq);
+
+        m_trainer->store(lvq);
+        dense_refresh(m_py_lvq);
+        snapshot_publish(m_py_lvq);
+    }
+
+    /**
+     *  \brief  Resolve waiting futures (with the GIL held)
+     *
+     *  Resolution is scheduled in the futures' event loops.
+     *
+     *  \return Waiters' job references to be released
+     */
+    size_t resolve() {
+        const size_t refs = m_waiters.size();
+
+        for (const auto & waiter: m_waiters) {
+            py_ref py_loop(waiter.first);
+            py_ref py_future(waiter.second);
+
+            py_ref py_resolve(PyObject_GetAttrString(m_py_job, "_resolve"));
+            py_ref py_res(NULL == py_resolve.get() ? NULL
+                : PyObject_CallMethod(py_loop.get(), "call_soon_threadsafe",
+                    "OO", py_resolve.get(), py_future.get()));
+
+            if (NULL == py_res.get()) PyErr_Clear();  // loop closed
+        }
+
+        m_waiters.clear();
+
+        return refs;
+    }
+
+    /** Training thread routine */
+    void run() {
+        try {
+            m_cancelled = !m_trainer->train(*m_pool, m_batch_size,
+                m_conv_win, m_max_div_cnt, m_max_tlc, &m_monitor);
+
+            if (!m_cancelled || m_keep) {
+                store();
+                m_stored = true;
+            }
+        }
+        catch (std::exception & x) {
+            m_error = x.what();
+        }
+        catch (...) {
+            m_error = "Unknown exception";
+        }
+
+        m_pool.reset();
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done = true;
+        }
+        m_done_cond.notify_all();
+
+        // No more waiters may be added now
+        if (!m_waiters.empty()) {
+            PyGILState_STATE gil = PyGILState_Ensure();
+
+            PyObject * py_job = m_py_job;
+            for (size_t refs = resolve(); refs; --refs)
+                Py_DECREF(py_job);  // may destroy the job, don't touch it
+
+            PyGILState_Release(gil);
+        }
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  The training is started by \c start.
+     *
+     *  \param  py_job       Python job object
+     *  \param  py_lvq       Python LVQ object (referenced)
+     *  \param  py_set       Python training set object (referenced, or \c NULL)
+     *  \param  file         Training set file (or empty)
+     *  \param  trainer      Trainer
+     *  \param  pool         Thread pool
+     *  \param  batch_size   Batch size
+     *  \param  conv_win     Convergence window
+     *  \param  max_div_cnt  Max. number of diverging loops in a row
+     *  \param  max_tlc      Max. number of training loops
+     *  \param  version      Model version the trainer was created from
+     */
+    train_job(
+        PyObject *                           py_job,
+        PyObject *                           py_lvq,
+        PyObject *                           py_set,
+        std::unique_ptr<tset_file> &&        file,
+        std::unique_ptr<minibatch_trainer> && trainer,
+        const std::shared_ptr<thread_pool> & pool,
+        size_t                               batch_size,
+        unsigned                             conv_win,
+        unsigned                             max_div_cnt,
+        unsigned                             max_tlc,
+        uint64_t                             version)
+    :
+        m_py_job(py_job),
+        m_py_lvq(py_lvq),
+        m_py_set(py_set),
+        m_file(std::move(file)),
+        m_trainer(std::move(trainer)),
+        m_pool(pool),
+        m_batch_size(batch_size),
+        m_conv_win(conv_win),
+        m_max_div_cnt(max_div_cnt),
+        m_max_tlc(max_tlc),
+        m_version(version),
+        m_keep(false),
+        m_done(false),
+        m_cancelled(false),
+        m_stored(false)
+    {
+        Py_INCREF(m_py_lvq);
+        Py_XINCREF(m_py_set);
+    }
+
+    /** Start training thread */
+    void start() { m_thread = std::thread(&train_job::run, this); }
+
+    /** Progress monitor */
+    train_monitor & monitor() { return m_monitor; }
+
+    /**
+     *  \brief  Request cancellation
+     *
+     *  \param  keep  Store prototypes trained so far (the last request
+     *                decides if cancelled more than once)
+     */
+    void cancel(bool keep) {
+        m_keep = keep;
+        m_monitor.cancel();
+    }
+
+    /** Job finished */
+    bool done() const {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_done;
+    }
+
+    /**
+     *  \brief  Wait for the job (with the GIL released)
+     *
+     *  \param  timeout  Timeout [s] (negative means no timeout)
+     *
+     *  \return \c true iff the job finished
+     */
+    bool wait(double timeout) {
+        gil_release nogil;
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        if (timeout < 0.0)
+            m_done_cond.wait(lock, [this]() { return m_done; });
+        else
+            m_done_cond.wait_for(lock,
+                std::chrono::duration<double>(timeout),
+                [this]() { return m_done; });
+
+        return m_done;
+    }
+
+    /**
+     *  \brief  Add waiting future (with the GIL held)
+     *
+     *  \param  py_loop    Event loop
+     *  \param  py_future  Future
+     *
+     *  \return \c false if the job already finished (the future isn't added)
+     */
+    bool add_waiter(PyObject * py_loop, PyObject * py_future) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_done) return false;
+
+        Py_INCREF(py_loop);
+        Py_INCREF(py_future);
+        Py_INCREF(m_py_job);
+        m_waiters.emplace_back(py_loop, py_future);
+
+        return true;
+    }
+
+    /**
+     *  \brief  Job result (the job must be finished)
+     *
+     *  \return New dictionary of \c loops (loops done), \c dnorm2
+     *          (last loop average squared norm of prototype shifts),
+     *          \c cancelled and \c stored (prototypes stored) items
+     */
+    PyObject * result() const {
+        if (!m_error.empty()) throw std::runtime_error(m_error);
+
+        const train_progress & last = m_monitor.last();
+
+        return Py_BuildValue("{s:I,s:d,s:O,s:O}",
+            "loops",     last.tlc,
+            "dnorm2",    last.dnorm2,
+            "cancelled", m_cancelled ? Py_True : Py_False,
+            "stored",    m_stored    ? Py_True : Py_False);
+    }
+
+    /** Destructor (cancels the training and joins the thread) */
+    ~train_job() {
+        if (m_thread.joinable()) {
+            m_monitor.cancel();
+
+            if (std::this_thread::get_id() == m_thread.get_id())
+                m_thread.detach();  // released by the last future
+            else {
+                gil_release nogil;
+                m_thread.join();
+            }
+        }
+
+        Py_XDECREF(m_py_set);
+        Py_DECREF(m_py_lvq);
+    }
+
+};  // end of class train_job
+
+
+/** Training job Python object */
+typedef struct {
+    PyObject_HEAD
+    train_job * job;
+} trainJobObject_t;
+
+/** Training job object access */
+#define python2train_job(self) \
+    ((reinterpret_cast<trainJobObject_t *>(self))->job)
+
+
+/**
+ *  \brief  Asynchronous training binding
+ *
+ *  Starts mini-batch training (see \ref minibatch_trainer; unlike
+ *  \c train_*, \c batch_size=1 also runs the mini-batch trainer, i.e.
+ *  per-sample updates with the trainer's learning factor schedule)
+ *  on a native thread and returns training job object.
+ *  The trained prototypes aren't stored if the model is modified
+ *  meanwhile (the job fails).
+ *  \c set is a classifier training set if \c supervised, clustering
+ *  training set otherwise; it may also be a binary training set file path
+ *  or \c TrainingSet.
+ *  See the training job object for progress polling, cancellation
+ *  and completion (asyncio) futures.
+ */
+static PyObject * liblvq__lvq__train_async(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = {
+        "set", "conv_win", "max_div_cnt", "max_tlc",
+        "supervised", "batch_size", "threads", NULL };
+
+    PyObject * py_set;
+    unsigned   conv_win    = LIBLVQ__ML__LVQ__TRAIN__CONV_WIN;
+    unsigned   max_div_cnt = LIBLVQ__ML__LVQ__TRAIN__MAX_DIV_CNT;
+    unsigned   max_tlc     = LIBLVQ__ML__LVQ__TRAIN__MAX_TLC;
+    int        superv      = 1;
+    size_t     batch_size  = 1024;
+    size_t     threads     = 0;
+    parse_args_kw(args, kwds, "O|IIIpnn", kwlist,
+        &py_set, &conv_win, &max_div_cnt, &max_tlc,
+        &superv, &batch_size, &threads);
+
+    std::unique_ptr<tset_file>         file;
+    std::unique_ptr<minibatch_trainer> trainer;
+    uint64_t                           version;  // of the trained prototypes
+
+    const tset_matrix * native = python2tset_matrix(self, py_set, superv, file);
+
+    if (NULL != native) {
+        lvq_reader access(self);
+        trainer.reset(new minibatch_trainer(*python2lvq(self), *native, superv));
+        version = python2lvq_snapshots(self).version();
+    }
+    else if (superv) {
+        const tset_classifier_t set = python2tset_classifier(py_set);
+        check_undef(self, set);
+
+        lvq_reader access(self);
+        trainer.reset(new minibatch_trainer(*python2lvq(self), set));
+        version = python2lvq_snapshots(self).version();
+    }
+    else {
+        const tset_clustering_t set = python2tset_clustering(py_set);
+        check_undef(self, set);
+
+        lvq_reader access(self);
+        trainer.reset(new minibatch_trainer(*python2lvq(self), set));
+        version = python2lvq_snapshots(self).version();
+    }
+
+    std::shared_ptr<thread_pool> pool = 0 < threads
+        ? std::make_shared<thread_pool>(threads)
+        : get_pool();
+
+    // Create job
+    PyTypeObject * job_type = get_trainJobType();
+
+    py_ref py_job(job_type->tp_alloc(job_type, 0));
+    if (NULL == py_job.get()) return NULL;
+
+    // The job keeps the training set (its samples are used in place)
+    PyObject * py_tset = NULL != native && !file ? py_set : NULL;
+
+    train_job * job = new train_job(py_job.get(), self, py_tset,
+        std::move(file), std::move(trainer), pool,
+        batch_size, conv_win, max_div_cnt, max_tlc, version);
+
+    python2train_job(py_job.get()) = job;
+
+    job->start();
+
+    return py_job.release();
+}
+
+BINDING_INST_KW(liblvq__lvq__train_async)
+
+
+/**
+ *  \brief  Streaming online training
+ *
+ *  Samples are pulled from the iterable in chunks of \c chunk_size,
+ *  converted to a reusable native buffer and applied as online training
+ *  steps (see \c train1_*) with the GIL released.
+ *  The model is unlocked between chunks; snapshots are published
+ *  at bounded rate (see \ref snapshot_cell) and at the end.
+ *  Learning factor of step \c t is \c lfactor/(1+decay*t)
+ *  (see \ref lfactor_schedule).
+ *
+ *  \param  self         Python LVQ object
+ *  \param  py_iterable  Python iterable of samples
+ *  \param  superv       Supervised training
+ *  \param  chunk_size   Chunk size
+ *  \param  lfactor      Initial learning factor
+ *  \param  decay        Learning factor decay
+ *
+ *  \return Number of samples trained
+ */
+static size_t train_stream(
+    PyObject * self,
+    PyObject * py_iterable,
+    bool       superv,
+    size_t     chunk_size,
+    double     lfactor,
+    double     decay)
+{
+    py_ref iter(PyObject_GetIter(py_iterable));
+    if (NULL == iter.get())
+        throw std::logic_error("Invalid training set (should be iterable)");
+
+    const size_t dim  = model_dimension(self);
+    const size_t ccnt = model_clusters(self);
+
+    const lfactor_schedule schedule(lfactor_schedule::INVERSE, lfactor, decay);
+
+    tset_chunk chunk(dim, chunk_size);
+    size_t t = 0;
+
+    while (chunk.pull(iter.get(), superv)) {
+        for (size_t i = 0; i < chunk.size(); ++i) {
+            check_undef(self, chunk.row(i), dim);
+
+            if (superv && ccnt <= chunk.cluster(i))
+                throw std::logic_error("Invalid cluster");
+        }
+
+        lvq_writer access(self);
+
+        lvq_t &          lvq   = *python2lvq(self);
+        dense_codebook * dense = python2lvq_dense(self);
+        lvq_t::input_t   input(dim);
+
+        for (size_t i = 0; i < chunk.size(); ++i, ++t) {
+            // Dense model: BMU search on the dense prototypes
+            if (NULL != dense) {
+                train1_dense(lvq, *dense, chunk.row(i),
+                    superv ? chunk.cluster(i) : SIZE_MAX, schedule(t));
+
+                continue;
+            }
+
+            dense2input(chunk.row(i), input);
+
+            const lvq_t::base_t lf(schedule(t));
+
+            if (superv)
+                lvq.train1_supervised(input, chunk.cluster(i), lf);
+            else
+                lvq.train1_unsupervised(input, lf);
+        }
+    }  // chunks are published by the writer (coalesced)
+
+    lvq_reader access(self);
+    snapshot_publish(self);  // trained
+
+    return t;
+}
+
+
+/**
+ *  \brief  Streaming supervised training binding
+ *
+ *  See \ref train_stream.
+ */
+static PyObject * liblvq__lvq__train_supervised_stream(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = {
+        "iterable", "chunk_size", "lfactor", "decay", NULL };
+
+    PyObject * py_iterable;
+    size_t     chunk_size = 4096;
+    double     lfactor    = 0.1;
+    double     decay      = 0.0;
+    parse_args_kw(args, kwds, "O|ndd", kwlist,
+        &py_iterable, &chunk_size, &lfactor, &decay);
+
+    // Call implementation
+    const size_t cnt = train_stream(
+        self, py_iterable, true, chunk_size, lfactor, decay);
+
+    // Transform result
+    return Py_BuildValue("n", cnt);
+}
+
+BINDING_INST_KW(liblvq__lvq__train_supervised_stream)
+
+
+/**
+ *  \brief  Streaming unsupervised training binding
+ *
+ *  See \ref train_stream.
+ */
+static PyObject * liblvq__lvq__train_unsupervised_stream(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = {
+        "iterable", "chunk_size", "lfactor", "decay", NULL };
+
+    PyObject * py_iterable;
+    size_t     chunk_size = 4096;
+    double     lfactor    = 0.1;
+    double     decay      = 0.0;
+    parse_args_kw(args, kwds, "O|ndd", kwlist,
+        &py_iterable, &chunk_size, &lfactor, &decay);
+
+    // Call implementation
+    const size_t cnt = train_stream(
+        self, py_iterable, false, chunk_size, lfactor, decay);
+
+    // Transform result
+    return Py_BuildValue("n", cnt);
+}
+
+BINDING_INST_KW(liblvq__lvq__train_unsupervised_stream)
+
+
+/**
+ *  \brief  Build approximate nearest prototype index
+ *
+ *  Only \c kind="ivf" (inverted lists over k-means centroids of
+ *  the prototypes) is supported; see \ref dense_codebook::build_index.
+ *  \c classify, \c classify_batch, \c classify_async, \c classify_best
+ *  and \c classify_best_batch use the index (the latter rank the probed
+ *  prototypes, see \ref indexed_best); training, testing and the other
+ *  classification weights (\c classify_weight, ...) stay exact.
+ *  Requires dense prototypes (model created with \c dtype).
+ */
+static PyObject * liblvq__lvq__build_index(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = { "kind", "nlist", "nprobe", "iters", NULL };
+
+    const char * kind   = "ivf";
+    size_t       nlist  = 0;
+    size_t       nprobe = 0;
+    unsigned     iters  = 10;
+    parse_args_kw(args, kwds, "|snnI", kwlist, &kind, &nlist, &nprobe, &iters);
+
+    if (0 != ::strcmp(kind, "ivf"))
+        throw std::logic_error("Invalid index kind (\"ivf\" expected)");
+
+    dense_codebook * dense = python2lvq_dense(self);
+    if (NULL == dense)
+        throw std::logic_error(
+            "Index requires dense prototypes (create the model with dtype)");
+
+    // Call implementation
+    {
+        lvq_writer access(self, true);
+        dense->build_index(nlist, nprobe, iters, *get_pool());
+    }
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+BINDING_INST_KW(liblvq__lvq__build_index)
+
+
+/**
+ *  \brief  Drop nearest prototype index
+ */
+static PyObject * liblvq__lvq__drop_index(PyObject * self, PyObject * args) {
+    parse_args(args, "");
+
+    dense_codebook * dense = python2lvq_dense(self);
+
+    // Call implementation
+    if (NULL != dense) {
+        lvq_writer access(self, true);
+        dense->drop_index();
+    }
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+BINDING_INST(liblvq__lvq__drop_index)
+
+
+/**
+ *  \brief  Set index lists probed by queries
+ *
+ *  More lists means better recall for higher latency.
+ */
+static PyObject * liblvq__lvq__set_index_nprobe(PyObject * self, PyObject * args) {
+    size_t nprobe;
+    parse_args(args, "n", &nprobe);
+
+    dense_codebook * dense = python2lvq_dense(self);
+    if (NULL == dense)
+        throw std::logic_error("No index built");
+
+    // Call implementation
+    {
+        lvq_writer access(self, true);
+        dense->set_index_nprobe(nprobe);
+    }
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+BINDING_INST(liblvq__lvq__set_index_nprobe)
+
+
+/**
+ *  \brief  Index parameters
+ *
+ *  \return \c dict of \c kind, \c nlist and \c nprobe
+ *          (or \c None if not indexed)
+ */
+static PyObject * liblvq__lvq__index_info(PyObject * self, PyObject * args) {
+    parse_args(args, "");
+
+    const dense_codebook * dense = python2lvq_dense(self);
+
+    size_t nlist  = 0;
+    size_t nprobe = 0;
+
+    if (NULL != dense) {
+        lvq_reader access(self);
+
+        nlist  = dense->index_nlist();
+        nprobe = dense->index_nprobe();
+    }
+
+    if (0 == nlist) {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+
+    return Py_BuildValue("{s:s,s:n,s:n}",
+        "kind", "ivf", "nlist", nlist, "nprobe", nprobe);
+}
+
+BINDING_INST(liblvq__lvq__index_info)
+
+
+/**
+ *  \brief  Set exact nearest prototype search pruning
+ *
+ *  See \ref dense_codebook::set_pruning; \c pivots=0 disables pruning.
+ *  Requires dense prototypes (model created with \c dtype).
+ */
+static PyObject * liblvq__lvq__set_pruning(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = { "pivots", NULL };
+
+    size_t pivots = 16;
+    parse_args_kw(args, kwds, "|n", kwlist, &pivots);
+
+    dense_codebook * dense = python2lvq_dense(self);
+    if (NULL == dense)
+        throw std::logic_error(
+            "Pruning requires dense prototypes (create the model with dtype)");
+
+    // Call implementation
+    {
+        lvq_writer access(self, true);
+        dense->set_pruning(pivots, *get_pool());
+    }
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+BINDING_INST_KW(liblvq__lvq__set_pruning)
+
+
+/**
+ *  \brief  Nearest prototype search counters
+ *
+ *  \return \c dict of \c pivots, \c evaluated and \c pruned
+ *          (distance evaluations) counts
+ */
+static PyObject * liblvq__lvq__pruning_stats(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = { "reset", NULL };
+
+    int reset = 0;
+    parse_args_kw(args, kwds, "|p", kwlist, &reset);
+
+    const dense_codebook * dense = python2lvq_dense(self);
+    if (NULL == dense)
+        throw std::logic_error(
+            "Pruning requires dense prototypes (create the model with dtype)");
+
+    // Call implementation
+    size_t   pivots;
+    uint64_t evals;
+    uint64_t pruned;
+    {
+        lvq_reader access(self);
+
+        pivots = dense->pruning_pivots();
+        dense->pruning_stats(evals, pruned, reset);
+    }
+
+    return Py_BuildValue("{s:n,s:K,s:K}",
+        "pivots", pivots,
+        "evaluated", (unsigned long long)evals,
+        "pruned", (unsigned long long)pruned);
+}
+
+BINDING_INST_KW(liblvq__lvq__pruning_stats)
+
+
+/**
+ *  \brief  Classify Python input on snapshot
+ *
+ *  The input is converted with the GIL held, then the GIL is released
+ *  (and the latest model is acquired if no snapshot is given).
+ *
+ *  \param  self      Python LVQ object
+ *  \param  snapshot  Model snapshot (or \c NULL, see \ref snapshot_acquire)
+ *  \param  py_input  Python input
+ *
+ *  \return Cluster
+ */
+static size_t snapshot_classify(
+    PyObject *           self,
+    const lvq_snapshot * snapshot,
+    PyObject *           py_input)
+{
+    const dense_codebook * dense = NULL != snapshot
+        ? snapshot->dense() : python2lvq_dense(self);
+
+    if (NULL != dense) {
+        std::vector<double> x;
+        python2dense(py_input, x);
+        check_dimension(self, *dense, x);
+
+        gil_release nogil;
+        const lvq_snapshot_ptr latest = NULL == snapshot
+            ? snapshot_acquire(self) : lvq_snapshot_ptr();
+
+        return (NULL != snapshot ? *snapshot : *latest).dense()->classify(x.data());
+    }
+
+    const lvq_t::input_t input = python2input(py_input);
+
+    gil_release nogil;
+    const lvq_snapshot_ptr latest = NULL == snapshot
+        ? snapshot_acquire(self) : lvq_snapshot_ptr();
+
+    return (NULL != snapshot ? *snapshot : *latest).lvq().classify(input);
+}
+
+
+/**
+ *  \brief  \c ml::lvq::classify binding
+ */
+static PyObject * liblvq__lvq__classify(PyObject * self, PyObject * args) {
+    // Get arguments
+    PyObject * py_input;
+    parse_args(args, "O", &py_input);
+
+    // Call implementation (on the latest model)
+    const size_t cluster = snapshot_classify(self, NULL, py_input);
+
+    // Transform result
+    return Py_BuildValue("n", cluster);
+}
+
+BINDING_INST(liblvq__lvq__classify)
+
+
+/**
+ *  \brief  Classify matrix rows on snapshot
+ *
+ *  See \ref liblvq__lvq__classify_batch.
+ *
+ *  \param  self       Python LVQ object
+ *  \param  snapshot   Model snapshot (or \c NULL, see \ref snapshot_acquire)
+ *  \param  py_matrix  Input matrix
+ *  \param  py_out     Output buffer (or \c None)
+ *
+ *  \return Clusters
+ */
+static PyObject * snapshot_classify_batch(
+    PyObject *           self,
+    const lvq_snapshot * snapshot,
+    PyObject *           py_matrix,
+    PyObject *           py_out)
+{
+    buffer_view matrix(py_matrix);
+
+    const size_t rows = matrix.rows();
+
+    py_ref py_result(Py_None == py_out
+        ? new_array("q", rows, sizeof(int64_t))
+        : (Py_INCREF(py_out), py_out));
+
+    buffer_view out(py_result.get(), true);
+
+    if (buffer_view::INT64 != out.dtype() || 1 != out.ndim())
+        throw std::logic_error("Invalid output (1-D int64 buffer expected)");
+
+    if (rows != out.rows())
+        throw std::logic_error("Invalid output (size mismatch)");
+
+    {
+        gil_release nogil;
+
+        const lvq_snapshot_ptr latest = NULL == snapshot
+            ? snapshot_acquire(self) : lvq_snapshot_ptr();
+
+        const lvq_snapshot & model = NULL != snapshot ? *snapshot : *latest;
+
+        check_input_matrix(matrix, model.dimension());
+
+        const dense_codebook * dense = model.dense();
+        int64_t * clusters = out.data<int64_t>();
+
+        std::shared_ptr<thread_pool> pool = get_pool();
+        pool->parallel_for(rows, pool->chunk(rows),
+        [&](size_t begin, size_t end) {
+            // Dense prototypes
+            if (NULL != dense) {
+                const size_t cols = matrix.cols();
+
+                for (size_t i = begin; i < end; ++i) {
+                    if (buffer_view::FLOAT64 == matrix.dtype()) {
+                        const double * x = matrix.row<const double>(i);
+                        check_undef(self, x, cols);
+                        clusters[i] = dense->classify(x);
+                    }
+                    else {
+                        const float * x = matrix.row<const float>(i);
+                        check_undef(self, x, cols);
+                        clusters[i] = dense->classify(x);
+                    }
+                }
+
+                return;
+            }
+
+            const lvq_t &  lvq = model.lvq();
+            lvq_t::input_t input(matrix.cols());
+
+            for (size_t i = begin; i < end; ++i) {
+                row2input(matrix, i, input);
+                clusters[i] = lvq.classify(input);
+            }
+        });
+    }
+
+    return py_result.release();
+}
+
+
+/**
+ *  \brief  Batch \c ml::lvq::classify binding
+ *
+ *  Classifies rows of a 2-D C-contiguous float64/float32 buffer.
+ *  Cluster indices are written to the \c out buffer (1-D, 64-bit integers)
+ *  if provided; otherwise, new \c array('q') is returned.
+ */
+static PyObject * liblvq__lvq__classify_batch(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = { "matrix", "out", NULL };
+
+    PyObject * py_matrix;
+    PyObject * py_out = Py_None;
+    parse_args_kw(args, kwds, "O|O", kwlist, &py_matrix, &py_out);
+
+    // Call implementation (on the latest model)
+    return snapshot_classify_batch(self, NULL, py_matrix, py_out);
+}
+
+BINDING_INST_KW(liblvq__lvq__classify_batch)
+
+
+//
+// Asynchronous classification
+//
+
+/**
+ *  \brief  Resolve asyncio futures (event loop callback)
+ *
+ *  \param  self     Unused
+ *  \param  py_list  List of (future, cluster, error) tuples;
+ *                   the future exception is set if \c error isn't \c None
+ *
+ *  \return \c None
+ */
+static PyObject * resolve_futures(PyObject * self, PyObject * py_list) {
+    const Py_ssize_t size = PyList_GET_SIZE(py_list);
+
+    for (Py_ssize_t i = 0; i < size; ++i) {
+        PyObject * py_future;
+        PyObject * py_cluster;
+        PyObject * py_error;
+        if (!PyArg_ParseTuple(PyList_GET_ITEM(py_list, i), "OOO",
+            &py_future, &py_cluster, &py_error)) return NULL;
+
+        // Cancelled futures are done
+        py_ref py_done(PyObject_CallMethod(py_future, "done", NULL));
+        if (NULL == py_done.get()) return NULL;
+        if (PyObject_IsTrue(py_done.get())) continue;
+
+        py_ref py_res(Py_None == py_error
+            ? PyObject_CallMethod(py_future, "set_result", "O", py_cluster)
+            : PyObject_CallMethod(py_future, "set_exception", "O", py_error));
+
+        if (NULL == py_res.get()) return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+/** \c resolve_futures method definition */
+static PyMethodDef resolve_futures_def = {
+    "_resolve_futures", resolve_futures, METH_O, "Resolve futures (internal)"
+};
+
+
+/**
+ *  \brief  Asynchronous classification micro-batcher
+ *
+ *  Classification requests (each with asyncio future) are queued
+ *  and processed by a native thread: requests arriving within
+ *  \c max_delay since the oldest one are coalesced (up to \c max_batch)
+ *  and classified in one pass (on the module pool) with the GIL released.
+ *  The GIL is then acquired once per batch and the futures are resolved
+ *  by a single callback per event loop.
+ *  The batcher thread doesn't exist in forked child processes; batchers
+ *  inherited from the parent are abandoned (see \ref get_batcher).
+ */
+class classify_batcher {
+    private:
+
+    /** Classification request */
+    struct request {
+        std::vector<double>                   x;        /**< Input     */
+        PyObject *                            py_loop;  /**< Loop      */
+        PyObject *                            py_future;/**< Future    */
+        std::chrono::steady_clock::time_point time;     /**< Submitted */
+        size_t                                cluster;  /**< Result    */
+        std::exception_ptr                    error;    /**< Failure   */
+    };  // end of struct request
+
+    PyObject *                  m_py_lvq;      /**< Python LVQ (owner)    */
+    py_ref                      m_py_resolve;  /**< Futures resolver      */
+    size_t                      m_max_batch;   /**< Max. batch size       */
+    double                      m_max_delay;   /**< Max. delay [s]        */
+    std::deque<request *>       m_queue;       /**< Request queue         */
+    std::mutex                  m_mutex;       /**< Queue mutex           */
+    std::condition_variable     m_cond;        /**< Queue change          */
+    bool                        m_stop;        /**< Stop (drain) request  */
+    std::thread                 m_thread;      /**< Batcher thread        */
+    const pid_t                 m_pid;         /**< Creating process      */
+
+    /** Classify batch (without the GIL, on the latest snapshot) */
+    void classify(std::vector<request *> & batch) {
+        const lvq_snapshot_ptr snapshot = snapshot_acquire(m_py_lvq);
+
+        const dense_codebook * dense = snapshot->dense();
+        const size_t           dim   = snapshot->dimension();
+
+        std::shared_ptr<thread_pool> pool = get_pool();
+        pool->parallel_for(batch.size(), pool->chunk(batch.size(), 16),
+        [&](size_t begin, size_t end) {
+            lvq_t::input_t input(dim);
+
+            for (size_t i = begin; i < end; ++i) {
+                request & req = *batch[i];
+
+                try {
+                    if (dim != req.x.size())
+                        throw std::logic_error(
+                            "Invalid input (dimension mismatch)");
+
+                    check_undef(m_py_lvq, req.x.data(), dim);
+
+                    if (NULL != dense)
+                        req.cluster = dense->classify(req.x.data());
+                    else {
+                        dense2input(req.x.data(), input);
+                        req.cluster = snapshot->lvq().classify(input);
+                    }
+                }
+                catch (...) {
+                    req.error = std::current_exception();
+                }
+            }
+        });
+    }
+
+    /** Resolve batch futures (with the GIL held), release the requests */
+    void resolve(std::vector<request *> & batch) {
+        // Group requests by event loop
+        std::vector<std::pair<PyObject *, py_ref *> > loops;
+
+        for (request * req: batch) {
+            auto lpos = std::find_if(loops.begin(), loops.end(),
+            [req](const std::pair<PyObject *, py_ref *> & l) {
+                return l.first == req->py_loop;
+            });
+
+            if (loops.end() == lpos) {
+                loops.emplace_back(req->py_loop, new py_ref(PyList_New(0)));
+                lpos = loops.end() - 1;
+            }
+
+            py_ref py_item(!req->error
+                ? Py_BuildValue("(Ons)", req->py_future, req->cluster, NULL)
+                : Py_BuildValue("(OOO)", req->py_future, Py_None,
+                    py_ref(exception2python(req->error)).get()));
+
+            if (NULL == lpos->second->get() || NULL == py_item.get() ||
+                0 != PyList_Append(lpos->second->get(), py_item.get()))
+            {
+                PyErr_Clear();
+            }
+        }
+
+        for (auto & l: loops) {
+            if (NULL != l.second->get()) {
+                py_ref py_res(PyObject_CallMethod(l.first,
+                    "call_soon_threadsafe", "OO",
+                    m_py_resolve.get(), l.second->get()));
+
+                if (NULL == py_res.get()) PyErr_Clear();  // loop closed
+            }
+
+            delete l.second;
+        }
+
+        for (request * req: batch) {
+            Py_DECREF(req->py_loop);
+            Py_DECREF(req->py_future);
+            delete req;
+        }
+
+        batch.clear();
+    }
+
+    /** Batcher thread routine */
+    void run() {
+        std::vector<request *> batch;
+
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+
+                m_cond.wait(lock, [this]() {
+                    return m_stop || !m_queue.empty();
+                });
+
+                if (m_queue.empty()) return;  // stopped and drained
+
+                // Coalesce requests
+                const auto deadline = m_queue.front()->time +
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double>(m_max_delay));
+
+                m_cond.wait_until(lock, deadline, [this]() {
+                    return m_stop || m_queue.size() >= m_max_batch;
+                });
+
+                const size_t bsize = std::min(m_max_batch, m_queue.size());
+                batch.assign(m_queue.begin(), m_queue.begin() + bsize);
+                m_queue.erase(m_queue.begin(), m_queue.begin() + bsize);
+            }
+
+            try {
+                classify(batch);
+            }
+            catch (...) {
+                for (request * req: batch) req->error = std::current_exception();
+            }
+
+            PyGILState_STATE gil = PyGILState_Ensure();
+            resolve(batch);
+            PyGILState_Release(gil);
+        }
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor (with the GIL held)
+     *
+     *  \param  py_lvq     Python LVQ object (the batcher owner)
+     *  \param  max_batch  Max. batch size
+     *  \param  max_delay  Max. delay of the oldest request [s]
+     */
+    classify_batcher(
+        PyObject * py_lvq,
+        size_t     max_batch = 256,
+        double     max_delay = 0.0005)
+    :
+        m_py_lvq(py_lvq),
+        m_py_resolve(PyCFunction_New(&resolve_futures_def, NULL)),
+        m_max_batch(max_batch),
+        m_max_delay(max_delay),
+        m_stop(false),
+        m_pid(::getpid())
+    {
+        if (NULL == m_py_resolve.get())
+            throw std::runtime_error("Failed to create futures resolver");
+
+        m_thread = std::thread(&classify_batcher::run, this);
+    }
+
+    /** Created by another (parent) process */
+    bool forked() const { return m_pid != ::getpid(); }
+
+    /**
+     *  \brief  Inherited batcher replacement (in forked child)
+     *
+     *  The batching parameters are kept; the inherited queue (and its
+     *  mutex, possibly locked at fork) isn't touched.
+     *
+     *  \return New batcher
+     */
+    classify_batcher * respawn() const {
+        return new classify_batcher(m_py_lvq, m_max_batch, m_max_delay);
+    }
+
+    /**
+     *  \brief  Set batching parameters
+     *
+     *  \param  max_batch  Max. batch size
+     *  \param  max_delay  Max. delay of the oldest request [s]
+     */
+    void configure(size_t max_batch, double max_delay) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_max_batch = std::max<size_t>(max_batch, 1);
+        m_max_delay = std::max(max_delay, 0.0);
+    }
+
+    /**
+     *  \brief  Submit request (with the GIL held)
+     *
+     *  \param  x          Input
+     *  \param  py_loop    Event loop
+     *  \param  py_future  Future (resolved by cluster index)
+     */
+    void submit(std::vector<double> && x, PyObject * py_loop, PyObject * py_future) {
+        request * req = new request;
+        req->x         = std::move(x);
+        req->py_loop   = py_loop;
+        req->py_future = py_future;
+        req->time      = std::chrono::steady_clock::now();
+        req->cluster   = 0;
+
+        Py_INCREF(py_loop);
+        Py_INCREF(py_future);
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queue.push_back(req);
+        }
+        m_cond.notify_one();
+    }
+
+    /** Destructor (with the GIL held, pending requests are processed) */
+    ~classify_batcher() {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cond.notify_one();
+
+        gil_release nogil;
+        m_thread.join();
+    }
+
+};  // end of class classify_batcher
+
+
+/**
+ *  \brief  Delete asynchronous classification batcher
+ *
+ *  Batchers inherited from the parent process are leaked
+ *  (their thread can't be joined).
+ *
+ *  \param  batcher  Batcher (see \ref classify_batcher)
+ */
+static void delete_batcher(classify_batcher * batcher) {
+    if (!batcher->forked()) delete batcher;
+}
+
+
+/**
+ *  \brief  Asynchronous classification batcher of LVQ object
+ *
+ *  Created on demand (with the GIL held); re-created in forked child
+ *  processes (like the module thread pool, see \ref pool_check_fork).
+ *
+ *  \param  self  Python LVQ object
+ *
+ *  \return Batcher
+ */
+static classify_batcher * get_batcher(PyObject * self) {
+    lvqObject_t * py_lvq = reinterpret_cast<lvqObject_t *>(self);
+
+    if (NULL == py_lvq->batcher)
+        py_lvq->batcher = new classify_batcher(self);
+    else if (py_lvq->batcher->forked())
+        py_lvq->batcher = py_lvq->batcher->respawn();  // inherited is leaked
+
+    return py_lvq->batcher;
+}
+
+
+/**
+ *  \brief  Asynchronous \c ml::lvq::classify binding
+ *
+ *  Returns asyncio future (of the running event loop) of the input
+ *  cluster index; concurrent requests are classified in micro-batches
+ *  (see \c set_async_batching).
+ */
+static PyObject * liblvq__lvq__classify_async(PyObject * self, PyObject * args) {
+    // Get arguments
+    PyObject * py_input;
+    parse_args(args, "O", &py_input);
+
+    std::vector<double> x;
+    python2dense(py_input, x);
+
+    static PyObject * py_get_running_loop = NULL;  // cached
+    if (NULL == py_get_running_loop) {
+        py_ref py_asyncio(PyImport_ImportModule("asyncio"));
+        if (NULL == py_asyncio.get()) return NULL;
+
+        py_get_running_loop = PyObject_GetAttrString(
+            py_asyncio.get(), "get_running_loop");
+
+        if (NULL == py_get_running_loop) return NULL;
+    }
+
+    py_ref py_loop(PyObject_CallObject(py_get_running_loop, NULL));
+    if (NULL == py_loop.get()) return NULL;  // no running loop
+
+    py_ref py_future(PyObject_CallMethod(py_loop.get(), "create_future", NULL));
+    if (NULL == py_future.get()) return NULL;
+
+    // Call implementation
+    get_batcher(self)->submit(std::move(x), py_loop.get(), py_future.get());
+
+    return py_future.release();
+}
+
+BINDING_INST(liblvq__lvq__classify_async)
+
+
+/**
+ *  \brief  Set asynchronous classification batching parameters
+ *
+ *  Requests arriving within \c max_delay seconds since the oldest
+ *  pending one are classified together (up to \c max_batch requests).
+ */
+static PyObject * liblvq__lvq__set_async_batching(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = { "max_batch", "max_delay", NULL };
+
+    size_t max_batch = 256;
+    double max_delay = 0.0005;
+    parse_args_kw(args, kwds, "|nd", kwlist, &max_batch, &max_delay);
+
+    if (0 == max_batch || max_delay < 0.0)
+        throw std::logic_error("Invalid batching parameters");
+
+    // Call implementation
+    get_batcher(self)->configure(max_batch, max_delay);
+
+    Py_RETURN_NONE;
+}
+
+BINDING_INST_KW(liblvq__lvq__set_async_batching)
+
+
+/**
+ *  \brief  Classification weights of squared distances
+ *
+ *  The weighting is left to \c ml::lvq: the weights are those
+ *  of a 1-D proxy model (per thread) with prototype \c c placed
+ *  at distance \c sqrt(d2[c]) from the origin, classifying the origin.
+ *  So dense models compute the distances by the SIMD kernels
+ *  (see \ref dense_codebook::dist2) and weight them just like
+ *  \c ml::lvq::classify_weight (up to distance rounding).
+ *
+ *  \param  d2  Squared distances (of the clusters count)
+ *
+ *  \return Classification weights
+ */
+static std::vector<double> dist2weight(const std::vector<double> & d2) {
+    static thread_local std::unique_ptr<lvq_t> proxy;
+
+    const size_t ccnt = d2.size();
+    if (!proxy || ccnt != proxy->clusters()) proxy.reset(new lvq_t(1, ccnt));
+
+    lvq_t::input_t x(1);
+    for (size_t c = 0; c < ccnt; ++c) {
+        x[0] = lvq_t::base_t(std::sqrt(d2[c]));
+        proxy->set(x, c);
+    }
+
+    x[0] = lvq_t::base_t(0.0);
+    return proxy->classify_weight(x);
+}
+
+
+/**
+ *  \brief  Classification weights on model snapshot
+ *
+ *  Dense prototypes are used if available (see \ref dist2weight).
+ *
+ *  \param  model  Model snapshot
+ *  \param  input  Input
+ *
+ *  \return Classification weights
+ */
+static std::vector<double> snapshot_weight(
+    const lvq_snapshot &   model,
+    const lvq_t::input_t & input)
+{
+    const dense_codebook * dense = model.dense();
+    if (NULL == dense) return model.lvq().classify_weight(input);
+
+    if (dense->dimension() != input.rank())
+        throw std::logic_error("Invalid input (dimension mismatch)");
+
+    std::vector<double> x(input.rank());
+    input2dense(input, x.data());
+
+    std::vector<double> d2(dense->clusters());
+    dense->dist2(x.data(), d2.data());
+
+    return dist2weight(d2);
+}
+
+
+/**
+ *  \brief  \c ml::lvq::classify_weight binding
+ */
+static PyObject * liblvq__lvq__classify_weight(
+    PyObject * self,
+    PyObject * args)
+{
+    // Get arguments
+    PyObject * py_input;
+    parse_args(args, "O", &py_input);
+
+    const lvq_t::input_t input = python2input(py_input);
+    check_undef(self, input);
+
+    // Call implementation (on the latest model)
+    std::vector<double> weight;
+    {
+        gil_release nogil;
+        weight = snapshot_weight(*snapshot_acquire(self), input);
+    }
+
+    // Transform result
+    return weight2python(weight);
+}
+
+BINDING_INST(liblvq__lvq__classify_weight)
+
+
+/**
+ *  \brief  Classification weights of matrix row
+ *
+ *  Dense prototypes are used if available (see \ref dist2weight).
+ *
+ *  \param  self    Python LVQ object
+ *  \param  model   Model snapshot
+ *  \param  matrix  Input matrix
+ *  \param  i       Row index
+ *  \param  input   Input (scratch, of the matrix column count)
+ *  \param  weight  Weights (output, of the clusters count)
+ */
+static void row_weight(
+    PyObject *            self,
+    const lvq_snapshot &  model,
+    const buffer_view &   matrix,
+    size_t                i,
+    lvq_t::input_t &      input,
+    std::vector<double> & weight)
+{
+    const dense_codebook * dense = model.dense();
+
+    if (NULL == dense) {
+        row2input(matrix, i, input);
+        check_undef(self, input);
+
+        weight = model.lvq().classify_weight(input);
+        return;
+    }
+
+    const size_t cols = matrix.cols();
+    weight.resize(dense->clusters());
+
+    if (buffer_view::FLOAT64 == matrix.dtype()) {
+        const double * x = matrix.row<const double>(i);
+        check_undef(self, x, cols);
+        dense->dist2(x, weight.data());
+    }
+    else {
+        const float * x = matrix.row<const float>(i);
+        check_undef(self, x, cols);
+        dense->dist2(x, weight.data());
+    }
+
+    weight = dist2weight(weight);
+}
+
+
+/**
+ *  \brief  Batch \c ml::lvq::classify_weight binding
+ *
+ *  Computes classification weights of rows of a 2-D C-contiguous
+ *  float64/float32 buffer.
+ *  The weights are written to the \c out buffer (N x C, float64 or float32)
+ *  if provided; otherwise, new 2-D \c memoryview of \c dtype
+ *  (\c "float64" by default or \c "float32") is returned.
+ */
+static PyObject * liblvq__lvq__classify_weight_batch(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = { "matrix", "out", "dtype", NULL };
+
+    PyObject *   py_matrix;
+    PyObject *   py_out = Py_None;
+    const char * dtype  = NULL;
+    parse_args_kw(args, kwds, "O|Oz", kwlist, &py_matrix, &py_out, &dtype);
+
+    const bool f32 = NULL != dtype && 0 == ::strcmp(dtype, "float32");
+    if (NULL != dtype && !f32 && 0 != ::strcmp(dtype, "float64"))
+        throw std::logic_error("Invalid dtype (\"float64\" or \"float32\" expected)");
+
+    buffer_view matrix(py_matrix);
+
+    const size_t rows = matrix.rows();
+    const size_t ccnt = model_clusters(self);
+
+    py_ref py_result(Py_None == py_out
+        ? (f32
+            ? new_matrix("f", rows, ccnt, sizeof(float))
+            : new_matrix("d", rows, ccnt, sizeof(double)))
+        : (Py_INCREF(py_out), py_out));
+
+    buffer_view out(py_result.get(), true);
+
+    if (buffer_view::FLOAT64 != out.dtype() &&
+        buffer_view::FLOAT32 != out.dtype())
+    {
+        throw std::logic_error("Invalid output (float64/float32 buffer expected)");
+    }
+
+    if (2 != out.ndim() || rows != out.rows() || ccnt != out.cols())
+        throw std::logic_error("Invalid output (N x C matrix expected)");
+
+    // Call implementation (on the latest model)
+    {
+        gil_release nogil;
+
+        const lvq_snapshot_ptr snapshot = snapshot_acquire(self);
+
+        check_input_matrix(matrix, snapshot->dimension());
+
+        std::shared_ptr<thread_pool> pool = get_pool();
+        pool->parallel_for(rows, pool->chunk(rows),
+        [&](size_t begin, size_t end) {
+            std::vector<double> weight(ccnt);
+            lvq_t::input_t      input(matrix.cols());
+
+            for (size_t i = begin; i < end; ++i) {
+                row_weight(self, *snapshot, matrix, i, input, weight);
+
+                if (buffer_view::FLOAT64 == out.dtype())
+                    std::copy(weight.begin(), weight.end(), out.row<double>(i));
+                else
+                    std::copy(weight.begin(), weight.end(), out.row<float>(i));
+            }
+        });
+    }
+
+    return py_result.release();
+}
+
+BINDING_INST_KW(liblvq__lvq__classify_weight_batch)
+
+
+/**
+ *  \brief  ml::lvq::best binding
+ */
+static PyObject * liblvq__lvq__best(PyObject * self, PyObject * args) {
+    // Get arguments
+    PyObject * py_weight;
+    size_t n;
+    parse_args(args, "On", &py_weight, &n);
+
+    const std::vector<double> weight = python2weight(py_weight);
+
+    // Call implementation
+    const std::vector<lvq_t::cw_t> cw_vec = lvq_t::best(weight, n);
+
+    // Transform result
+    return cw_vec2python(cw_vec);
+}
+
+BINDING_INST(liblvq__lvq__best)
+
+
+/**
+ *  \brief  Best clusters by indexed dense prototypes
+ *
+ *  Index candidates (see \ref dense_codebook::candidates) are ranked
+ *  by distance; their weights are normalised over the candidates
+ *  (see \ref dist2weight), i.e. prototypes not probed are taken
+ *  for having negligible weight.
+ *  \c nprobe (see \ref dense_codebook::set_index_nprobe) is the
+ *  recall/latency knob.
+ *
+ *  \param  dense  Dense prototypes
+ *  \param  x      Query
+ *  \param  n      Best clusters count
+ *
+ *  \return Best clusters and their weights (by descending weight)
+ */
+template <typename S>
+static std::vector<lvq_t::cw_t> indexed_best(
+    const dense_codebook & dense,
+    const S *              x,
+    size_t                 n)
+{
+    static thread_local std::vector<std::pair<double, size_t> > cand;
+    dense.candidates(x, n, cand);
+
+    std::vector<double> d2(cand.size());
+    for (size_t i = 0; i < cand.size(); ++i) d2[i] = cand[i].first;
+
+    const std::vector<double> weight = dist2weight(d2);
+
+    std::vector<lvq_t::cw_t> best(std::min(n, cand.size()));
+    for (size_t i = 0; i < best.size(); ++i)
+        best[i] = lvq_t::cw_t(cand[i].second, weight[i]);
+
+    return best;
+}
+
+
+/**
+ *  \brief  Best clusters on model snapshot
+ *
+ *  Indexed dense prototypes are used if available (see \ref indexed_best);
+ *  otherwise, the best of all classification weights are selected.
+ *
+ *  \param  model  Model snapshot
+ *  \param  input  Input
+ *  \param  n      Best clusters count
+ *
+ *  \return Best clusters and their weights
+ */
+static std::vector<lvq_t::cw_t> snapshot_best(
+    const lvq_snapshot &   model,
+    const lvq_t::input_t & input,
+    size_t                 n)
+{
+    const dense_codebook * dense = model.dense();
+
+    if (NULL == dense || 0 == dense->index_nlist())
+        return lvq_t::best(snapshot_weight(model, input), n);
+
+    if (dense->dimension() != input.rank())
+        throw std::logic_error("Invalid input (dimension mismatch)");
+
+    std::vector<double> x(input.rank());
+    input2dense(input, x.data());
+
+    return indexed_best(*dense, x.data(), n);
+}
+
+
+/**
+ *  \brief  \c ml::lvq::classify_best binding
+ *
+ *  Indexed models rank the index candidates only (see \ref indexed_best).
+ */
+static PyObject * liblvq__lvq__classify_best(PyObject * self, PyObject * args) {
+    // Get arguments
+    PyObject * py_input;
+    size_t     n;
+    parse_args(args, "On", &py_input, &n);
+
+    const lvq_t::input_t input = python2input(py_input);
+    check_undef(self, input);
+
+    // Call implementation (on the latest model)
+    std::vector<lvq_t::cw_t> cw_vec;
+    {
+        gil_release nogil;
+        cw_vec = snapshot_best(*snapshot_acquire(self), input, n);
+    }
+
+    // Transform result
+    return cw_vec2python(cw_vec);
+}
+
+BINDING_INST(liblvq__lvq__classify_best)
+
+
+/**
+ *  \brief  Batch \c ml::lvq::classify_best binding
+ *
+ *  For each row of a 2-D C-contiguous float64/float32 buffer,
+ *  selects the \c k best clusters (by descending weight, partial sort).
+ *  Returns tuple of new 2-D \c memoryview objects: cluster indices
+ *  (N x k, 64-bit integers) and their weights (N x k, float64).
+ *  \c k is limited by the clusters count.
+ *  Indexed models rank the index candidates only (see \ref indexed_best).
+ */
+static PyObject * liblvq__lvq__classify_best_batch(
+    PyObject * self,
+    PyObject * args)
+{
+    // Get arguments
+    PyObject * py_matrix;
+    size_t     k;
+    parse_args(args, "On", &py_matrix, &k);
+
+    buffer_view matrix(py_matrix);
+
+    const size_t rows = matrix.rows();
+    const size_t ccnt = model_clusters(self);
+
+    k = std::min(k, ccnt);
+    if (0 == k)
+        throw std::logic_error("Invalid k (must be > 0)");
+
+    py_ref py_index(new_matrix("q", rows, k, sizeof(int64_t)));
+    py_ref py_weight(new_matrix("d", rows, k, sizeof(double)));
+
+    buffer_view index(py_index.get(), true);
+    buffer_view weight(py_weight.get(), true);
+
+    // Call implementation (on the latest model)
+    {
+        gil_release nogil;
+
+        const lvq_snapshot_ptr snapshot = snapshot_acquire(self);
+
+        check_input_matrix(matrix, snapshot->dimension());
+
+        const dense_codebook * dense = snapshot->dense();
+        const bool indexed = NULL != dense && 0 < dense->index_nlist();
+
+        std::shared_ptr<thread_pool> pool = get_pool();
+        pool->parallel_for(rows, pool->chunk(rows),
+        [&](size_t begin, size_t end) {
+            std::vector<double> w(ccnt);
+            std::vector<size_t> best(ccnt);
+            lvq_t::input_t      input(matrix.cols());
+
+            for (size_t i = begin; i < end; ++i) {
+                int64_t * irow = index.row<int64_t>(i);
+                double *  wrow = weight.row<double>(i);
+
+                // Indexed: index candidates only
+                if (indexed) {
+                    const size_t cols = matrix.cols();
+                    std::vector<lvq_t::cw_t> cw_vec;
+
+                    if (buffer_view::FLOAT64 == matrix.dtype()) {
+                        const double * x = matrix.row<const double>(i);
+                        check_undef(self, x, cols);
+                        cw_vec = indexed_best(*dense, x, k);
+                    }
+                    else {
+                        const float * x = matrix.row<const float>(i);
+                        check_undef(self, x, cols);
+                        cw_vec = indexed_best(*dense, x, k);
+                    }
+
+                    for (size_t j = 0; j < k; ++j) {
+                        irow[j] = cw_vec[j].first;
+                        wrow[j] = cw_vec[j].second;
+                    }
+
+                    continue;
+                }
+
+                row_weight(self, *snapshot, matrix, i, input, w);
+
+                for (size_t c = 0; c < ccnt; ++c) best[c] = c;
+
+                std::partial_sort(best.begin(), best.begin() + k, best.end(),
+                [&w](size_t c1, size_t c2) {
+                    return w[c1] > w[c2] || (w[c1] == w[c2] && c1 < c2);
+                });
+
+                for (size_t j = 0; j < k; ++j) {
+                    irow[j] = best[j];
+                    wrow[j] = w[best[j]];
+                }
+            }
+        });
+    }
+
+    // Transform result
+    return Py_BuildValue("(OO)", py_index.get(), py_weight.get());
+}
+
+BINDING_INST(liblvq__lvq__classify_best_batch)
+
+
+/**
+ *  \brief  \c ml::lvq::weight_threshold binding
+ */
+static PyObject * liblvq__lvq__weight_threshold(
+    PyObject * self,
+    PyObject * args)
+{
+    PyObject * py_weight;
+    double     wthres;
+    parse_args(args, "Od", &py_weight, &wthres);
+
+    const std::vector<double> weight = python2weight(py_weight);
+
+    // Call implementation
+    const std::vector<lvq_t::cw_t> cw_vec =
+        lvq_t::weight_threshold(weight, wthres);
+
+    // Transform result
+    return cw_vec2python(cw_vec);
+}
+
+BINDING_INST(liblvq__lvq__weight_threshold)
+
+
+/**
+ *  \brief  \c ml::lvq::classify_weight_threshold binding
+ */
+static PyObject * liblvq__lvq__classify_weight_threshold(
+    PyObject * self,
+    PyObject * args)
+{
+    // Get arguments
+    PyObject * py_input;
+    double     wthres;
+    parse_args(args, "Od", &py_input, &wthres);
+
+    const lvq_t::input_t input = python2input(py_input);
+    check_undef(self, input);
+
+    // Call implementation (on the latest model)
+    std::vector<lvq_t::cw_t> cw_vec;
+    {
+        gil_release nogil;
+        cw_vec = lvq_t::weight_threshold(
+            snapshot_weight(*snapshot_acquire(self), input), wthres);
+    }
+
+    // Transform result
+    return cw_vec2python(cw_vec);
+}
+
+BINDING_INST(liblvq__lvq__classify_weight_threshold)
+
+
+/**
+ *  \brief  Test set samples evaluation
+ *
+ *  Finds best matching units of test samples (dense prototypes are used
+ *  if available, the search is exact even if indexed); a single instance
+ *  serves one thread.
+ */
+class test_evaluator {
+    private:
+
+    PyObject *             m_self;   /**< Python LVQ object        */
+    const lvq_snapshot &   m_model;  /**< Model snapshot           */
+    const dense_codebook * m_dense;  /**< Dense prototypes or NULL */
+    lvq_t::input_t         m_input;  /**< Input (work area)        */
+    std::vector<double>    m_x;      /**< Sample (work area)       */
+    std::vector<double>    m_w;      /**< Distances/prototype      */
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  self      Python LVQ object
+     *  \param  snapshot  Model snapshot
+     */
+    test_evaluator(PyObject * self, const lvq_snapshot & snapshot):
+        m_self(self),
+        m_model(snapshot),
+        m_dense(snapshot.dense()),
+        m_input(snapshot.dimension()),
+        m_x(snapshot.dimension()),
+        m_w(std::max(snapshot.dimension(), snapshot.clusters()))
+    {}
+
+    /**
+     *  \brief  Best matching unit of a sample
+     *
+     *  \param  x       Sample (float64 or float32, NaN stands for undefined)
+     *  \param  bmu_d2  Squared distance to the BMU (output, or \c NULL)
+     *
+     *  \return BMU cluster
+     */
+    template <typename S>
+    size_t bmu(const S * x, double * bmu_d2 = NULL) {
+        const size_t dim = m_model.dimension();
+
+        check_undef(m_self, x, dim);
+
+        if (NULL != m_dense) {
+            if (NULL == bmu_d2) return m_dense->nearest(x);
+
+            m_dense->dist2(x, m_w.data());
+
+            const size_t c = std::min_element(
+                m_w.begin(), m_w.begin() + m_model.clusters()) - m_w.begin();
+
+            *bmu_d2 = m_w[c];
+            return c;
+        }
+
+        for (size_t j = 0; j < dim; ++j)
+            m_input[j] = std::isnan(x[j])
+                       ? lvq_t::base_t::undef
+                       : lvq_t::base_t(x[j]);
+
+        return bmu(m_input, bmu_d2);
+    }
+
+    /**
+     *  \brief  Best matching unit of an input
+     *
+     *  \param  input   Input
+     *  \param  bmu_d2  Squared distance to the BMU (output, or \c NULL)
+     *
+     *  \return BMU cluster
+     */
+    size_t bmu(const lvq_t::input_t & input, double * bmu_d2 = NULL) {
+        if (NULL != m_dense) {
+            input2dense(input, m_x.data());
+            return bmu(m_x.data(), bmu_d2);
+        }
+
+        check_undef(m_self, input);
+
+        const lvq_t & lvq = m_model.lvq();
+        const size_t  c   = lvq.classify(input);
+
+        if (NULL != bmu_d2) {
+            input2dense(input, m_x.data());
+            input2dense(lvq.get(c), m_w.data());
+            *bmu_d2 = dist2(m_x.data(), m_w.data(), lvq.dimension());
+        }
+
+        return c;
+    }
+
+};  // end of class test_evaluator
+
+
+/**
+ *  \brief  Evaluate test set shards in parallel
+ *
+ *  The set is split to shards (several per pool thread, see
+ *  \ref thread_pool::chunk); each shard is evaluated into its own
+ *  statistics, which are merged in the end.
+ *  The latest model is tested (see \ref snapshot_acquire).
+ *
+ *  \param  self   Python LVQ object
+ *  \param  stats  Statistics (merged result)
+ *  \param  size   Test set size
+ *  \param  fn     Shard evaluation: \c fn(eval, begin, end, stats)
+ */
+template <class Stats, typename Fn>
+static void test_sharded(
+    PyObject * self,
+    Stats    & stats,
+    size_t     size,
+    const Fn & fn)
+{
+    if (0 == size) return;
+
+    std::shared_ptr<thread_pool> pool = get_pool();
+
+    // Several shards per thread (for load balancing)
+    const size_t chunk  = pool->chunk(size);
+    const size_t shards = (size + chunk - 1) / chunk;
+
+    std::vector<Stats> local(shards, Stats(stats.clusters()));
+
+    gil_release nogil;
+    const lvq_snapshot_ptr snapshot = snapshot_acquire(self);
+
+    if (stats.clusters() != snapshot->clusters())
+        throw std::logic_error("Clusters count changed");
+
+    pool->parallel_for(size, chunk, [&](size_t begin, size_t end) {
+        test_evaluator eval(self, *snapshot);
+        fn(eval, begin, end, local[begin / chunk]);
+    });
+
+    for (const auto & shard: local) stats.merge(shard);
+}
+
+
+/**
+ *  \brief  Test classifier on sample matrix
+ *
+ *  \param  self    Python LVQ object
+ *  \param  stats   Statistics
+ *  \param  matrix  Sample matrix (float64 or float32)
+ *  \param  labels  Sample clusters
+ */
+static void test_classifier_matrix(
+    PyObject *                   self,
+    lvq_classifier_stats_t &     stats,
+    const buffer_view &          matrix,
+    const std::vector<int64_t> & labels)
+{
+    if (labels.size() != matrix.rows())
+        throw std::logic_error("Labels count doesn't match matrix rows");
+
+    test_sharded(self, stats, matrix.rows(),
+    [&](test_evaluator & eval, size_t begin, size_t end,
+        lvq_classifier_stats_t & shard)
+    {
+        for (size_t i = begin; i < end; ++i)
+            shard.add(labels[i], buffer_view::FLOAT64 == matrix.dtype()
+                ? eval.bmu(matrix.row<const double>(i))
+                : eval.bmu(matrix.row<const float>(i)));
+    });
+}
+
+
+/**
+ *  \brief  Test clustering on sample matrix
+ *
+ *  \param  self    Python LVQ object
+ *  \param  stats   Statistics
+ *  \param  matrix  Sample matrix (float64 or float32)
+ */
+static void test_clustering_matrix(
+    PyObject *               self,
+    lvq_clustering_stats_t & stats,
+    const buffer_view &      matrix)
+{
+    test_sharded(self, stats, matrix.rows(),
+    [&](test_evaluator & eval, size_t begin, size_t end,
+        lvq_clustering_stats_t & shard)
+    {
+        for (size_t i = begin; i < end; ++i) {
+            double d2;
+            const size_t c = buffer_view::FLOAT64 == matrix.dtype()
+                ? eval.bmu(matrix.row<const double>(i), &d2)
+                : eval.bmu(matrix.row<const float>(i),  &d2);
+
+            shard.add(c, d2);
+        }
+    });
+}
+
+
+/**
+ *  \brief  Test classifier on a test set
+ *
+ *  \c py_set may be a sequence of (input, cluster) tuples, a binary
+ *  training set file path, \c TrainingSet or 2-D C-contiguous
+ *  float64/float32 sample matrix buffer (\c py_labels are required then).
+ *  Test set shards are evaluated in parallel.
+ *
+ *  \param  self       Python LVQ object
+ *  \param  stats      Statistics (updated)
+ *  \param  py_set     Test set
+ *  \param  py_labels  Sample matrix labels (or \c None)
+ */
+static void test_classifier_set(
+    PyObject *               self,
+    lvq_classifier_stats_t & stats,
+    PyObject *               py_set,
+    PyObject *               py_labels)
+{
+    std::unique_ptr<tset_file> file;
+    const tset_matrix * native = python2tset_matrix(self, py_set, true, file);
+
+    if (NULL != native) {
+        const tset_matrix & set = *native;
+
+        test_sharded(self, stats, set.size(),
+        [&set](test_evaluator & eval, size_t begin, size_t end,
+            lvq_classifier_stats_t & shard)
+        {
+            for (size_t i = begin; i < end; ++i)
+                shard.add(set.labels()[i], eval.bmu(set.row(i)));
+        });
+    }
+    else if (PyObject_CheckBuffer(py_set)) {
+        if (Py_None == py_labels)
+            throw std::logic_error("Labels required for sample matrix");
+
+        buffer_view matrix(py_set);
+        check_input_matrix(matrix, model_dimension(self));
+
+        std::vector<int64_t> labels;
+        python2labels(py_labels, labels);
+
+        test_classifier_matrix(self, stats, matrix, labels);
+    }
+    else {
+        const tset_classifier_t set = python2tset_classifier(py_set);
+
+        test_sharded(self, stats, set.size(),
+        [&set](test_evaluator & eval, size_t begin, size_t end,
+            lvq_classifier_stats_t & shard)
+        {
+            for (size_t i = begin; i < end; ++i)
+                shard.add(set[i].second, eval.bmu(set[i].first));
+        });
+    }
+}
+
+
+/**
+ *  \brief  Test clustering on a test set
+ *
+ *  \c py_set may be a sequence of inputs, a binary training set file path,
+ *  \c TrainingSet or 2-D C-contiguous float64/float32 sample matrix buffer.
+ *  Test set shards are evaluated in parallel.
+ *
+ *  \param  self    Python LVQ object
+ *  \param  stats   Statistics (updated)
+ *  \param  py_set  Test set
+ */
+static void test_clustering_set(
+    PyObject *               self,
+    lvq_clustering_stats_t & stats,
+    PyObject *               py_set)
+{
+    std::unique_ptr<tset_file> file;
+    const tset_matrix * native = python2tset_matrix(self, py_set, false, file);
+
+    if (NULL != native) {
+        const tset_matrix & set = *native;
+
+        test_sharded(self, stats, set.size(),
+        [&set](test_evaluator & eval, size_t begin, size_t end,
+            lvq_clustering_stats_t & shard)
+        {
+            for (size_t i = begin; i < end; ++i) {
+                double d2;
+                const size_t c = eval.bmu(set.row(i), &d2);
+                shard.add(c, d2);
+            }
+        });
+    }
+    else if (PyObject_CheckBuffer(py_set)) {
+        buffer_view matrix(py_set);
+        check_input_matrix(matrix, model_dimension(self));
+
+        test_clustering_matrix(self, stats, matrix);
+    }
+    else {
+        const tset_clustering_t set = python2tset_clustering(py_set);
+
+        test_sharded(self, stats, set.size(),
+        [&set](test_evaluator & eval, size_t begin, size_t end,
+            lvq_clustering_stats_t & shard)
+        {
+            for (size_t i = begin; i < end; ++i) {
+                double d2;
+                const size_t c = eval.bmu(set[i], &d2);
+                shard.add(c, d2);
+            }
+        });
+    }
+}
+
+
+/**
+ *  \brief  Create Python classifier statistics object
+ *
+ *  \param  stats   Statistics
+ *  \param  py_lvq  Python LVQ object the statistics are bound to (or \c NULL)
+ *
+ *  \return New Python classifier statistics object
+ */
+static PyObject * classifier_stats2python(
+    const lvq_classifier_stats_t & stats,
+    PyObject *                     py_lvq)
+{
+    PyTypeObject * lvq_stats_type = get_lvqClassifierStatisticsType();
+
+    lvqClassifierStatisticsObject_t * py_lvq_stats =
+        reinterpret_cast<lvqClassifierStatisticsObject_t *>(
+            lvq_stats_type->tp_alloc(lvq_stats_type, 0));
+
+    if (NULL == py_lvq_stats) return NULL;
+
+    py_lvq_stats->lvq_stats = new lvq_classifier_stats_t(stats);
+
+    Py_XINCREF(py_lvq);
+    py_lvq_stats->py_lvq = py_lvq;
+
+    return reinterpret_cast<PyObject *>(py_lvq_stats);
+}
+
+
+/**
+ *  \brief  Create Python clustering statistics object
+ *
+ *  \param  stats   Statistics
+ *  \param  py_lvq  Python LVQ object the statistics are bound to (or \c NULL)
+ *
+ *  \return New Python clustering statistics object
+ */
+static PyObject * clustering_stats2python(
+    const lvq_clustering_stats_t & stats,
+    PyObject *                     py_lvq)
+{
+    PyTypeObject * lvq_stats_type = get_lvqClusteringStatisticsType();
+
+    lvqClusteringStatisticsObject_t * py_lvq_stats =
+        reinterpret_cast<lvqClusteringStatisticsObject_t *>(
+            lvq_stats_type->tp_alloc(lvq_stats_type, 0));
+
+    if (NULL == py_lvq_stats) return NULL;
+
+    py_lvq_stats->lvq_stats = new lvq_clustering_stats_t(stats);
+
+    Py_XINCREF(py_lvq);
+    py_lvq_stats->py_lvq = py_lvq;
+
+    return reinterpret_cast<PyObject *>(py_lvq_stats);
+}
+
+
+/**
+ *  \brief  \c ml::lvq::test_classifier binding
+ *
+ *  \c set may also be a binary training set file path or 2-D C-contiguous
+ *  float64/float32 sample matrix buffer (\c labels are required then).
+ *  Test set shards are evaluated in parallel.
+ *  The statistics are bound to the object (see statistics \c update).
+ */
+static PyObject * liblvq__lvq__test_classifier(PyObject * self, PyObject * args) {
+    // Get arguments
+    PyObject * py_set;
+    PyObject * py_labels = Py_None;
+    parse_args(args, "O|O", &py_set, &py_labels);
+
+    // Call implementation
+    lvq_classifier_stats_t stats(model_clusters(self));
+    test_classifier_set(self, stats, py_set, py_labels);
+
+    // Transform result
+    return classifier_stats2python(stats, self);
+}
+
+BINDING_INST(liblvq__lvq__test_classifier)
+
+
+/**
+ *  \brief  \c ml::lvq::test_clustering binding
+ *
+ *  \c set may also be a binary training set file path or 2-D C-contiguous
+ *  float64/float32 sample matrix buffer.
+ *  Test set shards are evaluated in parallel.
+ *  The statistics are bound to the object (see statistics \c update).
+ */
+static PyObject * liblvq__lvq__test_clustering(PyObject * self, PyObject * args) {
+    // Get arguments
+    PyObject * py_set;
+    parse_args(args, "O", &py_set);
+
+    // Call implementation
+    lvq_clustering_stats_t stats(model_clusters(self));
+    test_clustering_set(self, stats, py_set);
+
+    // Transform result
+    return clustering_stats2python(stats, self);
+}
+
+BINDING_INST(liblvq__lvq__test_clustering)
+
+
+/**
+ *  \brief  Binary model image of Python LVQ object
+ *
+ *  Dense prototypes are stored as is; models without them are stored
+ *  as float64 (see \ref model_header).
+ *  Must be called with the object locked for reading.
+ *
+ *  \param  self   Python LVQ object
+ *  \param  image  Image (output)
+ *
+ *  \return Image size
+ */
+static size_t model_image(PyObject * self, std::vector<uint64_t> & image) {
+    std::unique_ptr<dense_codebook> tmp;
+    const dense_codebook * dense = python2lvq_dense(self);
+
+    if (NULL == dense) {
+        const lvq_t & lvq = *python2lvq(self);
+
+        tmp.reset(new codebook<double>(lvq.dimension(), lvq.clusters()));
+        tmp->load(lvq);
+        dense = tmp.get();
+    }
+
+    uint32_t flags = 0;
+    if (NULL != python2lvq_dense(self))
+        flags |= model_header::DENSE;
+    if (!reinterpret_cast<lvqObject_t *>(self)->allow_undef)
+        flags |= model_header::NO_UNDEF;
+
+    const size_t size = model_image_size(*dense);
+
+    image.resize((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));  // 8B aligned
+    model_image_write(*dense, flags, reinterpret_cast<char *>(image.data()));
+
+    return size;
+}
+
+
+/**
+ *  \brief  Store binary model file
+ *
+ *  Must be called with the object locked for reading.
+ *
+ *  \param  self  Python LVQ object
+ *  \param  file  File path
+ */
+static void store_binary(PyObject * self, const char * file) {
+    std::vector<uint64_t> image;
+    const size_t size = model_image(self, image);
+
+    FILE * fp = ::fopen(file, "wb");
+    if (NULL == fp)
+        throw std::runtime_error("Failed to open model file");
+
+    const bool ok = 1 == ::fwrite(image.data(), size, 1, fp);
+
+    if (0 != ::fclose(fp) || !ok) {
+        ::remove(file);
+        throw std::runtime_error("Failed to write model file");
+    }
+}
+
+
+/**
+ *  \brief  \c ml::lvq::store binding
+ *
+ *  \c format="binary" stores binary model file (see \ref model_header)
+ *  which may be loaded by \c load_mmap.
+ */
+static PyObject * liblvq__lvq__store(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = { "file", "format", NULL };
+
+    const char * file;
+    const char * format = NULL;
+    parse_args_kw(args, kwds, "s|z", kwlist, &file, &format);
+
+    const bool binary = NULL != format && 0 == ::strcmp(format, "binary");
+    if (NULL != format && !binary && 0 != ::strcmp(format, "text"))
+        throw std::logic_error("Invalid format (\"text\" or \"binary\" expected)");
+
+    // Call implementation
+    {
+        lvq_reader access(self);
+
+        if (binary)
+            store_binary(self, file);
+        else
+            python2lvq(self)->store(file);
+    }
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+BINDING_INST_KW(liblvq__lvq__store)
+
+
+/**
+ *  \brief  \c ml::lvq::load binding
+ */
+static PyObject * liblvq__lvq__load(
+    PyObject * type,
+    PyObject * args,
+    PyObject * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = { "file", "dtype", "allow_undef", NULL };
+
+    const char * file;
+    const char * dtype       = NULL;
+    int          allow_undef = 1;
+    parse_args_kw(args, kwds, "s|zp", kwlist, &file, &dtype, &allow_undef);
+
+    py_ref py_result(((PyTypeObject *)type)->tp_alloc((PyTypeObject *)type, 0));
+    if (NULL == py_result.get()) return NULL;
+
+    lvqObject_t * py_lvq = reinterpret_cast<lvqObject_t *>(py_result.get());
+
+    // Create dummy ml::lvq instance
+    py_lvq->lvq         = new lvq_t(0, 0);
+    py_lvq->lock        = new rwlock();
+    py_lvq->snapshots   = new snapshot_cell();
+    py_lvq->allow_undef = allow_undef;
+
+    // Call implementation
+    {
+        gil_release nogil;
+        *py_lvq->lvq = lvq_t::load(file);
+    }
+
+    // Dense prototypes copy
+    if (NULL != dtype) {
+        const lvq_t & lvq = *py_lvq->lvq;
+
+        py_lvq->dense = new_codebook(dtype, lvq.dimension(), lvq.clusters());
+        py_lvq->dense->load(lvq);
+    }
+
+    snapshot_publish(py_result.get());
+
+    return py_result.release();
+}
+
+BINDING_INST_KW(liblvq__lvq__load)
+
+
+/**
+ *  \brief  Create Python LVQ object from binary model image
+ *
+ *  \param  type         Python LVQ type
+ *  \param  image        Image
+ *  \param  size         Image size
+ *  \param  verify       Verify checksum
+ *  \param  storage      Image storage owner (rows are used in place)
+ *  \param  allow_undef  Undefined values allowed (-1 means as stored)
+ *  \param  dense        Keep dense prototypes (even if the model had none)
+ *
+ *  \return Python LVQ object
+ */
+static PyObject * model_image2python(
+    PyObject *                    type,
+    char *                        image,
+    size_t                        size,
+    bool                          verify,
+    const std::shared_ptr<void> & storage,
+    int                           allow_undef,
+    bool                          dense)
+{
+    py_ref py_result(((PyTypeObject *)type)->tp_alloc((PyTypeObject *)type, 0));
+    if (NULL == py_result.get()) return NULL;
+
+    lvqObject_t * py_lvq = reinterpret_cast<lvqObject_t *>(py_result.get());
+
+    py_lvq->lock      = new rwlock();
+    py_lvq->snapshots = new snapshot_cell();
+
+    uint32_t flags;
+    {
+        gil_release nogil;
+
+        py_lvq->dense = model_image_load(image, size, verify, storage, flags);
+
+        // ml::lvq instance is built lazily if the dense prototypes are kept
+        if (!dense && !(flags & model_header::DENSE)) {
+            py_lvq->lvq = codebook2lvq(*py_lvq->dense);
+
+            delete py_lvq->dense;
+            py_lvq->dense = NULL;
+        }
+    }
+
+    py_lvq->allow_undef = 0 <= allow_undef
+        ? 0 != allow_undef
+        : !(flags & model_header::NO_UNDEF);
+
+    snapshot_publish(py_result.get());
+
+    return py_result.release();
+}
+
+
+/**
+ *  \brief  Binary model file memory-mapping load
+ *
+ *  Prototypes of the file (see \ref model_header) are used in place
+ *  by the (dense) model; the mapping is read-only, so the pages are shared
+ *  with other processes (also forked) until the model is modified
+ *  (the prototypes are copied then).
+ *  The \c ml::lvq instance is only built once needed (e.g. by training).
+ *  The checksum is verified unless \c verify=False.
+ *  Undefined values are allowed as stored unless \c allow_undef is given.
+ */
+static PyObject * liblvq__lvq__load_mmap(
+    PyObject * type,
+    PyObject * args,
+    PyObject * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = { "file", "allow_undef", "verify", NULL };
+
+    const char * file;
+    int          allow_undef = -1;  // as stored
+    int          verify      = 1;
+    parse_args_kw(args, kwds, "s|pp", kwlist, &file, &allow_undef, &verify);
+
+    // Call implementation
+    size_t                size;
+    std::shared_ptr<void> map;
+    {
+        gil_release nogil;
+        map = model_file_map(file, size);
+    }
+
+    return model_image2python(type,
+        reinterpret_cast<char *>(map.get()), size, verify, map,
+        allow_undef, true);
+}
+
+BINDING_INST_KW(liblvq__lvq__load_mmap)
+
+
+/**
+ *  \brief  Serialise to bytes
+ *
+ *  The binary model image (see \ref model_header) is used.
+ */
+static PyObject * liblvq__lvq__to_bytes(PyObject * self, PyObject * args) {
+    parse_args(args, "");
+
+    // Call implementation
+    std::vector<uint64_t> image;
+    size_t size;
+    {
+        lvq_reader access(self);
+        size = model_image(self, image);
+    }
+
+    // Transform result
+    PyObject * py_bytes = PyBytes_FromStringAndSize(
+        reinterpret_cast<const char *>(image.data()), size);
+
+    if (NULL == py_bytes)
+        throw std::runtime_error("Failed to create bytes");
+
+    return py_bytes;
+}
+
+BINDING_INST(liblvq__lvq__to_bytes)
+
+
+/**
+ *  \brief  Deserialise from bytes (or any buffer)
+ *
+ *  See \c to_bytes.
+ */
+static PyObject * liblvq__lvq__from_bytes(
+    PyObject * type,
+    PyObject * args,
+    PyObject * kwds)
+{
+    // Get arguments
+    static const char * kwlist[] = { "data", "verify", NULL };
+
+    PyObject * py_data;
+    int        verify = 1;
+    parse_args_kw(args, kwds, "O|p", kwlist, &py_data, &verify);
+
+    buffer_view data(py_data);
+    const size_t size = data.bytes();
+
+    // 64B aligned copy (used by the dense prototypes in place)
+    void * copy;
+    if (0 != ::posix_memalign(&copy, 64, std::max<size_t>(size, 1)))
+        throw std::bad_alloc();
+
+    std::shared_ptr<void> storage(copy, ::free);
+    ::memcpy(copy, data.data<const char>(), size);
+
+    // Call implementation
+    return model_image2python(type,
+        reinterpret_cast<char *>(copy), size, verify, storage, -1, false);
+}
+
+BINDING_INST_KW(liblvq__lvq__from_bytes)
+
+
+/**
+ *  \brief  Pickle support
+ *
+ *  The object is reduced to \c from_bytes call on \c to_bytes result.
+ */
+static PyObject * liblvq__lvq__reduce(PyObject * self, PyObject * args) {
+    parse_args(args, "");
+
+    py_ref py_from_bytes(PyObject_GetAttrString(
+        reinterpret_cast<PyObject *>(Py_TYPE(self)), "from_bytes"));
+
+    if (NULL == py_from_bytes.get())
+        throw std::runtime_error("Failed to get from_bytes");
+
+    py_ref py_bytes(liblvq__lvq__to_bytes(self, args));
+
+    return Py_BuildValue("(O(O))", py_from_bytes.get(), py_bytes.get());
+}
+
+BINDING_INST(liblvq__lvq__reduce)
+
+
+//
+// ml::lvq::classifier_statistics member functions binding
+//
+
+/**
+ *  \brief  Constructor
+ *
+ *  \param  type  Python LVQ classifier statistics type
+ *  \param  args  Arguments
+ *  \param  kwds  Keywords
+ *
+ *  \return LVQ instance
+ */
+static PyObject * liblvq__lvq__classifier_statistics__new(
+    PyTypeObject * type,
+    PyObject     * args,
+    PyObject     * kwds)
+{
+    lvqClassifierStatisticsObject_t * py_lvq_stats =
+        reinterpret_cast<lvqClassifierStatisticsObject_t *>(type->tp_alloc(type, 0));
+
+    if (NULL == py_lvq_stats) return NULL;
+
+    liblvq__lvq__classifier_statistics__create(py_lvq_stats, args, kwds);
+
+    return reinterpret_cast<PyObject *>(py_lvq_stats);
+}
+
+/** \cond */
+static PyObject * BINDING_IDENT(liblvq__lvq__classifier_statistics__new)(
+    PyTypeObject * type,
+    PyObject     * args,
+    PyObject     * kwds)
+{
+    return wrap_X((PyObject *)NULL, liblvq__lvq__classifier_statistics__new, type, args, kwds);
+}
+/** \endcond */
+
+
+/**
+ *  \brief  Constructor (__init__)
+ *
+ *  \param  self  Python LQV classifier statistics object
+ *  \param  args  Arguments
+ *  \param  kwds  Keywords
+ *
+ *  \return 0
+ */
+static int liblvq__lvq__classifier_statistics__init(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    lvqClassifierStatisticsObject_t * py_lvq_stats =
+        reinterpret_cast<lvqClassifierStatisticsObject_t *>(self);
+
+    if (0 < py_lvq_stats->exports)
+        throw std::logic_error("Statistics counters are exported");
+
+    liblvq__lvq__classifier_statistics__destroy(py_lvq_stats);
+
+    liblvq__lvq__classifier_statistics__create(py_lvq_stats, args, kwds);
+
+    return 0;
+}
+
+/** \cond */
+static int BINDING_IDENT(liblvq__lvq__classifier_statistics__init)(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    return wrap_X((int)-1, liblvq__lvq__classifier_statistics__init, self, args, kwds);
+}
+/** \endcond */
+
+
+/**
+ *  \brief  ml::lvq::classifier_statistics::accuracy binding
+ */
+static PyObject * liblvq__lvq__classifier_statistics__accuracy(
+    PyObject * self, PyObject * args)
+{
+    // Call implementation
+    double accuracy = python2lvq_classifier_stats(self)->accuracy();
+
+    // Transform result
+    return Py_BuildValue("d", accuracy);
+}
+
+BINDING_INST(liblvq__lvq__classifier_statistics__accuracy)
+
+
+/**
+ *  \brief  ml::lvq::classifier_statistics::precision binding
+ */
+static PyObject * liblvq__lvq__classifier_statistics__precision(
+    PyObject * self, PyObject * args)
+{
+    // Get arguments
+    int c1ass;
+    parse_args(args, "I", &c1ass);
+
+    // Call implementation
+    double precision = python2lvq_classifier_stats(self)->precision(c1ass);
+
+    // Transform result
+    return Py_BuildValue("d", precision);
+}
+
+BINDING_INST(liblvq__lvq__classifier_statistics__precision)
+
+
+/**
+ *  \brief  ml::lvq::classifier_statistics::recall binding
+ */
+static PyObject * liblvq__lvq__classifier_statistics__recall(
+    PyObject * self, PyObject * args)
+{
+    // Get arguments
+    int c1ass;
+    parse_args(args, "I", &c1ass);
+
+    // Call implementation
+    double recall = python2lvq_classifier_stats(self)->recall(c1ass);
+
+    // Transform result
+    return Py_BuildValue("d", recall);
+}
+
+BINDING_INST(liblvq__lvq__classifier_statistics__recall)
+
+
+/**
+ *  \brief  ml::lvq::classifier_statistics::F(beta) binding
+ */
+static PyObject * liblvq__lvq__classifier_statistics__F_beta(
+    PyObject * self, PyObject * args)
+{
+    // Get arguments
+    double beta;
+    int    c1ass = -1;
+    parse_args(args, "d|I", &beta, &c1ass);
+
+    // Call implementation
+    double F_beta = c1ass < 0
+        ? python2lvq_classifier_stats(self)->F(beta)
+        : python2lvq_classifier_stats(self)->F(beta, (size_t)c1ass);
+
+    // Transform result
+    return Py_BuildValue("d", F_beta);
+}
+
+BINDING_INST(liblvq__lvq__classifier_statistics__F_beta)
+
+
+/**
+ *  \brief  ml::lvq::classifier_statistics::F binding
+ */
+static PyObject * liblvq__lvq__classifier_statistics__F(
+    PyObject * self, PyObject * args)
+{
+    // Get arguments
+    int c1ass = -1;
+    parse_args(args, "|I", &c1ass);
+
+    // Call implementation
+    double F = c1ass < 0
+        ? python2lvq_classifier_stats(self)->F()
+        : python2lvq_classifier_stats(self)->F((size_t)c1ass);
+
+    // Transform result
+    return Py_BuildValue("d", F);
+}
+
+BINDING_INST(liblvq__lvq__classifier_statistics__F)
+
+
+/**
+ *  \brief  Classifier statistics update
+ *
+ *  Accumulates results of the bound LVQ object classification of a test set
+ *  (see \c lvq.test_classifier for \c set and \c labels).
+ *  Partial results may be accumulated by a series of updates.
+ */
+static PyObject * liblvq__lvq__classifier_statistics__update(
+    PyObject * self, PyObject * args)
+{
+    // Get arguments
+    PyObject * py_set;
+    PyObject * py_labels = Py_None;
+    parse_args(args, "O|O", &py_set, &py_labels);
+
+    PyObject * py_lvq =
+        reinterpret_cast<lvqClassifierStatisticsObject_t *>(self)->py_lvq;
+
+    if (NULL == py_lvq)
+        throw std::logic_error("Statistics not bound to lvq object");
+
+    lvq_classifier_stats_t * lvq_stats = python2lvq_classifier_stats(self);
+
+    // Call implementation
+    lvq_classifier_stats_t stats(lvq_stats->clusters());
+    test_classifier_set(py_lvq, stats, py_set, py_labels);
+
+    lvq_stats->merge(stats);
+
+    Py_RETURN_NONE;
+}
+
+BINDING_INST(liblvq__lvq__classifier_statistics__update)
+
+
+/**
+ *  \brief  Classifier statistics merge
+ *
+ *  Adds (partial) results of other statistics of the same clusters count.
+ */
+static PyObject * liblvq__lvq__classifier_statistics__merge(
+    PyObject * self, PyObject * args)
+{
+    // Get arguments
+    PyObject * py_other;
+    parse_args(args, "O!", get_lvqClassifierStatisticsType(), &py_other);
+
+    // Call implementation
+    python2lvq_classifier_stats(self)->merge(*python2lvq_classifier_stats(py_other));
+
+    Py_RETURN_NONE;
+}
+
+BINDING_INST(liblvq__lvq__classifier_statistics__merge)
+
+
+/**
+ *  \brief  Serialise classifier statistics to bytes
+ *
+ *  The image is the (native byte order) statistics header followed
+ *  by the counters; the bound LVQ object is not serialised.
+ */
+static PyObject * liblvq__lvq__classifier_statistics__to_bytes(
+    PyObject * self, PyObject * args)
+{
+    parse_args(args, "");
+
+    const lvq_classifier_stats_t * lvq_stats = python2lvq_classifier_stats(self);
+
+    // Transform result
+    PyObject * py_bytes = PyBytes_FromStringAndSize(NULL, lvq_stats->image_size());
+
+    if (NULL == py_bytes)
+        throw std::runtime_error("Failed to create bytes");
+
+    lvq_stats->image_write(PyBytes_AS_STRING(py_bytes));
+
+    return py_bytes;
+}
+
+BINDING_INST(liblvq__lvq__classifier_statistics__to_bytes)
+
+
+/**
+ *  \brief  Deserialise classifier statistics from bytes (or any buffer)
+ *
+ *  See \c to_bytes; the statistics are bound to \c lvq object if given.
+ */
+static PyObject * liblvq__lvq__classifier_statistics__from_bytes(
+    PyObject * type, PyObject * args)
+{
+    // Get arguments
+    PyObject * py_data;
+    PyObject * py_lvq = Py_None;
+    parse_args(args, "O|O", &py_data, &py_lvq);
+
+    if (Py_None == py_lvq)
+        py_lvq = NULL;
+    else if (!PyObject_TypeCheck(py_lvq, get_lvqType()))
+        throw std::logic_error("Invalid lvq object");
+
+    buffer_view data(py_data);
+
+    // Call implementation
+    const lvq_classifier_stats_t stats =
+        lvq_classifier_stats_t::image_load(data.data<const char>(), data.bytes());
+
+    if (NULL != py_lvq && model_clusters(py_lvq) != stats.clusters())
+        throw std::logic_error("Clusters count mismatch");
+
+    // Transform result
+    return classifier_stats2python(stats, py_lvq);
+}
+
+BINDING_INST(liblvq__lvq__classifier_statistics__from_bytes)
+
+
+/**
+ *  \brief  Classifier statistics pickle support
+ *
+ *  The object is reduced to \c from_bytes call on \c to_bytes result
+ *  (and the bound LVQ object, if any).
+ */
+static PyObject * liblvq__lvq__classifier_statistics__reduce(
+    PyObject * self, PyObject * args)
+{
+    py_ref py_from_bytes(PyObject_GetAttrString(
+        reinterpret_cast<PyObject *>(Py_TYPE(self)), "from_bytes"));
+
+    if (NULL == py_from_bytes.get())
+        throw std::runtime_error("Failed to get from_bytes");
+
+    py_ref py_bytes(liblvq__lvq__classifier_statistics__to_bytes(self, args));
+
+    // Statistics bound to LVQ object stay bound
+    PyObject * py_lvq = reinterpret_cast<lvqClassifierStatisticsObject_t *>(self)->py_lvq;
+
+    if (NULL != py_lvq)
+        return Py_BuildValue("(O(OO))",
+            py_from_bytes.get(), py_bytes.get(), py_lvq);
+
+    return Py_BuildValue("(O(O))", py_from_bytes.get(), py_bytes.get());
+}
+
+BINDING_INST(liblvq__lvq__classifier_statistics__reduce)
+
+
+/**
+ *  \brief  Classifier statistics confusion matrix
+ *
+ *  Returns read-only C x C \c memoryview (uint64) of the statistics
+ *  counters (rows are ground truth classes, columns classification
+ *  results); the view reflects subsequent updates.
+ */
+static PyObject * liblvq__lvq__classifier_statistics__confusion_matrix(
+    PyObject * self, PyObject * args)
+{
+    parse_args(args, "");
+
+    lvqClassifierStatisticsObject_t * py_lvq_stats =
+        reinterpret_cast<lvqClassifierStatisticsObject_t *>(self);
+
+    const size_t ccnt = py_lvq_stats->lvq_stats->clusters();
+
+    return new_export(self, &py_lvq_stats->exports,
+        py_lvq_stats->lvq_stats->cmatrix(), "Q", sizeof(uint64_t),
+        ccnt, ccnt, true);
+}
+
+BINDING_INST(liblvq__lvq__classifier_statistics__confusion_matrix)
+
+
+/**
+ *  \brief  Classifier statistics measures of all classes
+ *
+ *  \param  self  Python classifier statistics object
+ *  \param  p     Get precisions
+ *  \param  r     Get recalls
+ *  \param  beta  Get F_beta scores (if non-negative)
+ *
+ *  \return New \c array('d') of the measure per class
+ */
+static PyObject * classifier_stats_measures(
+    PyObject * self, bool p, bool r, double beta)
+{
+    const lvq_classifier_stats_t * lvq_stats = python2lvq_classifier_stats(self);
+    const size_t ccnt = lvq_stats->clusters();
+
+    py_ref py_result(new_array("d", ccnt, sizeof(double)));
+
+    double * measure = 0 < ccnt
+        ? buffer_view(py_result.get(), true).data<double>() : NULL;
+
+    lvq_stats->measures(
+        p ? measure : NULL,
+        r ? measure : NULL,
+        0.0 <= beta ? measure : NULL,
+        std::max(beta, 0.0));
+
+    return py_result.release();
+}
+
+
+/**
+ *  \brief  ml::lvq::classifier_statistics::precision of all classes
+ */
+static PyObject * liblvq__lvq__classifier_statistics__precision_all(
+    PyObject * self, PyObject * args)
+{
+    parse_args(args, "");
+
+    return classifier_stats_measures(self, true, false, -1.0);
+}
+
+BINDING_INST(liblvq__lvq__classifier_statistics__precision_all)
+
+
+/**
+ *  \brief  ml::lvq::classifier_statistics::recall of all classes
+ */
+static PyObject * liblvq__lvq__classifier_statistics__recall_all(
+    PyObject * self, PyObject * args)
+{
+    parse_args(args, "");
+
+    return classifier_stats_measures(self, false, true, -1.0);
+}
+
+BINDING_INST(liblvq__lvq__classifier_statistics__recall_all)
+
+
+/**
+ *  \brief  ml::lvq::classifier_statistics::F(beta) of all classes
+ */
+static PyObject * liblvq__lvq__classifier_statistics__F_beta_all(
+    PyObject * self, PyObject * args)
+{
+    // Get arguments
+    double beta = 1.0;
+    parse_args(args, "|d", &beta);
+
+    if (beta < 0.0)
+        throw std::logic_error("Invalid beta (must be non-negative)");
+
+    return classifier_stats_measures(self, false, false, beta);
+}
+
+BINDING_INST(liblvq__lvq__classifier_statistics__F_beta_all)
+
+
+//
+// ml::lvq::clustering_statistics member functions binding
+//
+
+/**
+ *  \brief  Constructor
+ *
+ *  \param  type  Python LVQ clustering statistics type
+ *  \param  args  Arguments
+ *  \param  kwds  Keywords
+ *
+ *  \return LVQ instance
+ */
+static PyObject * liblvq__lvq__clustering_statistics__new(
+    PyTypeObject * type,
+    PyObject     * args,
+    PyObject     * kwds)
+{
+    lvqClusteringStatisticsObject_t * py_lvq_stats =
+        reinterpret_cast<lvqClusteringStatisticsObject_t *>(type->tp_alloc(type, 0));
+
+    if (NULL == py_lvq_stats) return NULL;
+
+    liblvq__lvq__clustering_statistics__create(py_lvq_stats, args, kwds);
+
+    return reinterpret_cast<PyObject *>(py_lvq_stats);
+}
+
+/** \cond */
+static PyObject * BINDING_IDENT(liblvq__lvq__clustering_statistics__new)(
+    PyTypeObject * type,
+    PyObject     * args,
+    PyObject     * kwds)
+{
+    return wrap_X((PyObject *)NULL, liblvq__lvq__clustering_statistics__new, type, args, kwds);
+}
+/** \endcond */
+
+
+/**
+ *  \brief  Constructor (__init__)
+ *
+ *  \param  self  Python LQV clustering statistics object
+ *  \param  args  Arguments
+ *  \param  kwds  Keywords
+ *
+ *  \return 0
+ */
+static int liblvq__lvq__clustering_statistics__init(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    lvqClusteringStatisticsObject_t * py_lvq_stats =
+        reinterpret_cast<lvqClusteringStatisticsObject_t *>(self);
+
+    if (0 < py_lvq_stats->exports)
+        throw std::logic_error("Statistics counters are exported");
+
+    liblvq__lvq__clustering_statistics__destroy(py_lvq_stats);
+
+    liblvq__lvq__clustering_statistics__create(py_lvq_stats, args, kwds);
+
+    return 0;
+}
+
+/** \cond */
+static int BINDING_IDENT(liblvq__lvq__clustering_statistics__init)(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
+    return wrap_X((int)-1, liblvq__lvq__clustering_statistics__init, self, args, kwds);
+}
+/** \endcond */
+
+
+/**
+ *  \brief  ml::lvq::clustering_statistics::avg_error binding
+ */
+static PyObject * liblvq__lvq__clustering_statistics__avg_error(
+    PyObject * self, PyObject * args)
+{
+    // Get arguments
+    int    c1ass = -1;
+    parse_args(args, "|I", &c1ass);
+
+    // Call implementation
+    double avg_error = c1ass < 0
+        ? python2lvq_clustering_stats(self)->avg_error()
+        : python2lvq_clustering_stats(self)->avg_error(c1ass);
 
-    return set;
+    // Transform result
+    return Py_BuildValue("d", avg_error);
 }
 
+BINDING_INST(liblvq__lvq__clustering_statistics__avg_error)
+
 
 /**
- *  \brief  Transform Python training/test set to \c lvq_t::tset_clustering_t set
- *
- *  The Python training set is an iterable containing (input, cluster) tuples.
- *
- *  \param  py_set  Python iterable of number tuples
+ *  \brief  Clustering statistics update
  *
- *  \return Training set
+ *  Accumulates results of the bound LVQ object clustering of a test set
+ *  (see \c lvq.test_clustering for \c set).
+ *  Partial results may be accumulated by a series of updates.
  */
-static tset_clustering_t python2tset_clustering(PyObject * py_set) {
-    Py_ssize_t set_size = PyObject_Size(py_set);
-    if (-1 == set_size)
-        throw std::logic_error("Invalid training set (can't get size)");
-
-    PyObject * py_iter = PyObject_GetIter(py_set);
-    if (NULL == py_iter)
-        throw std::logic_error("Invalid training set (should be iterable)");
+static PyObject * liblvq__lvq__clustering_statistics__update(
+    PyObject * self, PyObject * args)
+{
+    // Get arguments
+    PyObject * py_set;
+    parse_args(args, "O", &py_set);
 
-    tset_clustering_t set;
+    PyObject * py_lvq =
+        reinterpret_cast<lvqClusteringStatisticsObject_t *>(self)->py_lvq;
 
-    PyObject * py_input;
-    while (NULL != (py_input = PyIter_Next(py_iter))) {
-        const lvq_t::input_t input = python2input(py_input);
+    if (NULL == py_lvq)
+        throw std::logic_error("Statistics not bound to lvq object");
 
-        set.emplace_back(input);
+    lvq_clustering_stats_t * lvq_stats = python2lvq_clustering_stats(self);
 
-        Py_DECREF(py_input);
-    }
+    // Call implementation
+    lvq_clustering_stats_t stats(lvq_stats->clusters());
+    test_clustering_set(py_lvq, stats, py_set);
 
-    Py_DECREF(py_iter);
+    lvq_stats->merge(stats);
 
-    return set;
+    Py_RETURN_NONE;
 }
 
-
-//
-// Forward declarations
-//
-
-/** \cond */
-static PyTypeObject * get_lvqType();
-static PyTypeObject * get_lvqClassifierStatisticsType();
-static PyTypeObject * get_lvqClusteringStatisticsType();
-/** \endcond */
+BINDING_INST(liblvq__lvq__clustering_statistics__update)
 
 
 /**
- *  \brief  LVQ constructor
+ *  \brief  Clustering statistics merge
  *
- *  \param  py_lvq  Python LVQ object
- *  \param  args    Arguments
- *  \param  kwds    Keywords
+ *  Adds (partial) results of other statistics of the same clusters count.
  */
-static void liblvq__lvq__create(
-    lvqObject_t * py_lvq,
-    PyObject    * args,
-    PyObject    * kwds)
+static PyObject * liblvq__lvq__clustering_statistics__merge(
+    PyObject * self, PyObject * args)
 {
     // Get arguments
-    size_t dimension;
-    size_t clusters;
-    parse_args(args, "nn", &dimension, &clusters);
+    PyObject * py_other;
+    parse_args(args, "O!", get_lvqClusteringStatisticsType(), &py_other);
 
-    // Create ml::lvq instance
-    py_lvq->lvq = new lvq_t(dimension, clusters);
+    // Call implementation
+    python2lvq_clustering_stats(self)->merge(*python2lvq_clustering_stats(py_other));
+
+    Py_RETURN_NONE;
 }
 
+BINDING_INST(liblvq__lvq__clustering_statistics__merge)
+
 
 /**
- *  \brief  LVQ destructor
- *
- *  \param  py_lvq  Python LVQ object
+ *  \brief  Serialise clustering statistics to bytes
  *
- *  \return 0
+ *  The image is the (native byte order) statistics header followed
+ *  by the counters; the bound LVQ object is not serialised.
  */
-static int liblvq__lvq__destroy(lvqObject_t * py_lvq) {
-    lvq_t * lvq = py_lvq->lvq;
-    py_lvq->lvq = NULL;
+static PyObject * liblvq__lvq__clustering_statistics__to_bytes(
+    PyObject * self, PyObject * args)
+{
+    parse_args(args, "");
 
-    if (NULL != lvq) delete lvq;
+    const lvq_clustering_stats_t * lvq_stats = python2lvq_clustering_stats(self);
 
-    return 0;
-}
+    // Transform result
+    PyObject * py_bytes = PyBytes_FromStringAndSize(NULL, lvq_stats->image_size());
 
-/** \cond */
-static void BINDING_IDENT(liblvq__lvq__destroy)(lvqObject_t * py_lvq) {
-    wrap_X(0, liblvq__lvq__destroy, py_lvq);
+    if (NULL == py_bytes)
+        throw std::runtime_error("Failed to create bytes");
+
+    lvq_stats->image_write(PyBytes_AS_STRING(py_bytes));
+
+    return py_bytes;
 }
-/** \endcond */
+
+BINDING_INST(liblvq__lvq__clustering_statistics__to_bytes)
 
 
 /**
- *  \brief  LVQ classifier statistics constructor
+ *  \brief  Deserialise clustering statistics from bytes (or any buffer)
  *
- *  \param  py_lvq_stats  Python LVQ classifier statistics object
- *  \param  args          Arguments
- *  \param  kwds          Keywords
+ *  See \c to_bytes; the statistics are bound to \c lvq object if given.
  */
-static void liblvq__lvq__classifier_statistics__create(
-    lvqClassifierStatisticsObject_t * py_lvq_stats,
-    PyObject                        * args,
-    PyObject                        * kwds)
+static PyObject * liblvq__lvq__clustering_statistics__from_bytes(
+    PyObject * type, PyObject * args)
 {
     // Get arguments
-    size_t ccnt;
-    parse_args(args, "n", &ccnt);
+    PyObject * py_data;
+    PyObject * py_lvq = Py_None;
+    parse_args(args, "O|O", &py_data, &py_lvq);
 
-    // Create ml::lvq::classifier_statistics instance
-    py_lvq_stats->lvq_stats = new lvq_classifier_stats_t(ccnt);
-}
+    if (Py_None == py_lvq)
+        py_lvq = NULL;
+    else if (!PyObject_TypeCheck(py_lvq, get_lvqType()))
+        throw std::logic_error("Invalid lvq object");
 
+    buffer_view data(py_data);
 
-/**
- *  \brief  LVQ classifier statistics destructor
- *
- *  \param  py_lvq_stats  Python LVQ classifier statistics object
- *
- *  \return 0
- */
-static int liblvq__lvq__classifier_statistics__destroy(
-    lvqClassifierStatisticsObject_t * py_lvq_stats)
-{
-    lvq_classifier_stats_t * lvq_stats = py_lvq_stats->lvq_stats;
-    py_lvq_stats->lvq_stats = NULL;
+    // Call implementation
+    const lvq_clustering_stats_t stats =
+        lvq_clustering_stats_t::image_load(data.data<const char>(), data.bytes());
 
-    if (NULL != lvq_stats) delete lvq_stats;
+    if (NULL != py_lvq && model_clusters(py_lvq) != stats.clusters())
+        throw std::logic_error("Clusters count mismatch");
 
-    return 0;
+    // Transform result
+    return clustering_stats2python(stats, py_lvq);
 }
 
-/** \cond */
-static void BINDING_IDENT(liblvq__lvq__classifier_statistics__destroy)(
-    lvqClassifierStatisticsObject_t * py_lvq_stats)
-{
-    wrap_X(0, liblvq__lvq__classifier_statistics__destroy, py_lvq_stats);
-}
-/** \endcond */
+BINDING_INST(liblvq__lvq__clustering_statistics__from_bytes)
 
 
 /**
- *  \brief  LVQ clustering statistics constructor
+ *  \brief  Clustering statistics pickle support
  *
- *  \param  py_lvq_stats  Python LVQ clustering statistics object
- *  \param  args          Arguments
- *  \param  kwds          Keywords
+ *  The object is reduced to \c from_bytes call on \c to_bytes result
+ *  (and the bound LVQ object, if any).
  */
-static void liblvq__lvq__clustering_statistics__create(
-    lvqClusteringStatisticsObject_t * py_lvq_stats,
-    PyObject                        * args,
-    PyObject                        * kwds)
+static PyObject * liblvq__lvq__clustering_statistics__reduce(
+    PyObject * self, PyObject * args)
 {
-    // Get arguments
-    size_t ccnt;
-    parse_args(args, "n", &ccnt);
+    py_ref py_from_bytes(PyObject_GetAttrString(
+        reinterpret_cast<PyObject *>(Py_TYPE(self)), "from_bytes"));
 
-    // Create ml::lvq::clustering_statistics instance
-    py_lvq_stats->lvq_stats = new lvq_clustering_stats_t(ccnt);
+    if (NULL == py_from_bytes.get())
+        throw std::runtime_error("Failed to get from_bytes");
+
+    py_ref py_bytes(liblvq__lvq__clustering_statistics__to_bytes(self, args));
+
+    // Statistics bound to LVQ object stay bound
+    PyObject * py_lvq = reinterpret_cast<lvqClusteringStatisticsObject_t *>(self)->py_lvq;
+
+    if (NULL != py_lvq)
+        return Py_BuildValue("(O(OO))",
+            py_from_bytes.get(), py_bytes.get(), py_lvq);
+
+    return Py_BuildValue("(O(O))", py_from_bytes.get(), py_bytes.get());
 }
 
+BINDING_INST(liblvq__lvq__clustering_statistics__reduce)
+
 
 /**
- *  \brief  LVQ clustering statistics destructor
- *
- *  \param  py_lvq_stats  Python LVQ clustering statistics object
+ *  \brief  Clustering statistics error sums
  *
- *  \return 0
+ *  Returns read-only \c memoryview (float64) of squared distance sums
+ *  per cluster; the view reflects subsequent updates.
  */
-static int liblvq__lvq__clustering_statistics__destroy(
-    lvqClusteringStatisticsObject_t * py_lvq_stats)
+static PyObject * liblvq__lvq__clustering_statistics__errors(
+    PyObject * self, PyObject * args)
 {
-    lvq_clustering_stats_t * lvq_stats = py_lvq_stats->lvq_stats;
-    py_lvq_stats->lvq_stats = NULL;
+    parse_args(args, "");
 
-    if (NULL != lvq_stats) delete lvq_stats;
+    lvqClusteringStatisticsObject_t * py_lvq_stats =
+        reinterpret_cast<lvqClusteringStatisticsObject_t *>(self);
 
-    return 0;
+    return new_export(self, &py_lvq_stats->exports,
+        py_lvq_stats->lvq_stats->errors(), "d", sizeof(double),
+        py_lvq_stats->lvq_stats->clusters(), 0, true);
 }
 
-/** \cond */
-static void BINDING_IDENT(liblvq__lvq__clustering_statistics__destroy)(
-    lvqClusteringStatisticsObject_t * py_lvq_stats)
-{
-    wrap_X(0, liblvq__lvq__clustering_statistics__destroy, py_lvq_stats);
-}
-/** \endcond */
+BINDING_INST(liblvq__lvq__clustering_statistics__errors)
 
 
-//
-// ml::lvq member functions binding
-//
+/**
+ *  \brief  Clustering statistics sample counts
+ *
+ *  Returns read-only \c memoryview (uint64) of sample counts per cluster;
+ *  the view reflects subsequent updates.
+ */
+static PyObject * liblvq__lvq__clustering_statistics__counts(
+    PyObject * self, PyObject * args)
+{
+    parse_args(args, "");
 
-/** RNG seed */
-static PyObject * rng_seed(PyObject * args) {
-    int seed = 0;
-    parse_args(args, "|i", &seed);
-    srand(seed);
+    lvqClusteringStatisticsObject_t * py_lvq_stats =
+        reinterpret_cast<lvqClusteringStatisticsObject_t *>(self);
 
-    // No return value
-    Py_INCREF(Py_None);
-    return Py_None;
+    return new_export(self, &py_lvq_stats->exports,
+        py_lvq_stats->lvq_stats->counts(), "Q", sizeof(uint64_t),
+        py_lvq_stats->lvq_stats->clusters(), 0, true);
 }
 
-/** \cond */
-static PyObject * BINDING_IDENT(rng_seed)(PyObject * self, PyObject * args) {
-    return wrap_X(self, rng_seed, args);
-}
-/** \endcond */
+BINDING_INST(liblvq__lvq__clustering_statistics__counts)
 
 
 /**
- *  \brief  Constructor
- *
- *  \param  type  Python LVQ type
- *  \param  args  Arguments
- *  \param  kwds  Keywords
+ *  \brief  ml::lvq::clustering_statistics::avg_error of all clusters
  *
- *  \return LVQ instance
+ *  Returns new \c array('d') of average errors per cluster.
  */
-static PyObject * liblvq__lvq__new(
-    PyTypeObject * type,
-    PyObject     * args,
-    PyObject     * kwds)
+static PyObject * liblvq__lvq__clustering_statistics__avg_error_all(
+    PyObject * self, PyObject * args)
 {
-    lvqObject_t * py_lvq = reinterpret_cast<lvqObject_t *>(
-        type->tp_alloc(type, 0));
+    parse_args(args, "");
 
-    if (NULL == py_lvq) return NULL;
+    const lvq_clustering_stats_t * lvq_stats = python2lvq_clustering_stats(self);
+    const size_t ccnt = lvq_stats->clusters();
 
-    liblvq__lvq__create(py_lvq, args, kwds);
+    py_ref py_result(new_array("d", ccnt, sizeof(double)));
 
-    return reinterpret_cast<PyObject *>(py_lvq);
-}
+    if (0 < ccnt)
+        lvq_stats->avg_errors(buffer_view(py_result.get(), true).data<double>());
 
-/** \cond */
-static PyObject * BINDING_IDENT(liblvq__lvq__new)(
-    PyTypeObject * type,
-    PyObject     * args,
-    PyObject     * kwds)
-{
-    return wrap_X((PyObject *)NULL, liblvq__lvq__new, type, args, kwds);
+    return py_result.release();
 }
-/** \endcond */
 
+BINDING_INST(liblvq__lvq__clustering_statistics__avg_error_all)
+
+
+//
+// Training job member functions binding
+//
 
 /**
- *  \brief  Constructor (__init__)
+ *  \brief  Training job destructor
  *
- *  \param  self  Python LQV object
- *  \param  args  Arguments
- *  \param  kwds  Keywords
+ *  Dropping unfinished job cancels the training.
+ *
+ *  \param  py_job  Python training job object
  *
  *  \return 0
  */
-static int liblvq__lvq__init(
-    PyObject * self,
-    PyObject * args,
-    PyObject * kwds)
-{
-    lvqObject_t * py_lvq = reinterpret_cast<lvqObject_t *>(self);
+static int liblvq__train_job__destroy(trainJobObject_t * py_job) {
+    train_job * job = py_job->job;
+    py_job->job = NULL;
 
-    liblvq__lvq__destroy(py_lvq);
+    if (NULL != job) delete job;
 
-    liblvq__lvq__create(py_lvq, args, kwds);
+    Py_TYPE(py_job)->tp_free(reinterpret_cast<PyObject *>(py_job));
 
     return 0;
 }
 
 /** \cond */
-static int BINDING_IDENT(liblvq__lvq__init)(
-    PyObject * self,
-    PyObject * args,
-    PyObject * kwds)
-{
-    return wrap_X((int)1, liblvq__lvq__init, self, args, kwds);
+static void BINDING_IDENT(liblvq__train_job__destroy)(trainJobObject_t * py_job) {
+    wrap_X(0, liblvq__train_job__destroy, py_job);
 }
 /** \endcond */
 
 
 /**
- *  \brief  ml::lvq::set binding
+ *  \brief  Training progress
+ *
+ *  Returns list of (loop, dnorm2, div_cnt) tuples of training loops
+ *  finished since the last call (\c dnorm2 is the loop average squared
+ *  norm of prototype shifts, \c div_cnt diverging loops in a row count);
+ *  records are dropped if not polled for long.
  */
-static PyObject * liblvq__lvq__set(PyObject * self, PyObject * args) {
-    // Get arguments
-    PyObject * py_input;
-    size_t     cluster;
-    parse_args(args, "On", &py_input, &cluster);
-
-    const lvq_t::input_t input = python2input(py_input);
-
-    // Call implementation
-    python2lvq(self)->set(input, cluster);
-
-    // No return value
-    Py_INCREF(Py_None);
-    return Py_None;
-}
-
-BINDING_INST(liblvq__lvq__set)
+static PyObject * liblvq__train_job__progress(PyObject * self, PyObject * args) {
+    parse_args(args, "");
 
+    train_monitor & monitor = python2train_job(self)->monitor();
 
-/**
- *  \brief  ml::lvq::get binding
- */
-static PyObject * liblvq__lvq__get(PyObject * self, PyObject * args) {
-    // Get arguments
-    size_t cluster;
-    parse_args(args, "n", &cluster);
+    py_ref py_list(PyList_New(0));
+    if (NULL == py_list.get())
+        throw std::runtime_error("Failed to create list");
 
-    // Call implementation
-    const lvq_t::input_t & representant = python2lvq(self)->get(cluster);
+    train_progress progress;
+    while (monitor.pop(progress)) {
+        py_ref py_record(Py_BuildValue("(IdI)",
+            progress.tlc, progress.dnorm2, progress.div_cnt));
 
-    // Transform result
-    return input2python(representant);
+        if (NULL == py_record.get() ||
+            0 != PyList_Append(py_list.get(), py_record.get()))
+        {
+            throw std::runtime_error("Failed to add progress record");
+        }
+    }
+
+    return py_list.release();
 }
 
-BINDING_INST(liblvq__lvq__get)
+BINDING_INST(liblvq__train_job__progress)
 
 
 /**
- *  \brief  ml::lvq::set_random binding
+ *  \brief  Cancel training
+ *
+ *  Training stops after the current batch; prototypes trained so far
+ *  are stored only if \c keep is set.
  */
-static PyObject * liblvq__lvq__set_random(PyObject * self, PyObject * args) {
+static PyObject * liblvq__train_job__cancel(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
+{
     // Get arguments
-    size_t cluster = SIZE_MAX;
-    parse_args(args, "|n", &cluster);
+    static const char * kwlist[] = { "keep", NULL };
+
+    int keep = 0;
+    parse_args_kw(args, kwds, "|p", kwlist, &keep);
 
     // Call implementation
-    if (SIZE_MAX == cluster)
-        python2lvq(self)->set_random();
-    else
-        python2lvq(self)->set_random(cluster);
+    python2train_job(self)->cancel(keep);
 
-    // No return value
-    Py_INCREF(Py_None);
-    return Py_None;
+    Py_RETURN_NONE;
 }
 
-BINDING_INST(liblvq__lvq__set_random)
+BINDING_INST_KW(liblvq__train_job__cancel)
 
 
 /**
- *  \brief  \c ml::lvq::train1_supervised binding
+ *  \brief  Training finished
  */
-static PyObject * liblvq__lvq__train1_supervised(PyObject * self, PyObject * args) {
-    // Get arguments
-    PyObject *    py_input;
-    size_t        cluster;
-    lvq_t::base_t lfactor;
-    parse_args(args, "Ond", &py_input, &cluster, &lfactor);
-
-    const lvq_t::input_t input = python2input(py_input);
-
-    // Call implementation
-    lvq_t::base_t dnorm2 = python2lvq(self)->train1_supervised(input, cluster, lfactor);
+static PyObject * liblvq__train_job__done(PyObject * self, PyObject * args) {
+    parse_args(args, "");
 
-    // Transform result
-    return Py_BuildValue("d", dnorm2);
+    return PyBool_FromLong(python2train_job(self)->done());
 }
 
-BINDING_INST(liblvq__lvq__train1_supervised)
+BINDING_INST(liblvq__train_job__done)
 
 
 /**
- *  \brief  \c ml::lvq::train1_unsupervised binding
+ *  \brief  Wait for training (blocking, the GIL is released)
+ *
+ *  Returns \c True iff the training finished (within \c timeout seconds).
  */
-static PyObject * liblvq__lvq__train1_unsupervised(PyObject * self, PyObject * args) {
+static PyObject * liblvq__train_job__wait(PyObject * self, PyObject * args) {
     // Get arguments
-    PyObject *    py_input;
-    lvq_t::base_t lfactor;
-    parse_args(args, "Od", &py_input, &lfactor);
-
-    const lvq_t::input_t input = python2input(py_input);
+    PyObject * py_timeout = Py_None;
+    parse_args(args, "|O", &py_timeout);
+
+    double timeout = -1.0;
+    if (Py_None != py_timeout) {
+        timeout = PyFloat_AsDouble(py_timeout);
+        if (PyErr_Occurred() || timeout < 0.0) {
+            PyErr_Clear();
+            throw std::logic_error("Invalid timeout");
+        }
+    }
 
     // Call implementation
-    lvq_t::base_t dnorm2 = python2lvq(self)->train1_unsupervised(input, lfactor);
+    const bool done = python2train_job(self)->wait(timeout);
 
-    // Transform result
-    return Py_BuildValue("d", dnorm2);
+    return PyBool_FromLong(done);
 }
 
-BINDING_INST(liblvq__lvq__train1_unsupervised)
+BINDING_INST(liblvq__train_job__wait)
 
 
 /**
- *  \brief  \c ml::lvq::train_supervised binding
+ *  \brief  Resolve future by the job result
+ *
+ *  \param  self       Python training job object (finished)
+ *  \param  py_future  Future
+ *
+ *  \return Future method call result
  */
-static PyObject * liblvq__lvq__train_supervised(PyObject * self, PyObject * args) {
-    // Get arguments
-    PyObject * py_set;
-    unsigned   conv_win    = LIBLVQ__ML__LVQ__TRAIN__CONV_WIN;
-    unsigned   max_div_cnt = LIBLVQ__ML__LVQ__TRAIN__MAX_DIV_CNT;
-    unsigned   max_tlc     = LIBLVQ__ML__LVQ__TRAIN__MAX_TLC;
-    parse_args(args, "O|III", &py_set, &conv_win, &max_div_cnt, &max_tlc);
+static PyObject * train_job_resolve(PyObject * self, PyObject * py_future) {
+    PyObject * py_result;
+
+    try {
+        py_result = python2train_job(self)->result();
+    }
+    catch (std::exception & x) {
+        py_ref py_error(PyObject_CallFunction(
+            PyExc_RuntimeError, "s", x.what()));
 
-    const tset_classifier_t set = python2tset_classifier(py_set);
+        if (NULL == py_error.get()) return NULL;
 
-    // Call implementation
-    python2lvq(self)->train_supervised(set, conv_win, max_div_cnt, max_tlc);
+        return PyObject_CallMethod(
+            py_future, "set_exception", "O", py_error.get());
+    }
 
-    Py_INCREF(Py_None);
-    return Py_None;
-}
+    if (NULL == py_result) return NULL;
 
-BINDING_INST(liblvq__lvq__train_supervised)
+    py_ref py_res(py_result);
+
+    return PyObject_CallMethod(py_future, "set_result", "O", py_result);
+}
 
 
 /**
- *  \brief  \c ml::lvq::train_unsupervised binding
+ *  \brief  Training result future
+ *
+ *  Returns asyncio future (of the running event loop) resolved
+ *  on the training completion with dictionary of \c loops,
+ *  \c dnorm2 (the last loop), \c cancelled and \c stored items;
+ *  training failure is set as the future exception.
  */
-static PyObject * liblvq__lvq__train_unsupervised(PyObject * self, PyObject * args) {
-    // Get arguments
-    PyObject * py_set;
-    unsigned   conv_win    = LIBLVQ__ML__LVQ__TRAIN__CONV_WIN;
-    unsigned   max_div_cnt = LIBLVQ__ML__LVQ__TRAIN__MAX_DIV_CNT;
-    unsigned   max_tlc     = LIBLVQ__ML__LVQ__TRAIN__MAX_TLC;
-    parse_args(args, "O|III", &py_set, &conv_win, &max_div_cnt, &max_tlc);
+static PyObject * liblvq__train_job__result(PyObject * self, PyObject * args) {
+    parse_args(args, "");
 
-    const tset_clustering_t set = python2tset_clustering(py_set);
+    py_ref py_asyncio(PyImport_ImportModule("asyncio"));
+    if (NULL == py_asyncio.get()) return NULL;
 
-    // Call implementation
-    python2lvq(self)->train_unsupervised(set, conv_win, max_div_cnt, max_tlc);
+    py_ref py_loop(PyObject_CallMethod(
+        py_asyncio.get(), "get_running_loop", NULL));
 
-    Py_INCREF(Py_None);
-    return Py_None;
+    if (NULL == py_loop.get()) return NULL;  // no running loop
+
+    py_ref py_future(PyObject_CallMethod(py_loop.get(), "create_future", NULL));
+    if (NULL == py_future.get()) return NULL;
+
+    if (!python2train_job(self)->add_waiter(py_loop.get(), py_future.get())) {
+        py_ref py_res(train_job_resolve(self, py_future.get()));
+        if (NULL == py_res.get()) return NULL;
+    }
+
+    return py_future.release();
 }
 
-BINDING_INST(liblvq__lvq__train_unsupervised)
+BINDING_INST(liblvq__train_job__result)
 
 
 /**
- *  \brief  \c ml::lvq::classify binding
+ *  \brief  Resolve future by the job result (event loop callback)
  */
-static PyObject * liblvq__lvq__classify(PyObject * self, PyObject * args) {
+static PyObject * liblvq__train_job__resolve(PyObject * self, PyObject * args) {
     // Get arguments
-    PyObject * py_input;
-    parse_args(args, "O", &py_input);
+    PyObject * py_future;
+    parse_args(args, "O", &py_future);
 
-    const lvq_t::input_t input = python2input(py_input);
+    // Cancelled futures are done
+    py_ref py_done(PyObject_CallMethod(py_future, "done", NULL));
+    if (NULL == py_done.get()) return NULL;
 
-    // Call implementation
-    size_t cluster = python2lvq(self)->classify(input);
+    if (!PyObject_IsTrue(py_done.get())) {
+        py_ref py_res(train_job_resolve(self, py_future));
+        if (NULL == py_res.get()) return NULL;
+    }
 
-    // Transform result
-    return Py_BuildValue("n", cluster);
+    Py_RETURN_NONE;
 }
 
-BINDING_INST(liblvq__lvq__classify)
+BINDING_INST(liblvq__train_job__resolve)
 
 
+//
+// Training set binding
+//
+
 /**
- *  \brief  \c ml::lvq::classify_weight binding
+ *  \brief  Create training set from Python data
+ *
+ *  \param  py_set     Matrix buffer, sequence of samples or file path
+ *  \param  py_labels  Labels (or \c None)
+ *  \param  cache      Cache converted \c lvq_t training sets
+ *
+ *  \return Training set
  */
-static PyObject * liblvq__lvq__classify_weight(
-    PyObject * self,
-    PyObject * args)
+static std::unique_ptr<tset_arena> new_tset_arena(
+    PyObject * py_set,
+    PyObject * py_labels,
+    bool       cache)
 {
-    // Get arguments
-    PyObject * py_input;
-    parse_args(args, "O", &py_input);
+    std::vector<int64_t> labels;
+    if (Py_None != py_labels) python2labels(py_labels, labels);
 
-    const lvq_t::input_t input = python2input(py_input);
+    const std::vector<int64_t> * labels_ptr =
+        Py_None != py_labels ? &labels : NULL;
 
-    // Call implementation
-    std::vector<double> weight = python2lvq(self)->classify_weight(input);
+    std::unique_ptr<tset_arena> set;
+    std::string                 path;
 
-    // Transform result
-    return weight2python(weight);
-}
+    if (python2path(py_set, path)) {
+        if (NULL != labels_ptr)
+            throw std::logic_error("Labels are taken from training set file");
 
-BINDING_INST(liblvq__lvq__classify_weight)
+        gil_release nogil;
+        tset_file file(path);
 
+        set.reset(new tset_arena(
+            file.dimension(), file.labelled(), file.size(), cache));
 
-/**
- *  \brief  ml::lvq::best binding
- */
-static PyObject * liblvq__lvq__best(PyObject * self, PyObject * args) {
-    // Get arguments
-    PyObject * py_weight;
-    size_t n;
-    parse_args(args, "On", &py_weight, &n);
+        for (size_t i = 0; i < file.size(); ++i)
+            set->add(file.row(i), file.labelled() ? file.labels()[i] : 0);
+    }
+    else if (PyObject_CheckBuffer(py_set)) {
+        buffer_view matrix(py_set);
+        check_input_matrix(matrix, matrix.cols());
 
-    const std::vector<double> weight = python2weight(py_weight);
+        if (NULL != labels_ptr && labels.size() != matrix.rows())
+            throw std::logic_error("Invalid labels (sample count mismatch)");
 
-    // Call implementation
-    const std::vector<lvq_t::cw_t> cw_vec = lvq_t::best(weight, n);
+        gil_release nogil;
 
-    // Transform result
-    return cw_vec2python(cw_vec);
-}
+        set.reset(new tset_arena(
+            matrix.cols(), NULL != labels_ptr, matrix.rows(), cache));
+        matrix2tset(*set, matrix, labels_ptr);
+    }
+    else {
+        sequence2tset(set,
+            [cache](size_t dim, bool labelled, size_t size) {
+                return new tset_arena(dim, labelled, size, cache);
+            },
+            py_set, labels_ptr);
+    }
 
-BINDING_INST(liblvq__lvq__best)
+    set->close();
+
+    return set;
+}
 
 
 /**
- *  \brief  \c ml::lvq::classify_best binding
+ *  \brief  Training set constructor
+ *
+ *  \c set is either a 2-D float64/float32 matrix buffer (NaN stands for
+ *  undefined value), a sequence of inputs or (input, cluster) tuples
+ *  (just like training sets of \c train_* functions) or a binary
+ *  training set file path (see \ref write_tset).
+ *  Labels may also be given separately (1-D int64 buffer or iterable).
+ *  The samples are converted once; the set is immutable.
+ *  Sequential training converts the samples to \c ml::lvq training sets;
+ *  these are kept with the set (converted on first use) unless
+ *  \c cache_liblvq is \c False (which saves memory).
+ *
+ *  \param  type  Python training set type
+ *  \param  args  Arguments
+ *  \param  kwds  Keywords
+ *
+ *  \return Training set instance
  */
-static PyObject * liblvq__lvq__classify_best(PyObject * self, PyObject * args) {
+static PyObject * liblvq__training_set__new(
+    PyTypeObject * type,
+    PyObject     * args,
+    PyObject     * kwds)
+{
     // Get arguments
-    PyObject * py_input;
-    size_t     n;
-    parse_args(args, "On", &py_input, &n);
+    static const char * kwlist[] = { "set", "labels", "cache_liblvq", NULL };
 
-    const lvq_t::input_t input = python2input(py_input);
+    PyObject * py_set;
+    PyObject * py_labels    = Py_None;
+    int        cache_liblvq = 1;
+    parse_args_kw(args, kwds, "O|Op", kwlist, &py_set, &py_labels, &cache_liblvq);
 
-    // Call implementation
-    std::vector<lvq_t::cw_t> cw_vec = python2lvq(self)->classify_best(input, n);
+    std::unique_ptr<tset_arena> set =
+        new_tset_arena(py_set, py_labels, 0 != cache_liblvq);
 
-    // Transform result
-    return cw_vec2python(cw_vec);
+    PyObject * py_tset = type->tp_alloc(type, 0);
+    if (NULL == py_tset) return NULL;
+
+    python2tset_arena(py_tset) = set.release();
+
+    return py_tset;
 }
 
-BINDING_INST(liblvq__lvq__classify_best)
+/** \cond */
+static PyObject * BINDING_IDENT(liblvq__training_set__new)(
+    PyTypeObject * type,
+    PyObject     * args,
+    PyObject     * kwds)
+{
+    return wrap_X((PyObject *)NULL, liblvq__training_set__new, type, args, kwds);
+}
+/** \endcond */
 
 
 /**
- *  \brief  \c ml::lvq::weight_threshold binding
+ *  \brief  Training set destructor
+ *
+ *  \param  py_tset  Python training set object
+ *
+ *  \return 0
  */
-static PyObject * liblvq__lvq__weight_threshold(
-    PyObject * self,
-    PyObject * args)
-{
-    PyObject * py_weight;
-    double     wthres;
-    parse_args(args, "Od", &py_weight, &wthres);
+static int liblvq__training_set__destroy(trainingSetObject_t * py_tset) {
+    tset_arena * set = py_tset->tset;
+    py_tset->tset = NULL;
 
-    const std::vector<double> weight = python2weight(py_weight);
+    if (NULL != set) delete set;
 
-    // Call implementation
-    const std::vector<lvq_t::cw_t> cw_vec =
-        lvq_t::weight_threshold(weight, wthres);
+    Py_TYPE(py_tset)->tp_free(reinterpret_cast<PyObject *>(py_tset));
 
-    // Transform result
-    return cw_vec2python(cw_vec);
+    return 0;
 }
 
-BINDING_INST(liblvq__lvq__weight_threshold)
+/** \cond */
+static void BINDING_IDENT(liblvq__training_set__destroy)(
+    trainingSetObject_t * py_tset)
+{
+    wrap_X(0, liblvq__training_set__destroy, py_tset);
+}
+/** \endcond */
 
 
 /**
- *  \brief  \c ml::lvq::classify_weight_threshold binding
+ *  \brief  Training set dimension
  */
-static PyObject * liblvq__lvq__classify_weight_threshold(
-    PyObject * self,
-    PyObject * args)
-{
-    // Get arguments
-    PyObject * py_input;
-    double     wthres;
-    parse_args(args, "Od", &py_input, &wthres);
-
-    const lvq_t::input_t input = python2input(py_input);
-
-    // Call implementation
-    std::vector<lvq_t::cw_t> cw_vec =
-        python2lvq(self)->classify_weight_threshold(input, wthres);
+static PyObject * liblvq__training_set__dimension(PyObject * self, PyObject * args) {
+    parse_args(args, "");
 
-    // Transform result
-    return cw_vec2python(cw_vec);
+    return Py_BuildValue("n", python2tset_arena(self)->dimension());
 }
 
-BINDING_INST(liblvq__lvq__classify_weight_threshold)
+BINDING_INST(liblvq__training_set__dimension)
 
 
 /**
- *  \brief  \c ml::lvq::test_classifier binding
+ *  \brief  Training set sample count
  */
-static PyObject * liblvq__lvq__test_classifier(PyObject * self, PyObject * args) {
-    PyTypeObject * lvq_stats_type = get_lvqClassifierStatisticsType();
-
-    lvqClassifierStatisticsObject_t * py_lvq_stats =
-        reinterpret_cast<lvqClassifierStatisticsObject_t *>(
-            lvq_stats_type->tp_alloc(lvq_stats_type, 0));
+static PyObject * liblvq__training_set__size(PyObject * self, PyObject * args) {
+    parse_args(args, "");
 
-    if (NULL == py_lvq_stats) return NULL;
+    return Py_BuildValue("n", python2tset_arena(self)->size());
+}
 
-    // Get arguments
-    PyObject * py_set;
-    parse_args(args, "O", &py_set);
+BINDING_INST(liblvq__training_set__size)
 
-    const tset_classifier_t set = python2tset_classifier(py_set);
 
-    // Call implementation
-    py_lvq_stats->lvq_stats = new lvq_classifier_stats_t(
-        python2lvq(self)->test_classifier(set));
+/**
+ *  \brief  Training set samples are labelled
+ */
+static PyObject * liblvq__training_set__labelled(PyObject * self, PyObject * args) {
+    parse_args(args, "");
 
-    // Transform result
-    return reinterpret_cast<PyObject *>(py_lvq_stats);
+    return PyBool_FromLong(python2tset_arena(self)->labelled());
 }
 
-BINDING_INST(liblvq__lvq__test_classifier)
+BINDING_INST(liblvq__training_set__labelled)
 
 
 /**
- *  \brief  \c ml::lvq::test_clustering binding
+ *  \brief  Training set undefined values count
  */
-static PyObject * liblvq__lvq__test_clustering(PyObject * self, PyObject * args) {
-    PyTypeObject * lvq_stats_type = get_lvqClusteringStatisticsType();
+static PyObject * liblvq__training_set__undefined_count(
+    PyObject * self, PyObject * args)
+{
+    parse_args(args, "");
 
-    lvqClusteringStatisticsObject_t * py_lvq_stats =
-        reinterpret_cast<lvqClusteringStatisticsObject_t *>(
-            lvq_stats_type->tp_alloc(lvq_stats_type, 0));
+    return Py_BuildValue("n", python2tset_arena(self)->undefined_count());
+}
 
-    if (NULL == py_lvq_stats) return NULL;
+BINDING_INST(liblvq__training_set__undefined_count)
 
-    // Get arguments
-    PyObject * py_set;
-    parse_args(args, "O", &py_set);
 
-    const tset_clustering_t set = python2tset_clustering(py_set);
+/**
+ *  \brief  Training set sample matrix
+ *
+ *  Returns read-only 2-D float64 \c memoryview of the samples
+ *  (NaN stands for undefined value); no copy is made.
+ */
+static PyObject * liblvq__training_set__matrix(PyObject * self, PyObject * args) {
+    parse_args(args, "");
 
-    // Call implementation
-    py_lvq_stats->lvq_stats = new lvq_clustering_stats_t(
-        python2lvq(self)->test_clustering(set));
+    const tset_arena & set = *python2tset_arena(self);
 
-    // Transform result
-    return reinterpret_cast<PyObject *>(py_lvq_stats);
+    return new_export(self,
+        &reinterpret_cast<trainingSetObject_t *>(self)->exports,
+        set.matrix(), "d", sizeof(double),
+        set.size(), set.dimension(), true);
 }
 
-BINDING_INST(liblvq__lvq__test_clustering)
+BINDING_INST(liblvq__training_set__matrix)
 
 
 /**
- *  \brief  \c ml::lvq::store binding
+ *  \brief  Training set labels
+ *
+ *  Returns read-only 1-D int64 \c memoryview of the labels
+ *  (or \c None for unlabelled sets); no copy is made.
  */
-static PyObject * liblvq__lvq__store(PyObject * self, PyObject * args) {
-    // Get arguments
-    const char * file;
-    parse_args(args, "s", &file);
+static PyObject * liblvq__training_set__labels(PyObject * self, PyObject * args) {
+    parse_args(args, "");
 
-    // Call implementation
-    python2lvq(self)->store(file);
+    const tset_arena & set = *python2tset_arena(self);
 
-    Py_INCREF(Py_None);
-    return Py_None;
+    if (!set.labelled()) Py_RETURN_NONE;
+
+    return new_export(self,
+        &reinterpret_cast<trainingSetObject_t *>(self)->exports,
+        set.labels(), "q", sizeof(int64_t),
+        set.size(), 0, true);
 }
 
-BINDING_INST(liblvq__lvq__store)
+BINDING_INST(liblvq__training_set__labels)
 
 
 /**
- *  \brief  \c ml::lvq::load binding
+ *  \brief  Training set undefined values mask
+ *
+ *  Returns read-only 2-D uint64 \c memoryview of the mask
+ *  (a row of \c ceil(dimension/64) words per sample, bit \c j
+ *  of word \c j/64 set iff value \c j is undefined); no copy is made.
  */
-static PyObject * liblvq__lvq__load(PyObject * type, PyObject * args) {
-    lvqObject_t * py_lvq = reinterpret_cast<lvqObject_t *>(
-        ((PyTypeObject *)type)->tp_alloc((PyTypeObject *)type, 0));
-
-    if (NULL == py_lvq) return NULL;
-
-    // Get arguments
-    const char * file;
-    parse_args(args, "s", &file);
-
-    // Create dummy ml::lvq instance
-    py_lvq->lvq = new lvq_t(0, 0);
+static PyObject * liblvq__training_set__undefined_mask(
+    PyObject * self, PyObject * args)
+{
+    parse_args(args, "");
 
-    // Call implementation
-    *py_lvq->lvq = lvq_t::load(file);
+    const tset_arena & set = *python2tset_arena(self);
 
-    return reinterpret_cast<PyObject *>(py_lvq);
+    return new_export(self,
+        &reinterpret_cast<trainingSetObject_t *>(self)->exports,
+        set.mask(), "Q", sizeof(uint64_t),
+        set.size(), set.mask_words(), true);
 }
 
-BINDING_INST(liblvq__lvq__load)
+BINDING_INST(liblvq__training_set__undefined_mask)
 
 
 //
-// ml::lvq::classifier_statistics member functions binding
+// Model snapshot binding
 //
 
+/** Model snapshot Python object */
+typedef struct {
+    PyObject_HEAD
+    lvq_snapshot_ptr * snapshot;
+    PyObject *         py_lvq;   /**< LVQ object the snapshot was made of */
+    Py_ssize_t         exports;  /**< Prototype buffer exports            */
+} snapshotObject_t;
+
+/** Model snapshot object access */
+#define python2snapshot(self) \
+    (**(reinterpret_cast<snapshotObject_t *>(self))->snapshot)
+
+/** Model snapshot LVQ object access */
+#define python2snapshot_lvq(self) \
+    ((reinterpret_cast<snapshotObject_t *>(self))->py_lvq)
+
+
 /**
- *  \brief  Constructor
+ *  \brief  Model snapshot binding
  *
- *  \param  type  Python LVQ classifier statistics type
- *  \param  args  Arguments
- *  \param  kwds  Keywords
- *
- *  \return LVQ instance
+ *  Returns immutable snapshot of the latest published model (see
+ *  \ref snapshot_acquire); it isn't affected by further training
+ *  and its readers never wait for the model lock.
  */
-static PyObject * liblvq__lvq__classifier_statistics__new(
-    PyTypeObject * type,
-    PyObject     * args,
-    PyObject     * kwds)
-{
-    lvqClassifierStatisticsObject_t * py_lvq_stats =
-        reinterpret_cast<lvqClassifierStatisticsObject_t *>(type->tp_alloc(type, 0));
+static PyObject * liblvq__lvq__snapshot(PyObject * self, PyObject * args) {
+    parse_args(args, "");
 
-    if (NULL == py_lvq_stats) return NULL;
+    const lvq_snapshot_ptr snapshot = snapshot_acquire(self);
 
-    liblvq__lvq__classifier_statistics__create(py_lvq_stats, args, kwds);
+    PyTypeObject * snapshot_type = get_snapshotType();
 
-    return reinterpret_cast<PyObject *>(py_lvq_stats);
-}
+    py_ref py_snapshot(snapshot_type->tp_alloc(snapshot_type, 0));
+    if (NULL == py_snapshot.get()) return NULL;
 
-/** \cond */
-static PyObject * BINDING_IDENT(liblvq__lvq__classifier_statistics__new)(
-    PyTypeObject * type,
-    PyObject     * args,
-    PyObject     * kwds)
-{
-    return wrap_X((PyObject *)NULL, liblvq__lvq__classifier_statistics__new, type, args, kwds);
+    snapshotObject_t * py_snap =
+        reinterpret_cast<snapshotObject_t *>(py_snapshot.get());
+
+    py_snap->snapshot = new lvq_snapshot_ptr(snapshot);
+
+    Py_INCREF(self);
+    py_snap->py_lvq = self;
+
+    return py_snapshot.release();
 }
-/** \endcond */
+
+BINDING_INST(liblvq__lvq__snapshot)
 
 
 /**
- *  \brief  Constructor (__init__)
+ *  \brief  Model snapshot destructor
  *
- *  \param  self  Python LQV classifier statistics object
- *  \param  args  Arguments
- *  \param  kwds  Keywords
+ *  \param  py_snapshot  Python model snapshot object
  *
  *  \return 0
  */
-static int liblvq__lvq__classifier_statistics__init(
-    PyObject * self,
-    PyObject * args,
-    PyObject * kwds)
-{
-    lvqClassifierStatisticsObject_t * py_lvq_stats =
-        reinterpret_cast<lvqClassifierStatisticsObject_t *>(self);
+static int liblvq__snapshot__destroy(snapshotObject_t * py_snapshot) {
+    lvq_snapshot_ptr * snapshot = py_snapshot->snapshot;
+    py_snapshot->snapshot = NULL;
 
-    liblvq__lvq__classifier_statistics__destroy(py_lvq_stats);
+    if (NULL != snapshot) delete snapshot;
 
-    liblvq__lvq__classifier_statistics__create(py_lvq_stats, args, kwds);
+    Py_XDECREF(py_snapshot->py_lvq);
+
+    Py_TYPE(py_snapshot)->tp_free(reinterpret_cast<PyObject *>(py_snapshot));
 
     return 0;
 }
 
 /** \cond */
-static int BINDING_IDENT(liblvq__lvq__classifier_statistics__init)(
-    PyObject * self,
-    PyObject * args,
-    PyObject * kwds)
+static void BINDING_IDENT(liblvq__snapshot__destroy)(
+    snapshotObject_t * py_snapshot)
 {
-    return wrap_X((int)1, liblvq__lvq__classifier_statistics__init, self, args, kwds);
+    wrap_X(0, liblvq__snapshot__destroy, py_snapshot);
 }
 /** \endcond */
 
 
 /**
- *  \brief  ml::lvq::classifier_statistics::accuracy binding
+ *  \brief  Model snapshot version
+ *
+ *  Model versions grow with every modification.
  */
-static PyObject * liblvq__lvq__classifier_statistics__accuracy(
-    PyObject * self, PyObject * args)
-{
-    // Call implementation
-    double accuracy = python2lvq_classifier_stats(self)->accuracy();
+static PyObject * liblvq__snapshot__version(PyObject * self, PyObject * args) {
+    parse_args(args, "");
 
-    // Transform result
-    return Py_BuildValue("d", accuracy);
+    return PyLong_FromUnsignedLongLong(python2snapshot(self).version());
 }
 
-BINDING_INST(liblvq__lvq__classifier_statistics__accuracy)
+BINDING_INST(liblvq__snapshot__version)
 
 
 /**
- *  \brief  ml::lvq::classifier_statistics::precision binding
+ *  \brief  Model snapshot dimension
  */
-static PyObject * liblvq__lvq__classifier_statistics__precision(
-    PyObject * self, PyObject * args)
-{
-    // Get arguments
-    int c1ass;
-    parse_args(args, "I", &c1ass);
-
-    // Call implementation
-    double precision = python2lvq_classifier_stats(self)->precision(c1ass);
+static PyObject * liblvq__snapshot__dimension(PyObject * self, PyObject * args) {
+    parse_args(args, "");
 
-    // Transform result
-    return Py_BuildValue("d", precision);
+    return Py_BuildValue("n", python2snapshot(self).dimension());
 }
 
-BINDING_INST(liblvq__lvq__classifier_statistics__precision)
+BINDING_INST(liblvq__snapshot__dimension)
 
 
 /**
- *  \brief  ml::lvq::classifier_statistics::recall binding
+ *  \brief  Model snapshot clusters count
  */
-static PyObject * liblvq__lvq__classifier_statistics__recall(
-    PyObject * self, PyObject * args)
-{
-    // Get arguments
-    int c1ass;
-    parse_args(args, "I", &c1ass);
+static PyObject * liblvq__snapshot__clusters(PyObject * self, PyObject * args) {
+    parse_args(args, "");
 
-    // Call implementation
-    double recall = python2lvq_classifier_stats(self)->recall(c1ass);
-
-    // Transform result
-    return Py_BuildValue("d", recall);
+    return Py_BuildValue("n", python2snapshot(self).clusters());
 }
 
-BINDING_INST(liblvq__lvq__classifier_statistics__recall)
+BINDING_INST(liblvq__snapshot__clusters)
 
 
 /**
- *  \brief  ml::lvq::classifier_statistics::F(beta) binding
+ *  \brief  Model snapshot prototype
  */
-static PyObject * liblvq__lvq__classifier_statistics__F_beta(
-    PyObject * self, PyObject * args)
-{
-    // Get arguments
-    double beta;
-    int    c1ass = -1;
-    parse_args(args, "d|I", &beta, &c1ass);
+static PyObject * liblvq__snapshot__get(PyObject * self, PyObject * args) {
+    size_t cluster;
+    parse_args(args, "n", &cluster);
 
-    // Call implementation
-    double F_beta = c1ass < 0
-        ? python2lvq_classifier_stats(self)->F(beta)
-        : python2lvq_classifier_stats(self)->F(beta, (size_t)c1ass);
+    const lvq_t & lvq = python2snapshot(self).lvq();
 
-    // Transform result
-    return Py_BuildValue("d", F_beta);
+    if (!(cluster < lvq.clusters()))
+        throw std::logic_error("Invalid cluster");
+
+    return input2python(lvq.get(cluster));
 }
 
-BINDING_INST(liblvq__lvq__classifier_statistics__F_beta)
+BINDING_INST(liblvq__snapshot__get)
 
 
 /**
- *  \brief  ml::lvq::classifier_statistics::F binding
+ *  \brief  Model snapshot prototype matrix
+ *
+ *  Returns read-only clusters x dimension \c memoryview of the prototypes
+ *  (NaN stands for undefined value); see \c lvq.prototypes.
+ *  Complete dense prototypes are exported in place.
  */
-static PyObject * liblvq__lvq__classifier_statistics__F(
-    PyObject * self, PyObject * args)
-{
-    // Get arguments
-    int c1ass = -1;
-    parse_args(args, "|I", &c1ass);
-
-    // Call implementation
-    double F = c1ass < 0
-        ? python2lvq_classifier_stats(self)->F()
-        : python2lvq_classifier_stats(self)->F((size_t)c1ass);
+static PyObject * liblvq__snapshot__prototypes(PyObject * self, PyObject * args) {
+    parse_args(args, "");
 
-    // Transform result
-    return Py_BuildValue("d", F);
-}
+    const lvq_snapshot & snapshot = python2snapshot(self);
+    Py_ssize_t * exports = &reinterpret_cast<snapshotObject_t *>(self)->exports;
 
-BINDING_INST(liblvq__lvq__classifier_statistics__F)
+    // In place export (the snapshot is immutable)
+    const dense_codebook * dense = snapshot.dense();
 
+    if (NULL != dense && dense->complete())
+        return exporter2view(new_exporter(self, exports,
+            dense->data(), sizeof(float) == dense->itemsize() ? "f" : "d",
+            dense->itemsize(), dense->clusters(), dense->dimension(),
+            dense->stride(), true));
 
-//
-// ml::lvq::clustering_statistics member functions binding
-//
+    // Copy
+    const lvq_t & lvq = snapshot.lvq();
+    const size_t  ccnt = lvq.clusters();
+    const size_t  dim  = lvq.dimension();
 
-/**
- *  \brief  Constructor
- *
- *  \param  type  Python LVQ clustering statistics type
- *  \param  args  Arguments
- *  \param  kwds  Keywords
- *
- *  \return LVQ instance
- */
-static PyObject * liblvq__lvq__clustering_statistics__new(
-    PyTypeObject * type,
-    PyObject     * args,
-    PyObject     * kwds)
-{
-    lvqClusteringStatisticsObject_t * py_lvq_stats =
-        reinterpret_cast<lvqClusteringStatisticsObject_t *>(type->tp_alloc(type, 0));
+    bufferExporterObject_t * exporter = new_exporter(self, exports,
+        NULL, "d", sizeof(double), ccnt, dim, dim, true);
 
-    if (NULL == py_lvq_stats) return NULL;
+    double * rows = static_cast<double *>(exporter->data);
 
-    liblvq__lvq__clustering_statistics__create(py_lvq_stats, args, kwds);
+    for (size_t c = 0; c < ccnt; ++c)
+        input2dense(lvq.get(c), rows + c * dim);
 
-    return reinterpret_cast<PyObject *>(py_lvq_stats);
+    return exporter2view(exporter);
 }
 
-/** \cond */
-static PyObject * BINDING_IDENT(liblvq__lvq__clustering_statistics__new)(
-    PyTypeObject * type,
-    PyObject     * args,
-    PyObject     * kwds)
-{
-    return wrap_X((PyObject *)NULL, liblvq__lvq__clustering_statistics__new, type, args, kwds);
-}
-/** \endcond */
+BINDING_INST(liblvq__snapshot__prototypes)
 
 
 /**
- *  \brief  Constructor (__init__)
- *
- *  \param  self  Python LQV clustering statistics object
- *  \param  args  Arguments
- *  \param  kwds  Keywords
+ *  \brief  Model snapshot classification
  *
- *  \return 0
+ *  See \c lvq.classify.
  */
-static int liblvq__lvq__clustering_statistics__init(
-    PyObject * self,
-    PyObject * args,
-    PyObject * kwds)
-{
-    lvqClusteringStatisticsObject_t * py_lvq_stats =
-        reinterpret_cast<lvqClusteringStatisticsObject_t *>(self);
-
-    liblvq__lvq__clustering_statistics__destroy(py_lvq_stats);
+static PyObject * liblvq__snapshot__classify(PyObject * self, PyObject * args) {
+    PyObject * py_input;
+    parse_args(args, "O", &py_input);
 
-    liblvq__lvq__clustering_statistics__create(py_lvq_stats, args, kwds);
+    const size_t cluster = snapshot_classify(
+        python2snapshot_lvq(self), &python2snapshot(self), py_input);
 
-    return 0;
+    return Py_BuildValue("n", cluster);
 }
 
-/** \cond */
-static int BINDING_IDENT(liblvq__lvq__clustering_statistics__init)(
-    PyObject * self,
-    PyObject * args,
-    PyObject * kwds)
-{
-    return wrap_X((int)1, liblvq__lvq__clustering_statistics__init, self, args, kwds);
-}
-/** \endcond */
+BINDING_INST(liblvq__snapshot__classify)
 
 
 /**
- *  \brief  ml::lvq::clustering_statistics::avg_error binding
+ *  \brief  Model snapshot batch classification
+ *
+ *  See \c lvq.classify_batch.
  */
-static PyObject * liblvq__lvq__clustering_statistics__avg_error(
-    PyObject * self, PyObject * args)
+static PyObject * liblvq__snapshot__classify_batch(
+    PyObject * self,
+    PyObject * args,
+    PyObject * kwds)
 {
-    // Get arguments
-    int    c1ass = -1;
-    parse_args(args, "|I", &c1ass);
+    static const char * kwlist[] = { "matrix", "out", NULL };
 
-    // Call implementation
-    double avg_error = c1ass < 0
-        ? python2lvq_clustering_stats(self)->avg_error()
-        : python2lvq_clustering_stats(self)->avg_error(c1ass);
+    PyObject * py_matrix;
+    PyObject * py_out = Py_None;
+    parse_args_kw(args, kwds, "O|O", kwlist, &py_matrix, &py_out);
 
-    // Transform result
-    return Py_BuildValue("d", avg_error);
+    return snapshot_classify_batch(
+        python2snapshot_lvq(self), &python2snapshot(self), py_matrix, py_out);
 }
 
-BINDING_INST(liblvq__lvq__clustering_statistics__avg_error)
+BINDING_INST_KW(liblvq__snapshot__classify_batch)
 
 
 //
@@ -1333,12 +11718,36 @@ static PyMethodDef lvqObject_methods[] = {
         METH_VARARGS,
         "Get cluster representant"
     },
+    {
+        "prototypes",
+        (PyCFunction)BINDING_IDENT(liblvq__lvq__prototypes),
+        METH_VARARGS | METH_KEYWORDS,
+        "Get prototype matrix (memoryview; writable copy is committed by set_prototypes)"
+    },
+    {
+        "set_prototypes",
+        BINDING_IDENT(liblvq__lvq__set_prototypes),
+        METH_VARARGS,
+        "Set all cluster representants from matrix"
+    },
+    {
+        "snapshot",
+        BINDING_IDENT(liblvq__lvq__snapshot),
+        METH_VARARGS,
+        "Get immutable model snapshot"
+    },
     {
         "set_random",
         BINDING_IDENT(liblvq__lvq__set_random),
         METH_VARARGS,
         "Set cluster representant(s) randomly"
     },
+    {
+        "set_from_data",
+        (PyCFunction)BINDING_IDENT(liblvq__lvq__set_from_data),
+        METH_VARARGS | METH_KEYWORDS,
+        "Set cluster representants from data (k-means++, k-means||, stratified)"
+    },
     {
         "train1_supervised",
         BINDING_IDENT(liblvq__lvq__train1_supervised),
@@ -1346,28 +11755,124 @@ static PyMethodDef lvqObject_methods[] = {
         "Supervised training step"
     },
     {
-        "train1_unsupervised",
-        BINDING_IDENT(liblvq__lvq__train1_unsupervised),
-        METH_VARARGS,
-        "Unsupervised training step"
+        "train1_unsupervised",
+        BINDING_IDENT(liblvq__lvq__train1_unsupervised),
+        METH_VARARGS,
+        "Unsupervised training step"
+    },
+    {
+        "train1_supervised_batch",
+        (PyCFunction)BINDING_IDENT(liblvq__lvq__train1_supervised_batch),
+        METH_VARARGS | METH_KEYWORDS,
+        "Supervised training steps on sample matrix rows (scheduled)"
+    },
+    {
+        "train1_unsupervised_batch",
+        (PyCFunction)BINDING_IDENT(liblvq__lvq__train1_unsupervised_batch),
+        METH_VARARGS | METH_KEYWORDS,
+        "Unsupervised training steps on sample matrix rows (scheduled)"
+    },
+    {
+        "train_supervised",
+        (PyCFunction)BINDING_IDENT(liblvq__lvq__train_supervised),
+        METH_VARARGS | METH_KEYWORDS,
+        "Train LVQ model (supervised training)"
+    },
+    {
+        "train_unsupervised",
+        (PyCFunction)BINDING_IDENT(liblvq__lvq__train_unsupervised),
+        METH_VARARGS | METH_KEYWORDS,
+        "Train LVQ model (unsupervised training)"
+    },
+    {
+        "train_async",
+        (PyCFunction)BINDING_IDENT(liblvq__lvq__train_async),
+        METH_VARARGS | METH_KEYWORDS,
+        "Start asynchronous training, return training job"
+    },
+    {
+        "train_supervised_stream",
+        (PyCFunction)BINDING_IDENT(liblvq__lvq__train_supervised_stream),
+        METH_VARARGS | METH_KEYWORDS,
+        "Train LVQ model online from samples iterable (supervised)"
+    },
+    {
+        "train_unsupervised_stream",
+        (PyCFunction)BINDING_IDENT(liblvq__lvq__train_unsupervised_stream),
+        METH_VARARGS | METH_KEYWORDS,
+        "Train LVQ model online from samples iterable (unsupervised)"
+    },
+    {
+        "classify",
+        BINDING_IDENT(liblvq__lvq__classify),
+        METH_VARARGS,
+        "n-ary classification"
+    },
+    {
+        "build_index",
+        (PyCFunction)BINDING_IDENT(liblvq__lvq__build_index),
+        METH_VARARGS | METH_KEYWORDS,
+        "Build approximate nearest prototype index (used by classify, classify_best)"
+    },
+    {
+        "drop_index",
+        BINDING_IDENT(liblvq__lvq__drop_index),
+        METH_VARARGS,
+        "Drop nearest prototype index"
+    },
+    {
+        "set_index_nprobe",
+        BINDING_IDENT(liblvq__lvq__set_index_nprobe),
+        METH_VARARGS,
+        "Set index lists probed by queries"
+    },
+    {
+        "index_info",
+        BINDING_IDENT(liblvq__lvq__index_info),
+        METH_VARARGS,
+        "Index parameters (or None)"
+    },
+    {
+        "set_pruning",
+        (PyCFunction)BINDING_IDENT(liblvq__lvq__set_pruning),
+        METH_VARARGS | METH_KEYWORDS,
+        "Set exact nearest prototype search pruning"
+    },
+    {
+        "pruning_stats",
+        (PyCFunction)BINDING_IDENT(liblvq__lvq__pruning_stats),
+        METH_VARARGS | METH_KEYWORDS,
+        "Nearest prototype search counters"
+    },
+    {
+        "classify_batch",
+        (PyCFunction)BINDING_IDENT(liblvq__lvq__classify_batch),
+        METH_VARARGS | METH_KEYWORDS,
+        "n-ary classification of matrix rows"
     },
     {
-        "train_supervised",
-        BINDING_IDENT(liblvq__lvq__train_supervised),
+        "classify_async",
+        BINDING_IDENT(liblvq__lvq__classify_async),
         METH_VARARGS,
-        "Train LVQ model (supervised training)"
+        "Classification (asyncio future, micro-batched)"
     },
     {
-        "train_unsupervised",
-        BINDING_IDENT(liblvq__lvq__train_unsupervised),
-        METH_VARARGS,
-        "Train LVQ model (unsupervised training)"
+        "set_async_batching",
+        (PyCFunction)BINDING_IDENT(liblvq__lvq__set_async_batching),
+        METH_VARARGS | METH_KEYWORDS,
+        "Set asynchronous classification batching parameters"
     },
     {
-        "classify",
-        BINDING_IDENT(liblvq__lvq__classify),
+        "classify_weight_batch",
+        (PyCFunction)BINDING_IDENT(liblvq__lvq__classify_weight_batch),
+        METH_VARARGS | METH_KEYWORDS,
+        "Classification weights of matrix rows"
+    },
+    {
+        "classify_best_batch",
+        BINDING_IDENT(liblvq__lvq__classify_best_batch),
         METH_VARARGS,
-        "n-ary classification"
+        "k best clusters (and their weights) of matrix rows"
     },
     {
         "classify_weight",
@@ -1413,16 +11918,40 @@ static PyMethodDef lvqObject_methods[] = {
     },
     {
         "store",
-        BINDING_IDENT(liblvq__lvq__store),
-        METH_VARARGS,
+        (PyCFunction)BINDING_IDENT(liblvq__lvq__store),
+        METH_VARARGS | METH_KEYWORDS,
         "Store lvq instance to a file"
     },
     {
         "load",
-        BINDING_IDENT(liblvq__lvq__load),
-        METH_VARARGS | METH_CLASS,
+        (PyCFunction)BINDING_IDENT(liblvq__lvq__load),
+        METH_VARARGS | METH_KEYWORDS | METH_CLASS,
         "Load lvq instance from a file"
     },
+    {
+        "load_mmap",
+        (PyCFunction)BINDING_IDENT(liblvq__lvq__load_mmap),
+        METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+        "Load lvq instance from a binary file (memory-mapped)"
+    },
+    {
+        "to_bytes",
+        BINDING_IDENT(liblvq__lvq__to_bytes),
+        METH_VARARGS,
+        "Serialise lvq instance to bytes"
+    },
+    {
+        "from_bytes",
+        (PyCFunction)BINDING_IDENT(liblvq__lvq__from_bytes),
+        METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+        "Deserialise lvq instance from bytes"
+    },
+    {
+        "__reduce__",
+        BINDING_IDENT(liblvq__lvq__reduce),
+        METH_VARARGS,
+        "Pickle support"
+    },
 
     { NULL, NULL, 0, NULL }  // sentinel
 };  // end of lvqObject_methods
@@ -1466,6 +11995,60 @@ static PyMethodDef lvqClassifierStatisticsObject_methods[] = {
         METH_VARARGS,
         "Get F (i.e. F_1) score"
     },
+    {
+        "precision_all",
+        BINDING_IDENT(liblvq__lvq__classifier_statistics__precision_all),
+        METH_VARARGS,
+        "Get precisions of all classes"
+    },
+    {
+        "recall_all",
+        BINDING_IDENT(liblvq__lvq__classifier_statistics__recall_all),
+        METH_VARARGS,
+        "Get recalls of all classes"
+    },
+    {
+        "F_beta_all",
+        BINDING_IDENT(liblvq__lvq__classifier_statistics__F_beta_all),
+        METH_VARARGS,
+        "Get F_beta scores of all classes"
+    },
+    {
+        "confusion_matrix",
+        BINDING_IDENT(liblvq__lvq__classifier_statistics__confusion_matrix),
+        METH_VARARGS,
+        "Get confusion matrix view"
+    },
+    {
+        "update",
+        BINDING_IDENT(liblvq__lvq__classifier_statistics__update),
+        METH_VARARGS,
+        "Accumulate bound lvq object results on test set"
+    },
+    {
+        "merge",
+        BINDING_IDENT(liblvq__lvq__classifier_statistics__merge),
+        METH_VARARGS,
+        "Add results of other statistics"
+    },
+    {
+        "to_bytes",
+        BINDING_IDENT(liblvq__lvq__classifier_statistics__to_bytes),
+        METH_VARARGS,
+        "Serialise statistics to bytes"
+    },
+    {
+        "from_bytes",
+        BINDING_IDENT(liblvq__lvq__classifier_statistics__from_bytes),
+        METH_VARARGS | METH_CLASS,
+        "Deserialise statistics from bytes"
+    },
+    {
+        "__reduce__",
+        BINDING_IDENT(liblvq__lvq__classifier_statistics__reduce),
+        METH_VARARGS,
+        "Pickle support"
+    },
 
     { NULL, NULL, 0, NULL }  // sentinel
 };  // end of lvqClassifierStatisticsObject_methods
@@ -1485,11 +12068,200 @@ static PyMethodDef lvqClusteringStatisticsObject_methods[] = {
         METH_VARARGS,
         "Get average error"
     },
+    {
+        "avg_error_all",
+        BINDING_IDENT(liblvq__lvq__clustering_statistics__avg_error_all),
+        METH_VARARGS,
+        "Get average errors of all clusters"
+    },
+    {
+        "errors",
+        BINDING_IDENT(liblvq__lvq__clustering_statistics__errors),
+        METH_VARARGS,
+        "Get error sums view"
+    },
+    {
+        "counts",
+        BINDING_IDENT(liblvq__lvq__clustering_statistics__counts),
+        METH_VARARGS,
+        "Get sample counts view"
+    },
+    {
+        "update",
+        BINDING_IDENT(liblvq__lvq__clustering_statistics__update),
+        METH_VARARGS,
+        "Accumulate bound lvq object results on test set"
+    },
+    {
+        "merge",
+        BINDING_IDENT(liblvq__lvq__clustering_statistics__merge),
+        METH_VARARGS,
+        "Add results of other statistics"
+    },
+    {
+        "to_bytes",
+        BINDING_IDENT(liblvq__lvq__clustering_statistics__to_bytes),
+        METH_VARARGS,
+        "Serialise statistics to bytes"
+    },
+    {
+        "from_bytes",
+        BINDING_IDENT(liblvq__lvq__clustering_statistics__from_bytes),
+        METH_VARARGS | METH_CLASS,
+        "Deserialise statistics from bytes"
+    },
+    {
+        "__reduce__",
+        BINDING_IDENT(liblvq__lvq__clustering_statistics__reduce),
+        METH_VARARGS,
+        "Pickle support"
+    },
 
     { NULL, NULL, 0, NULL }  // sentinel
 };  // end of lvqClusteringStatisticsObject_methods
 
 
+/** Training job member functions */
+static PyMethodDef trainJobObject_methods[] = {
+    {
+        "progress",
+        BINDING_IDENT(liblvq__train_job__progress),
+        METH_VARARGS,
+        "Get progress records of loops finished since the last call"
+    },
+    {
+        "cancel",
+        (PyCFunction)BINDING_IDENT(liblvq__train_job__cancel),
+        METH_VARARGS | METH_KEYWORDS,
+        "Cancel training"
+    },
+    {
+        "done",
+        BINDING_IDENT(liblvq__train_job__done),
+        METH_VARARGS,
+        "Check whether training finished"
+    },
+    {
+        "wait",
+        BINDING_IDENT(liblvq__train_job__wait),
+        METH_VARARGS,
+        "Wait for training to finish"
+    },
+    {
+        "result",
+        BINDING_IDENT(liblvq__train_job__result),
+        METH_VARARGS,
+        "Get training result asyncio future"
+    },
+    {
+        "_resolve",
+        BINDING_IDENT(liblvq__train_job__resolve),
+        METH_VARARGS,
+        "Resolve future (internal)"
+    },
+
+    { NULL, NULL, 0, NULL }  // sentinel
+};  // end of trainJobObject_methods
+
+
+/** Training set member functions */
+static PyMethodDef trainingSetObject_methods[] = {
+    {
+        "dimension",
+        BINDING_IDENT(liblvq__training_set__dimension),
+        METH_VARARGS,
+        "Get samples dimension"
+    },
+    {
+        "size",
+        BINDING_IDENT(liblvq__training_set__size),
+        METH_VARARGS,
+        "Get sample count"
+    },
+    {
+        "labelled",
+        BINDING_IDENT(liblvq__training_set__labelled),
+        METH_VARARGS,
+        "Get True iff samples are labelled"
+    },
+    {
+        "undefined_count",
+        BINDING_IDENT(liblvq__training_set__undefined_count),
+        METH_VARARGS,
+        "Get undefined values count"
+    },
+    {
+        "matrix",
+        BINDING_IDENT(liblvq__training_set__matrix),
+        METH_VARARGS,
+        "Get sample matrix (read-only memoryview)"
+    },
+    {
+        "labels",
+        BINDING_IDENT(liblvq__training_set__labels),
+        METH_VARARGS,
+        "Get labels (read-only memoryview or None)"
+    },
+    {
+        "undefined_mask",
+        BINDING_IDENT(liblvq__training_set__undefined_mask),
+        METH_VARARGS,
+        "Get undefined values mask (read-only memoryview)"
+    },
+
+    { NULL, NULL, 0, NULL }  // sentinel
+};  // end of trainingSetObject_methods
+
+
+/** Model snapshot member functions */
+static PyMethodDef snapshotObject_methods[] = {
+    {
+        "version",
+        BINDING_IDENT(liblvq__snapshot__version),
+        METH_VARARGS,
+        "Get model version"
+    },
+    {
+        "dimension",
+        BINDING_IDENT(liblvq__snapshot__dimension),
+        METH_VARARGS,
+        "Get model dimension"
+    },
+    {
+        "clusters",
+        BINDING_IDENT(liblvq__snapshot__clusters),
+        METH_VARARGS,
+        "Get clusters count"
+    },
+    {
+        "get",
+        BINDING_IDENT(liblvq__snapshot__get),
+        METH_VARARGS,
+        "Get cluster representant"
+    },
+    {
+        "prototypes",
+        BINDING_IDENT(liblvq__snapshot__prototypes),
+        METH_VARARGS,
+        "Get prototype matrix (read-only memoryview)"
+    },
+    {
+        "classify",
+        BINDING_IDENT(liblvq__snapshot__classify),
+        METH_VARARGS,
+        "Classify input"
+    },
+    {
+        "classify_batch",
+        (PyCFunction)BINDING_IDENT(liblvq__snapshot__classify_batch),
+        METH_VARARGS | METH_KEYWORDS,
+        "Classify matrix rows (buffer)"
+    },
+
+    { NULL, NULL, 0, NULL }  // sentinel
+};  // end of snapshotObject_methods
+
+
 /** LVQ Python type */
 static PyTypeObject lvqType = {
     PyObject_HEAD_INIT(NULL)
@@ -1541,7 +12313,7 @@ static PyTypeObject * get_lvqType() { return &lvqType; }
 static PyTypeObject lvqClassifierStatisticsType = {
     PyObject_HEAD_INIT(NULL)
 
-    /* tp_name          */  "liblvq.lvq.classifier_statistics",
+    /* tp_name          */  "liblvq.classifier_statistics",
     /* tp_basicsize     */  sizeof(lvqClassifierStatisticsObject_t),
     /* tp_itemsize      */  0,
     /* tp_dealloc       */  (destructor)BINDING_IDENT(liblvq__lvq__classifier_statistics__destroy),
@@ -1590,7 +12362,7 @@ static PyTypeObject * get_lvqClassifierStatisticsType() {
 static PyTypeObject lvqClusteringStatisticsType = {
     PyObject_HEAD_INIT(NULL)
 
-    /* tp_name          */  "liblvq.lvq.clustering_statistics",
+    /* tp_name          */  "liblvq.clustering_statistics",
     /* tp_basicsize     */  sizeof(lvqClusteringStatisticsObject_t),
     /* tp_itemsize      */  0,
     /* tp_dealloc       */  (destructor)BINDING_IDENT(liblvq__lvq__clustering_statistics__destroy),
@@ -1635,6 +12407,127 @@ static PyTypeObject * get_lvqClusteringStatisticsType() {
 }
 
 
+/** Training job Python type */
+static PyTypeObject trainJobType = {
+    PyObject_HEAD_INIT(NULL)
+
+    /* tp_name          */  "liblvq.train_job",
+    /* tp_basicsize     */  sizeof(trainJobObject_t),
+    /* tp_itemsize      */  0,
+    /* tp_dealloc       */  (destructor)BINDING_IDENT(liblvq__train_job__destroy),
+    /* tp_print         */  0,
+    /* tp_getattr       */  0,
+    /* tp_setattr       */  0,
+    /* tp_compare       */  0,
+    /* tp_repr          */  0,
+    /* tp_as_number     */  0,
+    /* tp_as_sequence   */  0,
+    /* tp_as_mapping    */  0,
+    /* tp_hash          */  0,
+    /* tp_call          */  0,
+    /* tp_str           */  0,
+    /* tp_getattro      */  0,
+    /* tp_setattro      */  0,
+    /* tp_as_buffer     */  0,
+    /* tp_flags         */  Py_TPFLAGS_DEFAULT,
+    /* tp_doc           */  "lvq asynchronous training job objects",
+    /* tp_traverse      */  0,
+    /* tp_clear         */  0,
+    /* tp_richcompare   */  0,
+    /* tp_weaklistoffset*/  0,
+    /* tp_iter          */  0,
+    /* tp_iternext      */  0,
+    /* tp_methods       */  trainJobObject_methods,
+
+};  // end of trainJobType
+
+static PyTypeObject * get_trainJobType() { return &trainJobType; }
+
+
+/** Training set Python type */
+static PyTypeObject trainingSetType = {
+    PyObject_HEAD_INIT(NULL)
+
+    /* tp_name          */  "liblvq.TrainingSet",
+    /* tp_basicsize     */  sizeof(trainingSetObject_t),
+    /* tp_itemsize      */  0,
+    /* tp_dealloc       */  (destructor)BINDING_IDENT(liblvq__training_set__destroy),
+    /* tp_print         */  0,
+    /* tp_getattr       */  0,
+    /* tp_setattr       */  0,
+    /* tp_compare       */  0,
+    /* tp_repr          */  0,
+    /* tp_as_number     */  0,
+    /* tp_as_sequence   */  0,
+    /* tp_as_mapping    */  0,
+    /* tp_hash          */  0,
+    /* tp_call          */  0,
+    /* tp_str           */  0,
+    /* tp_getattro      */  0,
+    /* tp_setattro      */  0,
+    /* tp_as_buffer     */  0,
+    /* tp_flags         */  Py_TPFLAGS_DEFAULT,
+    /* tp_doc           */  "lvq native training set objects",
+    /* tp_traverse      */  0,
+    /* tp_clear         */  0,
+    /* tp_richcompare   */  0,
+    /* tp_weaklistoffset*/  0,
+    /* tp_iter          */  0,
+    /* tp_iternext      */  0,
+    /* tp_methods       */  trainingSetObject_methods,
+    /* tp_members       */  0,
+    /* tp_getset        */  0,
+    /* tp_base          */  0,
+    /* tp_dict          */  0,
+    /* tp_descr_get     */  0,
+    /* tp_descr_set     */  0,
+    /* tp_dictoffset    */  0,
+    /* tp_init          */  0,
+    /* tp_alloc         */  0,
+    /* tp_new           */  BINDING_IDENT(liblvq__training_set__new),
+
+};  // end of trainingSetType
+
+static PyTypeObject * get_trainingSetType() { return &trainingSetType; }
+
+
+/** Model snapshot Python type */
+static PyTypeObject snapshotType = {
+    PyObject_HEAD_INIT(NULL)
+
+    /* tp_name          */  "liblvq.Snapshot",
+    /* tp_basicsize     */  sizeof(snapshotObject_t),
+    /* tp_itemsize      */  0,
+    /* tp_dealloc       */  (destructor)BINDING_IDENT(liblvq__snapshot__destroy),
+    /* tp_print         */  0,
+    /* tp_getattr       */  0,
+    /* tp_setattr       */  0,
+    /* tp_compare       */  0,
+    /* tp_repr          */  0,
+    /* tp_as_number     */  0,
+    /* tp_as_sequence   */  0,
+    /* tp_as_mapping    */  0,
+    /* tp_hash          */  0,
+    /* tp_call          */  0,
+    /* tp_str           */  0,
+    /* tp_getattro      */  0,
+    /* tp_setattro      */  0,
+    /* tp_as_buffer     */  0,
+    /* tp_flags         */  Py_TPFLAGS_DEFAULT,
+    /* tp_doc           */  "lvq immutable model snapshot objects",
+    /* tp_traverse      */  0,
+    /* tp_clear         */  0,
+    /* tp_richcompare   */  0,
+    /* tp_weaklistoffset*/  0,
+    /* tp_iter          */  0,
+    /* tp_iternext      */  0,
+    /* tp_methods       */  snapshotObject_methods,
+
+};  // end of snapshotType
+
+static PyTypeObject * get_snapshotType() { return &snapshotType; }
+
+
 /** Module member functions */
 static PyMethodDef liblvq_methods[] = {
     {
@@ -1643,6 +12536,30 @@ static PyMethodDef liblvq_methods[] = {
         METH_VARARGS,
         "Seed RNG"
     },
+    {
+        "set_num_threads",
+        BINDING_IDENT(set_num_threads),
+        METH_VARARGS,
+        "Set worker threads count (0 means default)"
+    },
+    {
+        "get_num_threads",
+        BINDING_IDENT(get_num_threads),
+        METH_VARARGS,
+        "Get worker threads count"
+    },
+    {
+        "simd_isa",
+        BINDING_IDENT(simd_isa),
+        METH_VARARGS,
+        "Get SIMD instruction set used by dense models"
+    },
+    {
+        "write_tset",
+        (PyCFunction)BINDING_IDENT(write_tset),
+        METH_VARARGS | METH_KEYWORDS,
+        "Write binary training set file"
+    },
 
     { NULL, NULL, 0, NULL }  // sentinel
 };  // end of liblvq__methods
@@ -1667,6 +12584,10 @@ PyMODINIT_FUNC PyInit_liblvq(void) {
     if (PyType_Ready(&lvqType)                     < 0) return NULL;
     if (PyType_Ready(&lvqClassifierStatisticsType) < 0) return NULL;
     if (PyType_Ready(&lvqClusteringStatisticsType) < 0) return NULL;
+    if (PyType_Ready(&bufferExporterType)          < 0) return NULL;
+    if (PyType_Ready(&trainJobType)                < 0) return NULL;
+    if (PyType_Ready(&trainingSetType)             < 0) return NULL;
+    if (PyType_Ready(&snapshotType)                < 0) return NULL;
 
     PyObject * module = PyModule_Create(&moduledef);
     if (NULL == module) return NULL;
@@ -1682,5 +12603,17 @@ PyMODINIT_FUNC PyInit_liblvq(void) {
     PyModule_AddObject(module, "lvq.clustering_statistics",
         (PyObject *)&lvqClusteringStatisticsType);
 
+    // Statistics types are also module members (so that they may be pickled)
+    Py_INCREF(&lvqClassifierStatisticsType);
+    PyModule_AddObject(module, "classifier_statistics",
+        (PyObject *)&lvqClassifierStatisticsType);
+
+    Py_INCREF(&lvqClusteringStatisticsType);
+    PyModule_AddObject(module, "clustering_statistics",
+        (PyObject *)&lvqClusteringStatisticsType);
+
+    Py_INCREF(&trainingSetType);
+    PyModule_AddObject(module, "TrainingSet", (PyObject *)&trainingSetType);
+
     return module;
 }
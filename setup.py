@@ -5,7 +5,8 @@ from distutils.core import setup, Extension;
 
 liblvq = Extension('liblvq',
     sources            = ['liblvq.cxx'],
-    extra_compile_args = ['-std=c++11']);
+    extra_compile_args = ['-std=c++11', '-pthread'],
+    extra_link_args    = ['-pthread']);
 
 setup(
     name         = 'lvq',
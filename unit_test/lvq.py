@@ -1,9 +1,37 @@
 #!/usr/bin/env python
 
-from liblvq import lvq, rng_seed
+from liblvq import lvq, rng_seed, set_num_threads, get_num_threads, write_tset
+from liblvq import classifier_statistics, TrainingSet
 
+import asyncio
+import math
+import os
+import pickle
 import sys
-from time import time
+import tempfile
+from array import array
+from time import sleep, time
+
+
+def close(a, b, tol = 1e-5):
+    """Weights (or sequences of weights) equal up to rounding"""
+    if isinstance(a, (tuple, list)):
+        return len(a) == len(b) and all(close(x, y, tol) for x, y in zip(a, b))
+    return abs(a - b) <= tol
+
+
+def best_close(dense, plain, vec, k):
+    """Top-k of dense model matches plain model weights (ties in any order)"""
+    best   = dense.classify_best(vec, k)
+    weight = plain.classify_weight(vec)
+    return close([w for _, w in best], [w for _, w in plain.classify_best(vec, k)]) \
+       and all(close(w, weight[c]) for c, w in best)
+
+
+def matrix(rows, typecode = 'd'):
+    """2-D C-contiguous buffer of rows"""
+    flat = array(typecode, [x for row in rows for x in row])
+    return memoryview(flat).cast('B').cast(typecode, (len(rows), len(rows[0])))
 
 
 rng_seed(int(time()))
@@ -73,6 +101,61 @@ for vec, expected in test_set:
     print(str(vec) + " classifed as " + str(c1ass) + \
         " (" + ("correctly)" if c1ass == expected else "WRONGLY)"))
 
+test_matrix = matrix([vec for vec, _ in test_set])
+batch = classifier.classify_batch(test_matrix)
+assert list(batch) == [classifier.classify(vec) for vec, _ in test_set]
+
+set_num_threads(4)
+batch = classifier.classify_batch(matrix([vec for vec, _ in test_set] * 100))
+assert list(batch) == [classifier.classify(vec) for vec, _ in test_set] * 100
+print("Batch classification using %d threads OK" % (get_num_threads(),))
+
+async def classify_all():
+    return await asyncio.gather(*[classifier.classify_async(vec) for vec, _ in test_set])
+
+assert asyncio.run(classify_all()) == [classifier.classify(vec) for vec, _ in test_set]
+
+# Futures fail with the exception classify would raise
+async def classify_invalid():
+    return await classifier.classify_async((1.0, 2.0))
+
+try:
+    classifier.classify((1.0, 2.0))
+    assert False, "Dimension mismatch not detected"
+except Exception as x:
+    sync_error = type(x)
+try:
+    asyncio.run(classify_invalid())
+    assert False, "Dimension mismatch not detected"
+except Exception as x:
+    assert type(x) is sync_error
+
+# Batcher inherited by forked child is re-created
+if hasattr(os, "fork"):
+    pid = os.fork()
+    if 0 == pid:
+        ok = asyncio.run(classify_all()) == \
+             [classifier.classify(vec) for vec, _ in test_set]
+        os._exit(0 if ok else 1)
+    assert os.waitpid(pid, 0)[1] == 0
+
+out = array('q', [0] * len(test_set))
+classifier.classify_batch(matrix([vec for vec, _ in test_set], 'f'), out=out)
+assert list(out) == [classifier.classify(tuple(array('f', vec))) for vec, _ in test_set]
+print("Batch classification: " + str(list(out)))
+
+weights = classifier.classify_weight_batch(test_matrix)
+assert weights.shape == (len(test_set), 6)
+assert [tuple(row) for row in weights.tolist()] == \
+       [classifier.classify_weight(vec) for vec, _ in test_set]
+
+best_index, best_weight = classifier.classify_best_batch(test_matrix, 3)
+assert [list(zip(i, w)) for i, w in zip(best_index.tolist(), best_weight.tolist())] == \
+       [list(classifier.classify_best(vec, 3)) for vec, _ in test_set]
+
+weights = classifier.classify_weight_batch(test_matrix, dtype = "float32")
+print("Batch classification weights (float32): " + str(weights.tolist()[0]))
+
 stats = classifier.test_classifier(test_set)
 
 print("Accuracy: %f" % (stats.accuracy(),))
@@ -88,6 +171,445 @@ print("F_1   score: %f" % (stats.F(),))
 print("F_0.5 score: %f" % (stats.F_beta(0.5),))
 print("F_2   score: %f" % (stats.F_beta(2.0),))
 
+matrix_stats = classifier.test_classifier(  # more shards than threads
+    matrix([vec for vec, _ in test_set] * 100),
+    array('q', [cluster for _, cluster in test_set] * 100))
+assert matrix_stats.accuracy() == stats.accuracy()
+assert sum(sum(row) for row in matrix_stats.confusion_matrix().tolist()) == \
+       100 * len(test_set)
+assert [matrix_stats.F(c1ass) for c1ass in range(6)] == \
+       [stats.F(c1ass) for c1ass in range(6)]
+
+window_stats = classifier_statistics(classifier)
+for window in (test_set[:2], test_set[2:]):
+    partial = classifier_statistics(classifier)
+    partial.update(window)
+    window_stats.merge(pickle.loads(pickle.dumps(partial)))
+assert window_stats.to_bytes() == stats.to_bytes()
+
+# Pickled statistics stay bound to (a copy of) the model
+restored = pickle.loads(pickle.dumps(classifier_statistics(classifier)))
+restored.update(test_set)
+assert restored.to_bytes() == stats.to_bytes()
+
+class Index(object):
+    def __index__(self): return 6
+assert classifier_statistics(Index()).to_bytes() == \
+       classifier_statistics(6).to_bytes()
+
+cmatrix = stats.confusion_matrix()
+assert cmatrix.shape == (6, 6)
+assert sum(sum(row) for row in cmatrix.tolist()) == len(test_set)
+assert list(stats.precision_all()) == [stats.precision(c1ass) for c1ass in range(6)]
+assert list(stats.recall_all()) == [stats.recall(c1ass) for c1ass in range(6)]
+assert list(stats.F_beta_all(2)) == [stats.F_beta(2, c1ass) for c1ass in range(6)]
+
+dense_classifier = lvq(3, 6, dtype = "float32", allow_undef = False)
+for cluster in range(6):
+    dense_classifier.set(classifier.get(cluster), cluster)
+
+assert [dense_classifier.classify(vec) for vec, _ in test_set] == \
+       [classifier.classify(vec) for vec, _ in test_set]
+print("Dense (float32) model classification OK")
+
+# Weights of dense models are computed by SIMD kernels (float32 rounding)
+assert close([dense_classifier.classify_weight(vec) for vec, _ in test_set],
+             [classifier.classify_weight(vec) for vec, _ in test_set])
+assert close(dense_classifier.classify_weight_batch(test_matrix).tolist(),
+             [list(classifier.classify_weight(vec)) for vec, _ in test_set])
+for vec, _ in test_set:
+    assert best_close(dense_classifier, classifier, vec, 3)
+    assert [c for c, _ in dense_classifier.classify_weight_threshold(vec, 0.1)] == \
+           [c for c, _ in classifier.classify_weight_threshold(vec, 0.1)]
+
+dense_classifier.build_index(nlist = 2, nprobe = 2)
+assert [dense_classifier.classify(vec) for vec, _ in test_set] == \
+       [classifier.classify(vec) for vec, _ in test_set]
+for vec, _ in test_set:  # all lists probed
+    assert best_close(dense_classifier, classifier, vec, 3)
+assert close(dense_classifier.classify_best_batch(test_matrix, 3)[1].tolist(),
+             classifier.classify_best_batch(test_matrix, 3)[1].tolist())
+
+# Top-k of the probed prototypes (at least k are probed)
+dense_classifier.set_index_nprobe(1)
+indexed_best = [dense_classifier.classify_best(vec, 3) for vec, _ in test_set]
+for (vec, _), best in zip(test_set, indexed_best):
+    weight = classifier.classify_weight(vec)  # normalised over all
+    assert len(best) == 3 and all(w >= weight[c] - 1e-5 for c, w in best)
+    assert [w for _, w in best] == sorted((w for _, w in best), reverse = True)
+index, weight = dense_classifier.classify_best_batch(test_matrix, 3)
+assert index.tolist() == [[c for c, _ in best] for best in indexed_best]
+assert weight.tolist() == [[w for _, w in best] for best in indexed_best]
+assert dense_classifier.test_classifier(test_set).accuracy() == \
+       classifier.test_classifier(test_set).accuracy()  # testing is exact
+print("Index: %s" % (dense_classifier.index_info(),))
+dense_classifier.drop_index()
+
+dense_classifier.set_pruning(pivots = 2)
+assert [dense_classifier.classify(vec) for vec, _ in test_set] == \
+       [classifier.classify(vec) for vec, _ in test_set]
+print("Pruned search: %s" % (dense_classifier.pruning_stats(reset = True),))
+dense_classifier.set_pruning(pivots = 0)
+
+# Pruning bound holds for large-norm data and near-duplicate prototypes
+far_classifier = lvq(16, 48, dtype = "float32")
+for cluster in range(48):
+    far_classifier.set([1e4 + (j % 3) * 1e3 + (cluster % 8) * 1e-2 + (cluster // 8) * 3.0
+        for j in range(16)], cluster)
+
+far_queries = [[1e4 + (j % 3) * 1e3 + ((t * 7 + j) % 13) * 1.3e-2 + (t % 6) * 3.0
+    for j in range(16)] for t in range(60)]
+linear = [far_classifier.classify(vec) for vec in far_queries]
+far_classifier.set_pruning(pivots = 4)
+assert [far_classifier.classify(vec) for vec in far_queries] == linear
+print("Pruned search (large norm): %s" % (far_classifier.pruning_stats(),))
+
+# Online training steps search the BMU pruned (same result as linear scan)
+pruned_trained = lvq(3, 6, dtype = "float64")
+linear_trained = lvq(3, 6, dtype = "float64")
+for cluster in range(6):
+    pruned_trained.set(train_set[cluster][0], cluster)
+    linear_trained.set(train_set[cluster][0], cluster)
+pruned_trained.set_pruning(pivots = 2)
+for c in (pruned_trained, linear_trained):
+    c.train1_supervised_batch(matrix([vec for vec, _ in train_set]),
+        [cluster for _, cluster in train_set], lfactor = 0.1)
+assert [pruned_trained.get(c) for c in range(6)] == \
+       [linear_trained.get(c) for c in range(6)]
+assert pruned_trained.pruning_stats()["evaluated"] > 0
+
+prototypes = classifier.prototypes()
+assert prototypes.tolist() == [list(classifier.get(cluster)) for cluster in range(6)]
+
+bulk_classifier = lvq(3, 6, dtype = "float32")
+bulk_classifier.set_prototypes(prototypes)
+with bulk_classifier.prototypes(writable = True) as view:  # copy
+    assert view.format == 'd' and view.shape == (6, 3)
+    view[0, 0] = 0.25
+    assert bulk_classifier.get(0)[0] != 0.25
+    bulk_classifier.set_prototypes(view)  # explicit commit
+    view[1, 0] = 0.75
+    bulk_classifier.set_prototypes(view)  # committed again
+assert bulk_classifier.get(0)[0] == 0.25 and bulk_classifier.get(1)[0] == 0.75
+with bulk_classifier.prototypes(writable = True) as view:
+    view[0, 0] = 0.125  # released uncommitted
+assert bulk_classifier.get(0)[0] == 0.25
+assert bulk_classifier.prototypes().tolist()[2:] == \
+       dense_classifier.prototypes().tolist()[2:]
+
+# Commit raises if the model changed meanwhile (or rows are invalid)
+with bulk_classifier.prototypes(writable = True) as view:
+    view[0, 0] = 0.5
+    bulk_classifier.train1_supervised(test_set[0][0], test_set[0][1], 0.5)
+    trained = [bulk_classifier.get(c) for c in range(6)]
+    version = bulk_classifier.snapshot().version()
+    try:
+        bulk_classifier.set_prototypes(view)
+        assert False, "Stale prototypes view committed"
+    except RuntimeError:
+        pass
+assert bulk_classifier.snapshot().version() == version
+with dense_classifier.prototypes(writable = True) as view:
+    view[0, 0] = float("nan")  # undefined values not allowed
+    try:
+        dense_classifier.set_prototypes(view)
+        assert False, "Undefined prototype value committed"
+    except RuntimeError:
+        pass
+assert dense_classifier.get(0)[0] is not None
+assert [bulk_classifier.get(c) for c in range(6)] == trained
+
+seeded_classifier = lvq(3, 6)
+seeded_classifier.set_from_data(train_set, method = "stratified")
+for cluster in range(6):
+    assert (tuple(seeded_classifier.get(cluster)), cluster) in train_set
+
+sparse_classifier = lvq(3, 6, dtype = "float64")
+for cluster in range(6):
+    sparse_classifier.set(classifier.get(cluster), cluster)
+
+for vec in ((1, None, 0), (None, 1, None), (None, None, None)):
+    print(str(vec) + " classified (dense, masked) as " + \
+        str(sparse_classifier.classify(vec)))
+
+# Dense models find the BMU on the dense prototypes, update the ml::lvq one
+# (and match the non-dense model)
+steps = (((0.9, None, 0.1), 0), ((0.1, 0.8, None), 3), ((0.5, 0.5, 0.5), None))
+plain_classifier = lvq(3, 6)
+f32_classifier   = lvq(3, 6, dtype = "float32")
+for cluster in range(6):
+    plain_classifier.set(classifier.get(cluster), cluster)
+    f32_classifier.set(classifier.get(cluster), cluster)
+
+for vec, cluster in steps:
+    dnorm2 = [c.train1_supervised(vec, cluster, 0.1) if cluster is not None
+        else c.train1_unsupervised(vec, 0.1)
+        for c in (plain_classifier, sparse_classifier, f32_classifier)]
+    print("Dense training step dnorm2: %s" % (dnorm2,))
+    assert close(dnorm2[0], dnorm2[1]) and close(dnorm2[0], dnorm2[2])
+
+for cluster in range(6):
+    assert plain_classifier.get(cluster) == sparse_classifier.get(cluster)
+    assert plain_classifier.get(cluster) == f32_classifier.get(cluster)
+for vec, _ in test_set:
+    assert plain_classifier.classify(vec) == sparse_classifier.classify(vec)
+
+# ... also over whole SIMD vectors (with undefined values)
+wide_plain = lvq(21, 4)
+wide_dense = lvq(21, 4, dtype = "float64")
+for cluster in range(4):
+    proto = [(cluster * 7 + j) % 5 / 4.0 for j in range(21)]
+    wide_plain.set(proto, cluster)
+    wide_dense.set(proto, cluster)
+
+wide_steps = [[None if (t + j) % 9 == 0 else ((t * 3 + j) % 7) / 6.0
+    for j in range(21)] for t in range(40)]
+for t, vec in enumerate(wide_steps):
+    dnorm2 = [c.train1_supervised(vec, t % 4, 0.2) for c in (wide_plain, wide_dense)]
+    assert close(dnorm2[0], dnorm2[1], 1e-9)
+assert [wide_plain.get(c) for c in range(4)] == [wide_dense.get(c) for c in range(4)]
+
+mb_classifier = lvq(3, 6)
+for cluster in range(6):
+    mb_classifier.set(train_set[cluster][0], cluster)
+mb_classifier.train_supervised(train_set, mode = "minibatch", batch_size = 6)
+
+mb_accuracy = mb_classifier.test_classifier(test_set).accuracy()
+assert mb_accuracy >= 0.9
+print("Mini-batch trained accuracy: %f" % (mb_accuracy,))
+
+rng_seed(1)
+seq_classifier = lvq(3, 6)
+seq_classifier.set_random()
+seq_classifier.train_supervised(train_set)
+
+rng_seed(1)
+mb1_classifier = lvq(3, 6)
+mb1_classifier.set_random()
+mb1_classifier.train_supervised(train_set, mode = "minibatch", batch_size = 1)
+assert [mb1_classifier.get(c) for c in range(6)] == \
+       [seq_classifier.get(c) for c in range(6)]
+
+async_classifier = lvq(3, 6)
+async_classifier.set_random()
+job = async_classifier.train_async(train_set, batch_size = 6)
+
+async def train_result():
+    return await job.result()
+
+result = asyncio.run(train_result())
+assert job.done() and result["stored"] and not result["cancelled"]
+assert [loop for loop, _, _ in job.progress()] == list(range(1, result["loops"] + 1))
+
+print("Async trained (%d loops) accuracy: %f" % \
+    (result["loops"], async_classifier.test_classifier(test_set).accuracy()))
+
+# Concurrent modification fails the store (cancel(keep=False) is respected)
+job = async_classifier.train_async(train_set, batch_size = 6,
+    conv_win = 1000000, max_div_cnt = 1000000, max_tlc = 1000000)
+job.cancel(keep = True)
+job.cancel(keep = False)
+assert job.wait() and not asyncio.run(train_result())["stored"]
+
+initial = [async_classifier.get(c) for c in range(6)]
+job = async_classifier.train_async(train_set, batch_size = 6,
+    conv_win = 1000000, max_div_cnt = 1000000, max_tlc = 1000000)
+async_classifier.set(initial[0], 1)
+job.cancel(keep = True)
+job.wait()
+try:
+    asyncio.run(train_result())
+    assert False, "Store of concurrently modified model succeeded"
+except RuntimeError:
+    pass
+assert async_classifier.get(1) == initial[0]
+
+# Index and pruning tuning isn't a modification (the store succeeds)
+tuned_classifier = lvq(3, 6, dtype = "float32")
+for cluster in range(6):
+    tuned_classifier.set(train_set[cluster][0], cluster)
+tuned_classifier.build_index(nlist = 2, nprobe = 1)
+version = tuned_classifier.snapshot().version()
+job = tuned_classifier.train_async(train_set, batch_size = 6,
+    conv_win = 1000000, max_div_cnt = 1000000, max_tlc = 1000000)
+tuned_classifier.set_index_nprobe(2)
+tuned_classifier.set_pruning(pivots = 2)
+assert tuned_classifier.index_info()["nprobe"] == 2
+job.cancel(keep = True)
+job.wait()
+assert asyncio.run(train_result())["stored"]
+assert tuned_classifier.snapshot().version() > version
+
+stream_classifier = lvq(3, 6)
+for cluster in range(6):
+    stream_classifier.set(train_set[cluster][0], cluster)
+
+trained = stream_classifier.train_supervised_stream(
+    (sample for _ in range(50) for sample in train_set), chunk_size = 64,
+    lfactor = 0.1, decay = 0.01)
+
+print("Stream trained (%d samples) accuracy: %f" % \
+    (trained, stream_classifier.test_classifier(test_set).accuracy()))
+
+assert trained == 50 * len(train_set)
+
+# Streaming equals the per-sample train1 loop (lfactor/(1+decay*t))
+loop_classifier = lvq(3, 6)
+for cluster in range(6):
+    loop_classifier.set(train_set[cluster][0], cluster)
+
+t = 0
+for _ in range(50):
+    for vec, cluster in train_set:
+        loop_classifier.train1_supervised(vec, cluster, 0.1 / (1 + 0.01 * t))
+        t += 1
+
+for cluster in range(6):
+    assert loop_classifier.get(cluster) == stream_classifier.get(cluster)
+
+online_classifier = lvq(3, 6)
+for cluster in range(6):
+    online_classifier.set(train_set[cluster][0], cluster)
+
+samples = [sample for _ in range(50) for sample in train_set]
+dnorm2 = online_classifier.train1_supervised_batch(
+    matrix([vec for vec, _ in samples]), [cluster for _, cluster in samples],
+    schedule = "exponential", lfactor = 0.1, decay = 0.001)
+assert len(dnorm2) == len(samples)
+
+print("Batched online trained accuracy: %f (last dnorm2: %f)" % \
+    (online_classifier.test_classifier(test_set).accuracy(), dnorm2[-1]))
+
+# Batched steps match train1_supervised loop with the schedule's factors
+schedules = {
+    "constant":    lambda t: 0.1,
+    "inverse":     lambda t: 0.1 / (1.0 + 0.01 * t),
+    "exponential": lambda t: 0.1 * math.exp(-0.01 * t),
+    "step":        lambda t: 0.1 * math.exp(-0.01 * (t // 7)),
+}
+
+for schedule, lfactor in schedules.items():
+    batch_classifier = lvq(3, 6)
+    loop_classifier  = lvq(3, 6)
+    for cluster in range(6):
+        batch_classifier.set(train_set[cluster][0], cluster)
+        loop_classifier.set(train_set[cluster][0], cluster)
+
+    batch_dnorm2 = batch_classifier.train1_supervised_batch(
+        matrix([vec for vec, _ in samples]), [cluster for _, cluster in samples],
+        schedule = schedule, lfactor = 0.1, decay = 0.01, step = 7, start = 3)
+    loop_dnorm2 = [loop_classifier.train1_supervised(vec, cluster, lfactor(3 + t))
+        for t, (vec, cluster) in enumerate(samples)]
+
+    assert list(batch_dnorm2) == loop_dnorm2, schedule
+    for cluster in range(6):
+        assert batch_classifier.get(cluster) == loop_classifier.get(cluster), schedule
+
+snapshot_classifier = lvq(3, 6, dtype = "float32")
+for cluster in range(6):
+    snapshot_classifier.set(train_set[cluster][0], cluster)
+
+snapshot = snapshot_classifier.snapshot()
+initial  = [snapshot.get(cluster) for cluster in range(6)]
+snapshot_classifier.train_supervised(train_set)
+
+latest = snapshot_classifier.snapshot()
+assert latest.version() > snapshot.version()
+assert [snapshot.get(cluster) for cluster in range(6)] == initial
+assert [latest.get(cluster) for cluster in range(6)] == \
+    [snapshot_classifier.get(cluster) for cluster in range(6)]
+assert list(latest.classify_batch(test_matrix)) == \
+    [snapshot_classifier.classify(vec) for vec, _ in test_set]
+
+print("Model snapshot (version %d) OK" % (latest.version(),))
+
+# A held snapshot isn't affected by training (while the live model is)
+held_classifier = lvq(3, 6, dtype = "float32")
+held_classifier.set_random()
+
+held    = held_classifier.snapshot()
+version = held.version()
+initial = [held.get(cluster) for cluster in range(6)]
+before  = list(held.classify_batch(test_matrix))
+
+held_classifier.train_supervised(train_set, mode = "minibatch", batch_size = 6)
+
+assert held.version() == version
+assert held_classifier.snapshot().version() > version
+assert [held.get(cluster) for cluster in range(6)] == initial
+assert list(held.classify_batch(test_matrix)) == before
+assert [held_classifier.get(cluster) for cluster in range(6)] != initial
+assert [held_classifier.classify(vec) for vec, _ in test_set] == \
+    list(held_classifier.snapshot().classify_batch(test_matrix))
+
+# Modifications of large models are published (coalesced) with delay
+large_classifier = lvq(70000, 2)
+large_row = (0.5,) * 70000
+large_classifier.set(large_row, 1)
+
+deadline = time() + 5
+while large_classifier.snapshot().get(1) != large_row:
+    assert time() < deadline
+    sleep(0.01)
+
+tset_dir = tempfile.mkdtemp()
+tset_file = os.path.join(tset_dir, "test_set.lvqtset")
+assert write_tset(tset_file, test_set) == len(test_set)
+assert classifier.test_classifier(tset_file).accuracy() == \
+       classifier.test_classifier(test_set).accuracy()
+assert classifier.test_classifier(TrainingSet(tset_file)).accuracy() == \
+       classifier.test_classifier(TrainingSet(test_set)).accuracy() == \
+       classifier.test_classifier(test_set).accuracy()
+
+# 2-D inputs aren't taken for (input, cluster) samples
+assert write_tset(tset_file, [(None, 1), (0.5, 2)]) == 2
+lvq(2, 1).test_clustering(tset_file)  # unlabelled 2-D samples
+assert os.listdir(tset_dir) == ["test_set.lvqtset"]  # no temporary files
+
+write_tset(tset_file, matrix([vec for vec, _ in train_set], 'f'),
+    labels = array('q', [cluster for _, cluster in train_set]), dtype = "float32")
+
+file_classifier = lvq(3, 6)
+file_classifier.set_random()
+file_classifier.train_supervised(tset_file, mode = "minibatch", batch_size = 6)
+
+print("Mini-batch trained (from file) accuracy: %f" % \
+    (file_classifier.test_classifier(test_set).accuracy(),))
+
+model_file = os.path.join(tset_dir, "classifier.lvqmodel")
+classifier.store(model_file, format = "binary")
+mmap_classifier = lvq.load_mmap(model_file)
+assert [mmap_classifier.classify(vec) for vec, _ in test_set] == \
+       [classifier.classify(vec) for vec, _ in test_set]
+
+dense_classifier.store(model_file, format = "binary")
+mmap_classifier = lvq.load_mmap(model_file)
+assert [mmap_classifier.classify(vec) for vec, _ in test_set] == \
+       [dense_classifier.classify(vec) for vec, _ in test_set]
+
+# Read-only mapping: the prototypes are copied once trained
+mmap_snapshot = mmap_classifier.snapshot()
+mmap_initial  = [mmap_classifier.get(c) for c in range(6)]
+mmap_classifier.train1_supervised(test_set[0][0], test_set[0][1], 0.5)
+assert mmap_classifier.get(test_set[0][1]) != dense_classifier.get(test_set[0][1])
+assert [mmap_snapshot.classify(vec) for vec, _ in test_set] == \
+       [dense_classifier.classify(vec) for vec, _ in test_set]
+with mmap_classifier.prototypes(writable = True) as view:
+    view[0, 0] = 0.25
+    mmap_classifier.set_prototypes(view)
+assert mmap_classifier.get(0)[0] == 0.25
+assert [lvq.load_mmap(model_file).get(c) for c in range(6)] == mmap_initial
+
+os.remove(model_file)
+
+pickled_classifier = pickle.loads(pickle.dumps(classifier))
+assert [pickled_classifier.get(c) for c in range(6)] == \
+       [classifier.get(c) for c in range(6)]
+assert lvq.from_bytes(sparse_classifier.to_bytes()).classify((1, None, 0)) == \
+       sparse_classifier.classify((1, None, 0))
+os.remove(tset_file)
+os.rmdir(tset_dir)
+
 if (len(sys.argv) > 1):
     classifier.store(sys.argv[1])
     classifier = lvq.load(sys.argv[1])
@@ -123,6 +645,18 @@ data_set = (
 
 print("Data set: " +  str(data_set))
 
+# Converted once, re-used by all the candidate models
+data_tset = TrainingSet(data_set)
+assert data_tset.size() == len(data_set) and not data_tset.labelled()
+assert data_tset.matrix().tolist() == [list(vec) for vec in data_set]
+
+# ... its ml::lvq conversion is cached unless disabled
+data_uset = TrainingSet(data_set, cache_liblvq = False)
+
+sparse_tset = TrainingSet([(0.5, None, 1.0), (None, None, 0.0)])
+assert sparse_tset.undefined_count() == 3
+assert sparse_tset.undefined_mask().tolist() == [[0b010], [0b011]]
+
 best_ccnt  = 0
 least_avge = 999999999
 for ccnt in range(1, 10):
@@ -131,7 +665,16 @@ for ccnt in range(1, 10):
     clustering = lvq(3, ccnt)
 
     clustering.set_random()
+    tclustering = lvq.from_bytes(clustering.to_bytes())
+    uclustering = lvq.from_bytes(clustering.to_bytes())
+
     clustering.train_unsupervised(data_set)
+    tclustering.train_unsupervised(data_tset)
+    uclustering.train_unsupervised(data_uset)
+
+    for cluster in range(ccnt):
+        assert tclustering.get(cluster) == clustering.get(cluster)
+        assert uclustering.get(cluster) == clustering.get(cluster)
 
     for cluster in range(ccnt):
         print("Cluster %d representant: %s" % (cluster, clustering.get(cluster)))
@@ -143,6 +686,8 @@ for ccnt in range(1, 10):
     stats = clustering.test_clustering(data_set)
     avge  = stats.avg_error()
 
+    assert tclustering.test_clustering(data_tset).avg_error() == avge
+
     print("Avg. error: %f" % (avge,))
 
     for cluster in range(ccnt):
@@ -179,5 +724,50 @@ avge  = stats.avg_error()
 
 print("Avg. error: %f" % (avge,))
 
+assert abs(clustering.test_clustering(matrix(data_set)).avg_error() - avge) < 1e-9
+assert abs(clustering.test_clustering(data_tset).avg_error() - avge) < 1e-9
+assert sum(stats.counts()) == len(data_set)
+assert list(stats.avg_error_all()) == [stats.avg_error(cluster) for cluster in range(6)]
+
+# Native clustering errors match ml::lvq::clustering_statistics
+# (squared distance to the best matching unit, averaged per cluster)
+lvq_errors = [[] for _ in range(6)]
+for vec in data_set:
+    cluster = clustering.classify(vec)
+    lvq_errors[cluster].append(sum((x - w) ** 2
+        for x, w in zip(vec, clustering.get(cluster))))
+for cluster in range(6):
+    errors = lvq_errors[cluster]
+    assert stats.counts()[cluster] == len(errors)
+    assert abs(stats.avg_error(cluster) -
+        (sum(errors) / len(errors) if errors else 0.0)) < 1e-9
+assert abs(avge - sum(map(sum, lvq_errors)) / len(data_set)) < 1e-9
+
+# Seeds beat a single centroid (the best 1-cluster model)
+centroid = lvq(3, 1)
+centroid.set(tuple(sum(vec[j] for vec in data_set) / len(data_set)
+    for j in range(3)), 0)
+centroid_avge = centroid.test_clustering(data_tset).avg_error()
+
+for method in ("kmeans++", "kmeans||"):
+    seeded = []
+    for threads in (1, 2):
+        rng_seed(7)
+        clustering = lvq(3, 6)
+        clustering.set_from_data(data_tset, method = method, threads = threads)
+        seeded.append([tuple(clustering.get(c)) for c in range(6)])
+
+    # Distinct samples, reproducible regardless of the thread count
+    assert seeded[0] == seeded[1] and len(set(seeded[0])) == 6
+    assert all(seed in data_set for seed in seeded[0])
+
+    seeded_avge = clustering.test_clustering(data_tset).avg_error()
+    assert seeded_avge < centroid_avge
+    clustering.train_unsupervised(data_tset)
+    trained_avge = clustering.test_clustering(data_tset).avg_error()
+
+    print("Seeded by %s, avg. error: %f (trained: %f)" % \
+        (method, seeded_avge, trained_avge))
+
 for cluster in range(6):
     print("Cluster %d avg. error: %f" % (cluster, stats.avg_error(cluster)))